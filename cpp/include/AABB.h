@@ -0,0 +1,50 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+
+#include "Particle.h"
+#include "Vector2.h"
+
+namespace sim {
+    /**
+     * @brief Axis-Aligned Bounding Box (AABB) structure
+     */
+    struct AABB {
+        Vector2 min;
+        Vector2 max;
+    };
+
+    /**
+     * @brief Computes the Axis-Aligned Bounding Box (AABB) for a set of particles.
+     *
+     * The box includes the particle radii.
+     * @param particles The particles to compute the AABB for.
+     * @return AABB The computed AABB.
+     */
+    inline AABB computeAABB(const std::vector<Particle*>& particles) {
+        const double INF = 1e300;
+        AABB aabb;
+        aabb.min = { INF,  INF};
+        aabb.max = {-INF, -INF};
+
+        for (auto& p : particles) {
+            aabb.min.x = std::min(aabb.min.x, p->getPosition().x - p->getRadius());
+            aabb.min.y = std::min(aabb.min.y, p->getPosition().y - p->getRadius());
+            aabb.max.x = std::max(aabb.max.x, p->getPosition().x + p->getRadius());
+            aabb.max.y = std::max(aabb.max.y, p->getPosition().y + p->getRadius());
+        }
+        return aabb;
+    }
+
+    /**
+     * @brief Checks if two AABBs overlap.
+     *
+     * @param a The first AABB.
+     * @param b The second AABB.
+     * @return true If the AABBs overlap.
+     */
+    inline bool aabbOverlap(const AABB& a, const AABB& b) {
+        return !(a.max.x < b.min.x || a.min.x > b.max.x ||
+                 a.max.y < b.min.y || a.min.y > b.max.y);
+    }
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <nlohmann/json.hpp>
 
+#include "ParticleBatch.h"
 #include "WorldCollider.h"
 #include "Vector2.h"
 
@@ -33,6 +34,17 @@ namespace sim {
         InnerCircleCollider(Vector2 center, double radius, double friction = 0.1, double restitution = 0.9);
         
         bool collide(Particle* p, double friction, double restitution) override;
+        bool collideSwept(Particle* p, double friction, double restitution) override;
+        bool mayCollide(const AABB& box) const override;
+        double signedDistance(const Vector2& point) const override;
+        /**
+         * @brief Distance to the circle, also to the center where collide() picks an arbitrary normal.
+         */
+        double clearance(const Vector2& point) const override;
+        /**
+         * @brief Collide every particle of a batch, same result as collide() on each.
+         */
+        void collideBatch(ParticleBatch& batch, double friction, double restitution);
 
         json as_json() override;
     };
@@ -47,6 +59,14 @@ namespace sim {
         OuterCircleCollider(Vector2 center, double radius, double friction = 0.1, double restitution = 0.9);
         
         bool collide(Particle* p, double friction, double restitution) override;
+        bool collideSwept(Particle* p, double friction, double restitution) override;
+        bool mayCollide(const AABB& box) const override;
+        double signedDistance(const Vector2& point) const override;
+        double clearance(const Vector2& point) const override { return signedDistance(point); }
+        /**
+         * @brief Collide every particle of a batch, same result as collide() on each.
+         */
+        void collideBatch(ParticleBatch& batch, double friction, double restitution);
 
         json as_json() override;
     };
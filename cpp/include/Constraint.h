@@ -32,10 +32,27 @@ namespace sim {
          */
         void applyConstraint();
 
+        /**
+         * @brief Enforce a distance constraint between two particles.
+         *
+         * Shared by Constraint objects and by bodies instanced from a
+         * SoftBodyPrototype, which keep their constraints as plain edges.
+         * @param part1 The first particle
+         * @param part2 The second particle
+         * @param restLength Rest length between the two particles
+         * @param stiffness Stiffness of the constraint (0 < stiffness <= 1)
+         * @param damping Damping factor for oscillations (0 <= damping < 1)
+         */
+        static void solve(Particle* part1, Particle* part2, double restLength, double stiffness, double damping);
+
         // --- Accessors & mutators ----
         Vector2 getPart1() { return part1->getPosition(); }
         Vector2 getPart2() { return part2->getPosition(); }
+        Particle* getParticle1() { return part1; }
+        Particle* getParticle2() { return part2; }
+        void setParticles(Particle* p1, Particle* p2) { part1 = p1; part2 = p2; }
         double getRestLength() { return restLength; }
+        void setRestLength(double length) { restLength = length; }
         double getStiffness() { return stiffness; }
         double getDamping() { return damping; }
 
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "SoftBody.h"
+#include "Vector2.h"
+
+namespace sim {
+    /**
+     * @brief Particle pair of two bodies close enough to touch.
+     */
+    struct ContactPair {
+        int a;                      /// Index of the particle in the colliding particles of the first body
+        int b;                      /// Index of the particle in those of the second body
+        double correction = 0.0;    /// Overlap resolved on the pair during the last step
+        int age = 0;                /// Consecutive steps the pair was in contact
+    };
+
+    /**
+     * @brief Contacts between two bodies, kept across steps.
+     *
+     * The pairs are every particle pair closer than the sum of their radii
+     * plus a skin distance when the manifold was built. As long as no particle
+     * of either body moved more than half the skin since then, no other pair
+     * can touch, and the manifold replaces the all-pairs narrowphase.
+     */
+    struct ContactManifold {
+        std::vector<ContactPair> pairs;     /// Candidate pairs, in narrowphase order
+        std::vector<Vector2> anchors;       /// Particle positions of both bodies at build time
+        uint64_t last_step = 0;             /// Step the manifold was last used in
+
+        /**
+         * @brief Whether the pairs still hold every possible contact.
+         * @param first The colliding particles of the first body, its surface or all of them.
+         * @param second Those of the second body.
+         */
+        bool isValid(const std::vector<Particle*>& first, const std::vector<Particle*>& second, double skin) const;
+
+        /**
+         * @brief Find the candidate pairs again, keeping the state of the pairs still present.
+         *
+         * The state is dropped when the particle lists changed size, the
+         * indices then no longer designate the same particles.
+         */
+        void rebuild(const std::vector<Particle*>& first, const std::vector<Particle*>& second, double skin);
+    };
+
+    /**
+     * @brief Persistent contacts between the bodies of a Simulation.
+     *
+     * Manifolds are keyed by body pair, and particles by their index in the
+     * colliding particles of the body, so the cache survives
+     * Simulation::sortParticles(). Manifolds not
+     * used during a step are dropped by endStep().
+     */
+    class ContactCache {
+    public:
+        /**
+         * @brief Manifold of a body pair, created empty (and invalid) on first use.
+         */
+        ContactManifold& manifold(const SoftBody* first, const SoftBody* second);
+
+        /**
+         * @brief Drop the manifolds of body pairs that stopped overlapping.
+         */
+        void endStep();
+
+        void clear() { manifolds.clear(); }
+        size_t size() const { return manifolds.size(); }
+
+    private:
+        struct PairHash {
+            size_t operator()(const std::pair<const SoftBody*, const SoftBody*>& key) const {
+                return std::hash<const void*>()(key.first) * 31 + std::hash<const void*>()(key.second);
+            }
+        };
+
+        std::unordered_map<std::pair<const SoftBody*, const SoftBody*>, ContactManifold, PairHash> manifolds;
+        uint64_t step = 1;  /// Current step, manifolds of older steps are stale
+    };
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <vector>
+
+#include "AABB.h"
+#include "Particle.h"
+
+namespace sim {
+    /**
+     * @brief Bounding volume hierarchy over the outline edges of a soft body.
+     *
+     * Edge i joins the outline particles i and i+1, the last one closes the
+     * ring. Leaves hold runs of consecutive edges, which stay close in space
+     * however the body deforms, so the tree is built once per outline and only
+     * its boxes are recomputed each step by refit().
+     */
+    class EdgeTree {
+    public:
+        /**
+         * @brief Build the tree of an outline and fit it to the current positions.
+         * @param outline The outline particles, in order.
+         */
+        void build(const std::vector<Particle*>& outline);
+
+        /**
+         * @brief Recompute every box and the winding from the current particle positions.
+         * @param outline The outline the tree was built for.
+         */
+        void refit(const std::vector<Particle*>& outline);
+
+        /**
+         * @brief Call visit(index) for every edge whose bounds overlap a box.
+         *
+         * The bounds of an edge include the radii of its end particles.
+         */
+        template <typename F>
+        void forEachOverlap(const AABB& box, F&& visit) const {
+            if (nodes.empty()) return;
+            int stack[64];
+            int top = 0;
+            stack[top++] = 0;
+            while (top > 0) {
+                const Node& node = nodes[stack[--top]];
+                if (!aabbOverlap(node.box, box)) continue;
+                if (node.count > 0) {
+                    for (int i = node.first; i < node.first + node.count; i++)
+                        if (aabbOverlap(boxes[i], box)) visit(i);
+                } else {
+                    int self = (int)(&node - nodes.data());
+                    stack[top++] = node.first;
+                    stack[top++] = self + 1;
+                }
+            }
+        }
+
+        // --- Accessors ----
+        size_t getEdgeCount() const { return boxes.size(); }
+        size_t getNodeCount() const { return nodes.size(); }
+        /// Bounds of the whole outline, only valid when the tree is not empty
+        const AABB& getBounds() const { return nodes[0].box; }
+        bool empty() const { return nodes.empty(); }
+        /// 1 if the outline turns counterclockwise, -1 otherwise, as of the last refit
+        double getWinding() const { return winding; }
+
+    private:
+        /// BVH node, the left child of an inner node directly follows it
+        struct Node {
+            AABB box;       /// Bounds of the edges below the node
+            int first;      /// Leaf: first edge, inner: index of the right child
+            int count;      /// Number of edges of a leaf, 0 for inner nodes
+        };
+
+        int build(int begin, int end);
+
+        std::vector<AABB> boxes;    /// Bounds of each edge
+        std::vector<Node> nodes;    /// BVH nodes, the root first
+        double winding = 1.0;       /// Sign of the outline area
+    };
+}
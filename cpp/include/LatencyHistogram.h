@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sim {
+    /**
+     * @brief HDR-style histogram of durations.
+     *
+     * Values are bucketed log-linearly: every power of two range is split into
+     * SUB_BUCKETS / 2 linear buckets, so any recorded value is known to within
+     * 1/64 (about 1.6%) whatever its magnitude. Recording is O(1) and the memory
+     * footprint is fixed.
+     */
+    class LatencyHistogram {
+    public:
+        static constexpr int SUB_BUCKET_BITS = 7;                       /// Precision of the buckets
+        static constexpr uint64_t SUB_BUCKETS = 1ull << SUB_BUCKET_BITS; /// Buckets below the first power of two range
+
+        LatencyHistogram();
+
+        /**
+         * @brief Add a sample.
+         * @param value Duration to record [ns].
+         */
+        void record(uint64_t value);
+
+        /**
+         * @brief Value below which the given percentage of samples fall.
+         * @param percent Percentile in [0, 100] (e.g. 99.9).
+         * @return Upper bound of the bucket holding the percentile [ns], 0 if empty.
+         */
+        uint64_t percentile(double percent) const;
+
+        /**
+         * @brief Forget every sample.
+         */
+        void reset();
+
+        // --- Accessors ----
+        uint64_t getCount() const { return count; }
+        uint64_t getMin() const { return count ? min : 0; }
+        uint64_t getMax() const { return max; }
+        double getMean() const { return count ? double(sum) / double(count) : 0.0; }
+
+    private:
+        static size_t bucketIndex(uint64_t value);
+        static uint64_t bucketUpperBound(size_t index);
+
+        std::vector<uint64_t> buckets;  /// Number of samples per bucket
+        uint64_t count = 0;             /// Total number of samples
+        uint64_t min = UINT64_MAX;      /// Smallest sample
+        uint64_t max = 0;               /// Largest sample
+        uint64_t sum = 0;               /// Sum of the samples (for the mean)
+    };
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <utility>
+#include <vector>
+
+#include "Vector2.h"
+
+namespace sim {
+    /**
+     * @brief Interior meshing strategies of SoftBody::createFromPolygon.
+     */
+    enum MESH_TYPE {
+        RingMesh,       /// Inward rings following the border
+        LatticeMesh     /// Triangular lattice at mesh_unit spacing clipped by the polygon
+    };
+
+    /**
+     * @brief Result of meshing a polygon, independent of any physical parameter.
+     *
+     * This is what SoftBody::createFromPolygon turns into particles and
+     * constraints, and what the MeshCache stores.
+     */
+    struct MeshData {
+        std::vector<Vector2> points;            /// Rest position of every particle
+        std::vector<std::pair<int,int>> edges;  /// Constraint topology, as indices in points
+        std::vector<int> border;                /// Index in points of each polygon corner
+        std::vector<int> surface;               /// Index in points of every outline particle, in order along the polygon
+    };
+
+    /**
+     * @brief Mesh a polygon into points and edges.
+     *
+     * @param polygon The vertices of the polygon.
+     * @param mesh_unit The distance between interior points.
+     * @param radius The particle radius, also the border sampling distance.
+     * @param mesh_type The interior meshing strategy.
+     * @param reorder Whether to renumber the mesh for memory locality (see reorderMesh).
+     * @return The generated mesh.
+     */
+    MeshData meshPolygon(const std::vector<Vector2>& polygon, int mesh_unit, double radius,
+                         MESH_TYPE mesh_type = RingMesh, bool reorder = false);
+
+    /**
+     * @brief Renumber a mesh for memory locality.
+     *
+     * Points are sorted along a Morton (Z-order) curve, so that particles close
+     * in space are close in memory, and edges are sorted by their first then
+     * second point. The result only depends on the point positions and the
+     * edge set, not on the order the mesher produced them in.
+     *
+     * @param mesh The mesh to renumber in place.
+     * @param cell Quantization step of the curve, typically the mesh unit.
+     */
+    void reorderMesh(MeshData& mesh, double cell);
+}
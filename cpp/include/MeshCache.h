@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Mesh.h"
+#include "Vector2.h"
+
+namespace sim {
+    /**
+     * @brief Cache of meshed polygons, shared by every createFromPolygon call.
+     *
+     * Entries are keyed by a hash of the polygon vertices and the meshing
+     * parameters (mesh_unit, radius, mesh_type, reorder). The parameters are
+     * stored next to the mesh and compared on lookup, so a hash collision is a
+     * miss and never returns a wrong mesh.
+     *
+     * When a directory is set, every new mesh is also written there as a CBOR
+     * file named after its key, and misses of the memory cache are looked up on
+     * disk before meshing again. Scene resets and later runs then skip meshing.
+     *
+     * The cache is disabled by default; all methods are thread safe.
+     */
+    class MeshCache {
+    public:
+        /**
+         * @brief Access the process wide cache.
+         */
+        static MeshCache& instance();
+
+        /**
+         * @brief Hash of a polygon and its meshing parameters.
+         */
+        static uint64_t key(const std::vector<Vector2>& polygon, int mesh_unit, double radius, MESH_TYPE mesh_type, bool reorder = false);
+
+        /**
+         * @brief Mesh a polygon, reusing and filling the cache when it is enabled.
+         * @return The mesh of the polygon, never nullptr.
+         */
+        std::shared_ptr<const MeshData> mesh(const std::vector<Vector2>& polygon, int mesh_unit, double radius, MESH_TYPE mesh_type, bool reorder = false);
+
+        /**
+         * @brief Look up the mesh of a polygon.
+         * @return The cached mesh, or nullptr when it was never stored.
+         */
+        std::shared_ptr<const MeshData> find(const std::vector<Vector2>& polygon, int mesh_unit, double radius, MESH_TYPE mesh_type, bool reorder = false);
+
+        /**
+         * @brief Store the mesh of a polygon, in memory and on disk if a directory is set.
+         */
+        void store(const std::vector<Vector2>& polygon, int mesh_unit, double radius, MESH_TYPE mesh_type, bool reorder,
+                   std::shared_ptr<const MeshData> mesh);
+
+        /**
+         * @brief Drop every entry held in memory, files on disk are kept.
+         */
+        void clear();
+
+        // --- Accessors & mutators ----
+        void setEnabled(bool e) { enabled = e; }
+        bool isEnabled() const { return enabled; }
+
+        /**
+         * @brief Set the directory of the on-disk store, empty to keep meshes in memory only.
+         */
+        void setDirectory(const std::string& path);
+        std::string getDirectory();
+
+        size_t size();
+        uint64_t getHits() const { return hits; }
+        uint64_t getMisses() const { return misses; }
+
+    private:
+        struct Entry {
+            std::vector<Vector2> polygon;           /// Meshed polygon
+            int mesh_unit;                          /// Meshing parameters
+            double radius;
+            MESH_TYPE mesh_type;
+            bool reorder;
+            std::shared_ptr<const MeshData> mesh;   /// Shared with the callers
+        };
+
+        MeshCache() {}
+
+        static bool matches(const Entry& entry, const std::vector<Vector2>& polygon, int mesh_unit, double radius, MESH_TYPE mesh_type, bool reorder);
+        std::string filePath(uint64_t key) const;
+        bool loadFile(uint64_t key, Entry& entry) const;
+        void saveFile(uint64_t key, const Entry& entry) const;
+
+        std::mutex mutex;                                       /// Guards entries and directory
+        std::unordered_map<uint64_t, std::vector<Entry>> entries; /// Entries by key, colliding keys share a slot
+        std::string directory;                                  /// On-disk store, empty if disabled
+        std::atomic<bool> enabled{false};                       /// Whether createFromPolygon uses the cache
+        std::atomic<uint64_t> hits{0};                          /// Lookups that returned a mesh
+        std::atomic<uint64_t> misses{0};                        /// Lookups that did not
+    };
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+namespace sim {
+    /**
+     * @brief Interleave the bits of two 32-bit integers (x in even bits, y in odd bits).
+     *
+     * Sorting points by the code of their quantized coordinates orders them
+     * along a Z-order curve: points close in space end up close in the order.
+     */
+    inline uint64_t mortonCode(uint32_t x, uint32_t y) {
+        auto spread = [](uint64_t v) {
+            v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+            v = (v | (v << 8))  & 0x00FF00FF00FF00FFull;
+            v = (v | (v << 4))  & 0x0F0F0F0F0F0F0F0Full;
+            v = (v | (v << 2))  & 0x3333333333333333ull;
+            v = (v | (v << 1))  & 0x5555555555555555ull;
+            return v;
+        };
+        return spread(x) | (spread(y) << 1);
+    }
+}
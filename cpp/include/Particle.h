@@ -42,6 +42,22 @@ namespace sim {
 
         bool isPinned() const { return pinned; }
 
+        /**
+         * @brief Store a conservative bound on the distance to the world colliders.
+         * @param anchor Position the bound was computed at.
+         * @param c How far the particle can move from the anchor without touching a collider,
+         *          0 when it touches one, negative when unknown.
+         */
+        void setClearance(const Vector2& anchor, double c) { clearance_anchor = anchor; clearance = c; }
+        double getClearance() const { return clearance; }
+        const Vector2& getClearanceAnchor() const { return clearance_anchor; }
+        /**
+         * @brief Whether a position is still within the clearance of the particle.
+         */
+        bool isClear(const Vector2& point) const {
+            return clearance > 0.0 && (point - clearance_anchor).lengthSquared() < clearance * clearance;
+        }
+
         // --- Saver & Loader ----
         json as_json();
         static Vector2 from_json(json data);
@@ -53,5 +69,7 @@ namespace sim {
         double radius;          /// Radius of the particle
         double mass;            /// Mass of the particle
         bool pinned;            /// Whether the particle is pinned (immovable)
+        Vector2 clearance_anchor;   /// Position the clearance was computed at
+        double clearance = -1.0;    /// Free distance around the anchor, negative if unknown
     };
 }
\ No newline at end of file
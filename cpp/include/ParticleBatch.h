@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Particle.h"
+
+namespace sim {
+    /**
+     * @brief Structure-of-arrays copy of the particles of a body.
+     *
+     * Batch collider kernels scan the flat arrays in a first, branch-free pass
+     * that the compiler can vectorize, flag the particles that may collide in
+     * `hit`, then run the scalar response on the flagged particles only.
+     * After a response the kernel refreshes the copy with sync().
+     */
+    struct ParticleBatch {
+        std::vector<Particle*> particles;   /// Particles of the batch
+        std::vector<double> x, y;           /// Positions
+        std::vector<double> radius;         /// Radii
+        std::vector<uint8_t> active;        /// 0 for pinned particles, 1 otherwise
+        std::vector<uint8_t> hit;           /// Scratch mask written by the kernels
+
+        /**
+         * @brief Load the particles of a body, reusing the allocated storage.
+         */
+        void gather(const std::vector<Particle*>& source) {
+            size_t n = source.size();
+            particles.assign(source.begin(), source.end());
+            x.resize(n);
+            y.resize(n);
+            radius.resize(n);
+            active.resize(n);
+            hit.resize(n);
+            for (size_t i = 0; i < n; i++) {
+                const Particle* p = source[i];
+                x[i] = p->getPosition().x;
+                y[i] = p->getPosition().y;
+                radius[i] = p->getRadius();
+                active[i] = p->isPinned() ? 0 : 1;
+            }
+        }
+
+        /**
+         * @brief Reload the position of a particle after it was moved.
+         */
+        void sync(size_t i) {
+            x[i] = particles[i]->getPosition().x;
+            y[i] = particles[i]->getPosition().y;
+        }
+
+        size_t size() const { return particles.size(); }
+    };
+}
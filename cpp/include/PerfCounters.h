@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+
+#include "StepStats.h"
+
+namespace sim {
+    /**
+     * @brief Hardware performance counters of the calling thread (Linux perf_event_open).
+     *
+     * The counters listed in PERF_COUNTER are opened as one group so a single
+     * read() returns all of them. Counters the kernel or the container refuses
+     * are skipped; if none can be opened the object stays closed and read()
+     * reports zeros. On other platforms open() always fails.
+     */
+    class PerfCounters {
+    public:
+        PerfCounters();
+        ~PerfCounters();
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        /**
+         * @brief Open and start the counters for the calling thread.
+         * @return true if at least one counter is running.
+         */
+        bool open();
+        /**
+         * @brief Stop and release the counters.
+         */
+        void close();
+
+        bool isOpen() const { return leader >= 0; }
+        bool isAvailable(PERF_COUNTER counter) const { return fds[counter] >= 0; }
+
+        /**
+         * @brief Read the current value of every counter.
+         * @param values Output, zero for unavailable counters.
+         */
+        void read(uint64_t values[COUNTER_COUNT]) const;
+
+    private:
+        int fds[COUNTER_COUNT];         /// File descriptor of each counter, -1 if unavailable
+        int slot[COUNTER_COUNT];        /// Position of each counter in the group read
+        int leader = -1;                /// Group leader file descriptor
+        int opened = 0;                 /// Number of counters in the group
+    };
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <nlohmann/json.hpp>
 
+#include "ParticleBatch.h"
 #include "WorldCollider.h"
 #include "Vector2.h"
 
@@ -26,6 +27,14 @@ namespace sim {
         ~PlaneCollider();
 
         bool collide(Particle* p, double friction, double restitution) override;
+        bool collideSwept(Particle* p, double friction, double restitution) override;
+        bool mayCollide(const AABB& box) const override;
+        double signedDistance(const Vector2& point) const override;
+        double clearance(const Vector2& point) const override { return signedDistance(point); }
+        /**
+         * @brief Collide every particle of a batch, same result as collide() on each.
+         */
+        void collideBatch(ParticleBatch& batch, double friction, double restitution);
         json as_json() override;
         
         Vector2 getNormal() { return normal; }
@@ -0,0 +1,93 @@
+#pragma once
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "AABB.h"
+#include "WorldCollider.h"
+#include "Vector2.h"
+
+using json = nlohmann::json;
+
+namespace sim {
+    /**
+     * @brief Collider sampling static geometry baked into a signed distance grid.
+     *
+     * The distance to the geometry is stored at the nodes of a regular grid,
+     * positive in free space and negative inside solids, together with its
+     * gradient. A particle is resolved with one bilinear lookup whatever the
+     * number of shapes baked, so a whole level can replace many primitive
+     * colliders. Particles outside the grid are not collided.
+     */
+    class SDFCollider : public WorldCollider {
+    public:
+        /**
+         * @brief Construct a collider from an already baked grid
+         *
+         * @param origin World position of the node (0, 0)
+         * @param cell Distance between two nodes
+         * @param width Number of nodes along x, at least 2
+         * @param height Number of nodes along y, at least 2
+         * @param distances Signed distance of each node, row by row (index = j * width + i)
+         * @param friction Friction coefficient for collisions with the geometry
+         * @param restitution Restitution (bounciness) coefficient for collisions with the geometry
+         */
+        SDFCollider(Vector2 origin, double cell, int width, int height, std::vector<double> distances,
+                    double friction = 0.1, double restitution = 0.9);
+
+        /**
+         * @brief Bake static geometry into a grid
+         *
+         * Solids are the union of the polygons and of the regions the colliders
+         * keep particles out of (see WorldCollider::signedDistance).
+         *
+         * @param bounds Area covered by the grid
+         * @param cell Distance between two nodes, the resolution of the field
+         * @param polygons Solid polygons, in any winding
+         * @param colliders Primitive colliders to merge, they are not owned
+         * @param friction Friction coefficient for collisions with the geometry
+         * @param restitution Restitution (bounciness) coefficient for collisions with the geometry
+         * @return The baked collider, owned by the caller
+         */
+        static SDFCollider* bake(const AABB& bounds, double cell,
+                                 const std::vector<std::vector<Vector2>>& polygons,
+                                 const std::vector<const WorldCollider*>& colliders = {},
+                                 double friction = 0.1, double restitution = 0.9);
+
+        bool collide(Particle* p, double friction, double restitution) override;
+        bool mayCollide(const AABB& box) const override;
+        double signedDistance(const Vector2& point) const override;
+        /**
+         * @brief The sampled distance scaled down by the steepest slope of the bilinear field.
+         */
+        double clearance(const Vector2& point) const override;
+        json as_json() override;
+
+        /**
+         * @brief Bilinear lookup of the distance and of its gradient
+         *
+         * @param point Position to sample, clamped to the grid
+         * @param gradient Receives the interpolated gradient, not normalized
+         * @return The interpolated signed distance
+         */
+        double sample(const Vector2& point, Vector2& gradient) const;
+
+        // --- Accessors ----
+        Vector2 getOrigin() const { return origin; }
+        double getCell() const { return cell; }
+        int getWidth() const { return width; }
+        int getHeight() const { return height; }
+        const std::vector<double>& getDistances() const { return distances; }
+        AABB getBounds() const;
+
+    private:
+        void computeGradients();
+
+        Vector2 origin;                     /// World position of the node (0, 0)
+        double cell;                        /// Distance between two nodes
+        int width;                          /// Number of nodes along x
+        int height;                         /// Number of nodes along y
+        std::vector<double> distances;      /// Signed distance of each node
+        std::vector<Vector2> gradients;     /// Gradient of the distance at each node
+        double slope = 1.0;                 /// Bound on the gradient length of the field, at least 1
+    };
+}
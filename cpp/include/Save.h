@@ -3,6 +3,7 @@
 #include <nlohmann/json.hpp>
 
 #include "Simulation.h"
+#include "Trace.h"
 
 using json = nlohmann::json;
 
@@ -16,10 +17,12 @@ namespace sim {
      * @param file_path Path to the file where the simulation state will be saved.
      */
     static void saveSimulation(Simulation* simulation, std::string file_path) {
+        TraceScope trace("saveSimulation", "io");
         std::cout << "Save simulation to " << file_path << "\n";
         std::ofstream file(file_path);
         if (file.is_open()) {
             json data = simulation->as_json();
+            file << data;
             file.close();
         } else {
             std::cerr << "Error: " << file_path << " is not valid!\n";
@@ -31,6 +34,7 @@ namespace sim {
      * @param file_path Path to the file from which the simulation state will be loaded.
      */
     static void loadSimulation(Simulation* simulation, std::string file_path) {
+        TraceScope trace("loadSimulation", "io");
         std::cout << "Load simulation from " << file_path << "\n";
         std::ifstream file(file_path);
         if (file.is_open()) {
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "AABB.h"
+#include "ParticleBatch.h"
+#include "WorldCollider.h"
+#include "Vector2.h"
+
+using json = nlohmann::json;
+
+namespace sim {
+    /**
+     * @brief Static line segment of a SegmentMeshCollider.
+     */
+    struct Segment {
+        Vector2 a;  /// First end point
+        Vector2 b;  /// Second end point
+    };
+
+    /**
+     * @brief Collider made of static line segments, such as terrain outlines.
+     *
+     * Segments are two-sided walls: a particle is pushed back to one radius
+     * from the closest point of every segment it touches, on the side it is
+     * on. They are held in a bounding volume hierarchy, so a query only visits
+     * the segments near the particle, and collideBatch() traverses the tree
+     * once for the bounds of a whole body before testing its particles.
+     */
+    class SegmentMeshCollider : public WorldCollider {
+    public:
+        /**
+         * @brief Construct a new Segment Mesh Collider object
+         *
+         * @param segments The segments, copied and indexed in a BVH
+         * @param friction Friction coefficient for collisions with the segments
+         * @param restitution Restitution (bounciness) coefficient for collisions with the segments
+         */
+        SegmentMeshCollider(std::vector<Segment> segments, double friction = 0.1, double restitution = 0.9);
+
+        /**
+         * @brief Build the segments of a polyline
+         *
+         * @param points The vertices of the polyline
+         * @param closed Whether the last vertex connects back to the first
+         */
+        static std::vector<Segment> polyline(const std::vector<Vector2>& points, bool closed = false);
+
+        bool collide(Particle* p, double friction, double restitution) override;
+        bool collideSwept(Particle* p, double friction, double restitution) override;
+        bool mayCollide(const AABB& box) const override;
+        /**
+         * @brief Distance to the closest segment, found by a pruned traversal of the tree.
+         */
+        double clearance(const Vector2& point) const override;
+        /**
+         * @brief Collide every particle of a batch, same result as collide() on each.
+         */
+        void collideBatch(ParticleBatch& batch, double friction, double restitution);
+
+        /**
+         * @brief Collect the segments whose bounds overlap a box
+         *
+         * @param box The query box
+         * @param out Receives the segment indices, it is not cleared
+         */
+        void query(const AABB& box, std::vector<int>& out) const;
+
+        // --- Accessors ----
+        const std::vector<Segment>& getSegments() const { return segments; }
+        size_t getNodeCount() const { return nodes.size(); }
+
+        // --- Saver & Loader ----
+        json as_json() override;
+        /**
+         * @brief Compact binary form, the JSON of as_json() encoded as CBOR.
+         */
+        std::vector<uint8_t> to_cbor();
+        static SegmentMeshCollider* from_cbor(const std::vector<uint8_t>& bytes);
+
+    private:
+        /// BVH node, the left child of an inner node directly follows it
+        struct Node {
+            AABB box;       /// Bounds of the segments below the node
+            int first;      /// Leaf: first index in order, inner: index of the right child
+            int count;      /// Number of segments of a leaf, 0 for inner nodes
+        };
+
+        int build(int begin, int end);
+        bool resolve(Particle* p, const Segment& s, double friction, double restitution);
+
+        /**
+         * @brief Call visit(index) for every segment whose bounds overlap a box.
+         */
+        template <typename F>
+        void forEachOverlap(const AABB& box, F&& visit) const {
+            if (nodes.empty()) return;
+            int stack[64];
+            int top = 0;
+            stack[top++] = 0;
+            while (top > 0) {
+                const Node& node = nodes[stack[--top]];
+                if (!aabbOverlap(node.box, box)) continue;
+                if (node.count > 0) {
+                    for (int i = node.first; i < node.first + node.count; i++)
+                        if (aabbOverlap(boxes[order[i]], box)) visit(order[i]);
+                } else {
+                    int self = (int)(&node - nodes.data());
+                    stack[top++] = node.first;
+                    stack[top++] = self + 1;
+                }
+            }
+        }
+
+        std::vector<Segment> segments;  /// Segments in input order
+        std::vector<AABB> boxes;        /// Bounds of each segment
+        std::vector<int> order;         /// Segment indices, grouped by leaf
+        std::vector<Node> nodes;        /// BVH nodes, the root first
+    };
+}
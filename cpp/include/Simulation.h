@@ -1,8 +1,24 @@
 #pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
 #include <vector>
 #include <nlohmann/json.hpp>
 
+#include "AABB.h"
+#include "CircleWorldCollider.h"
+#include "ContactCache.h"
+#include "EdgeTree.h"
+#include "LatencyHistogram.h"
+#include "ParticleBatch.h"
+#include "PerfCounters.h"
+#include "PlaneWorldCollider.h"
+#include "SegmentWorldCollider.h"
 #include "SoftBody.h"
+#include "SphereTree.h"
+#include "StepStats.h"
+#include "ThreadPool.h"
 #include "Vector2.h"
 #include "WorldCollider.h"
 
@@ -18,10 +34,14 @@ namespace sim {
      * - Collision detection & response
      *
      * Simulation step order:
+     * 0. Re-sort the particle storage (every setSortInterval() steps)
      * 1. Apply global forces (gravity)
      * 2. Solve constraints iteratively
      * 3. Resolve collisions
      * 4. Integrate particle positions
+     *
+     * Each phase is timed into the step statistics (see getStats()) and
+     * recorded as a trace event when the TraceRecorder is enabled.
      */
     class Simulation {
     public:
@@ -41,6 +61,11 @@ namespace sim {
 
         /**
          * @brief Adds a world collider to the simulation.
+         *
+         * Built-in colliders (exactly PlaneCollider, InnerCircleCollider,
+         * OuterCircleCollider or SegmentMeshCollider) are also filed by type
+         * and collided a body at a time through their batch kernels; other
+         * colliders go through the virtual collide() per particle.
          * @param col Pointer to the WorldCollider to add.
          */
         void addCollider(WorldCollider* col);
@@ -50,11 +75,172 @@ namespace sim {
          */
         void clear();
 
+        /**
+         * @brief Move every particle into one array sorted along a Z-order curve.
+         *
+         * Particles close in space, whatever their body, end up close in memory.
+         * Bodies keep their particle order and their constraints stay valid, only
+         * the particle addresses change: any Particle* kept outside the
+         * simulation is invalidated. The array is owned by the simulation.
+         */
+        void sortParticles();
+
         // --- Accessors & mutators ----
-        std::vector<SoftBody*> getBodies() { return bodies; }
+        /// Bodies in the order they were added
+        const std::vector<SoftBody*>& getBodies() const { return bodies; }
         std::vector<WorldCollider*> getColliders() { return colliders; }
         void setGravity(const Vector2 gravity) { this->gravity = gravity; }
         Vector2 getGravity() { return gravity; }
+        const StepStats& getStats() const { return stats; }
+
+        /**
+         * @brief Sample hardware counters around each step phase.
+         *
+         * Counters are opened lazily for the thread that runs step(). When the
+         * kernel refuses them (e.g. inside a container) the counter values stay
+         * at zero and StepStats::counters_available reports which ones work.
+         * @param enable Whether counters should be sampled.
+         */
+        void setPerfCounters(bool enable);
+        bool getPerfCounters() const { return perf_enabled; }
+
+        /**
+         * @brief Distribution of step() durations since the last reset [ns].
+         */
+        const LatencyHistogram& getStepHistogram() const { return step_histogram; }
+        void resetStepHistogram() { step_histogram.reset(); worst_spike_ms = 0.0; }
+
+        /**
+         * @brief Dump the pre-step state when a step is slower than a threshold.
+         *
+         * The state of every particle is copied before each step. When the step
+         * exceeds the threshold and is the slowest seen so far, the scene, the
+         * copied state and dt are written to file_path. Loading that file with
+         * loadSimulation() and calling step(data["dt"]) replays the offending step.
+         *
+         * @param threshold_ms Step duration triggering a capture, <= 0 disables it.
+         * @param file_path JSON file receiving the snapshot.
+         */
+        void setSpikeCapture(double threshold_ms, const std::string& file_path);
+        double getSpikeThreshold() const { return spike_threshold_ms; }
+
+        /**
+         * @brief Re-sort the particle storage every n steps (see sortParticles()).
+         * @param n Steps between two sorts, 0 disables the periodic sort.
+         */
+        void setSortInterval(int n) { sort_interval = n; steps_since_sort = 0; }
+        int getSortInterval() const { return sort_interval; }
+
+        /**
+         * @brief Sweep particles against the world colliders (see WorldCollider::collideSwept()).
+         *
+         * The first world collision pass then tests the whole motion of each
+         * particle during the last step, so fast particles no longer tunnel
+         * through thin colliders and larger time steps can be used. That pass
+         * goes through one virtual call per particle and collider.
+         */
+        void setContinuousCollisions(bool enable) { continuous_collisions = enable; }
+        bool getContinuousCollisions() const { return continuous_collisions; }
+
+        /**
+         * @brief Skip the world tests of particles far from every collider.
+         *
+         * Each particle keeps a conservative bound on its distance to the
+         * colliders (see WorldCollider::clearance()), computed where it was
+         * last tested. Until it moved farther than that bound, a particle
+         * cannot touch any collider and the world passes skip it. Results are
+         * unchanged, only colliders without a bound are then always tested.
+         */
+        void setWorldClearance(bool enable);
+        bool getWorldClearance() const { return world_clearance; }
+
+        /**
+         * @brief Only collide the outline particles of meshed bodies (see SoftBody::getSurface()).
+         *
+         * Interior particles are enclosed by the outline, other bodies and the
+         * colliders reach the surface first. A body that folded over itself
+         * collides all its particles until its surface encloses them again
+         * (see SoftBody::surfaceEncloses()). Enabled by default.
+         */
+        void setSurfaceCollisions(bool enable) { surface_collisions = enable; contacts.clear(); }
+        bool getSurfaceCollisions() const { return surface_collisions; }
+
+        /**
+         * @brief Descend a bounding sphere hierarchy of each body before testing particle pairs.
+         *
+         * Each body keeps a SphereTree over clusters of its colliding
+         * particles, built the first time it collides and refitted every step.
+         * Body pairs whose boxes overlap then only test the particles of
+         * clusters whose spheres overlap, instead of every particle pair.
+         * Applies to the particle contacts, with or without the contact
+         * pipeline; the contact cache rebuilds its manifolds on its own.
+         */
+        void setSphereTrees(bool enable) { sphere_trees = enable; }
+        bool getSphereTrees() const { return sphere_trees; }
+
+        /**
+         * @brief Collide particles against the outline edges of other bodies.
+         *
+         * Replaces the particle against particle test between bodies: the
+         * colliding particles of each body are tested against the outline
+         * edges of the other (see SoftBody::hasOutline()), found through an
+         * EdgeTree per body refitted every step. An outline then no longer has
+         * to be sampled every particle radius to stay closed, so bodies meshed
+         * with a sparse outline keep the same contact quality with fewer
+         * particles. Pairs where neither body has an outline, or whose outline
+         * folded, still collide particle against particle. Takes precedence
+         * over the contact cache and the contact pipeline.
+         */
+        void setEdgeContacts(bool enable) { edge_contacts = enable; }
+        bool getEdgeContacts() const { return edge_contacts; }
+
+        /**
+         * @brief Keep the contacts between bodies across steps (see ContactCache).
+         *
+         * Touching body pairs then only run the all-pairs narrowphase again
+         * when a particle moved more than half the skin distance, and resting
+         * contacts are warm started with part of their last correction.
+         */
+        void setContactCache(bool enable) { contact_cache = enable; contacts.clear(); }
+        bool getContactCache() const { return contact_cache; }
+        /**
+         * @brief Margin added to the particle radii when building contact manifolds.
+         */
+        void setContactSkin(double skin) { contact_skin = skin; contacts.clear(); }
+        double getContactSkin() const { return contact_skin; }
+        /**
+         * @brief Fraction of last step's correction re-applied to resting contacts, 0 disables it.
+         */
+        void setWarmStart(double factor) { warm_start = factor; }
+        double getWarmStart() const { return warm_start; }
+
+        /**
+         * @brief Split body collisions into detection, coloring and resolution.
+         *
+         * Contacts are first found from the positions at the start of the
+         * phase, then colored so that no two contacts of a color share a
+         * particle, and resolved color by color. Detection and each color run
+         * in parallel on the threads set by setThreadCount(); the result does
+         * not depend on the number of threads. Each stage is timed in the
+         * step statistics.
+         */
+        void setContactPipeline(bool enable) { contact_pipeline = enable; }
+        bool getContactPipeline() const { return contact_pipeline; }
+
+        /**
+         * @brief Number of threads used by the parallel stages, the caller included.
+         * @param n Thread count, 1 or less runs everything on the calling thread.
+         */
+        void setThreadCount(int n);
+        int getThreadCount() const { return pool ? pool->size() : 1; }
+
+        /**
+         * @brief Speed of the center below which a body counts as resting in the step statistics.
+         *
+         * Only used to fill StepStats::resting_bodies, resting bodies are still simulated.
+         */
+        void setRestSpeed(double speed) { rest_speed = speed; }
+        double getRestSpeed() const { return rest_speed; }
 
         // --- Saver & Loader ----
         json as_json();
@@ -64,6 +250,74 @@ namespace sim {
         std::vector<SoftBody*> bodies;          /// Soft bodies in the simulation
         Vector2 gravity = Vector2();            /// Global gravity vector
         std::vector<WorldCollider*> colliders;  /// World colliders in the simulation
+        std::vector<PlaneCollider*> planes;                 /// Built-in colliders by type, batch path
+        std::vector<InnerCircleCollider*> inner_circles;
+        std::vector<OuterCircleCollider*> outer_circles;
+        std::vector<SegmentMeshCollider*> segment_meshes;
+        std::vector<WorldCollider*> other_colliders;        /// Colliders going through collide()
+        ParticleBatch batch;                    /// Scratch copy of the body being collided
+        StepStats stats;                        /// Timings and counters of the last step
+        double rest_speed = 0.1;                /// Speed of a resting body, for the statistics
+        std::vector<Vector2> rest_centers;      /// Center of each body after the last step
+        PerfCounters counters;                  /// Hardware counters of the stepping thread
+        bool perf_enabled = false;              /// Whether hardware counters are sampled
+        std::thread::id perf_thread;            /// Thread the counters were opened for
+
+        LatencyHistogram step_histogram;        /// Durations of the steps [ns]
+        double spike_threshold_ms = 0.0;        /// Step duration triggering a snapshot, disabled if <= 0
+        std::string spike_file;                 /// Destination of the spike snapshot
+        double worst_spike_ms = 0.0;            /// Duration of the step saved in the snapshot
+        std::vector<double> spike_state;        /// Particle state before the current step
+
+        std::vector<Particle> particle_store;   /// Sorted particles of every body, see sortParticles()
+        int sort_interval = 0;                  /// Steps between two sorts, 0 if disabled
+        int steps_since_sort = 0;               /// Steps since the last periodic sort
+        bool continuous_collisions = false;     /// Whether the first world pass is swept
+        bool world_clearance = false;           /// Whether clear particles skip the world passes
+        bool surface_collisions = true;         /// Whether only the surface of bodies collides
+        std::vector<const std::vector<Particle*>*> colliding; /// Colliding particles of each body during the step
+        std::vector<Particle*> near_particles;  /// Particles of the body being collided that need testing
+        std::vector<WorldCollider*> near_colliders; /// Colliders the body may touch, bounded first
+        std::vector<WorldCollider*> far_colliders;  /// Colliders it cannot touch
+
+        bool sphere_trees = false;              /// Whether body pairs descend sphere hierarchies
+        std::vector<SphereTree> body_spheres;   /// Cluster hierarchy of each body, over its colliding particles
+        bool edge_contacts = false;             /// Whether bodies collide against outline edges
+        std::vector<EdgeTree> edge_trees;       /// Outline edges of each body, empty if it has none
+
+        ContactCache contacts;                  /// Contacts between bodies, kept across steps
+        bool contact_cache = false;             /// Whether body collisions use the contact cache
+        double contact_skin = 0.5;              /// Margin of the contact manifolds
+        double warm_start = 0.5;                /// Fraction of the last correction re-applied
+        std::vector<double> warm_scratch;       /// Warm start applied to each pair of a manifold
+
+        /// Overlapping body pair of the contact pipeline
+        struct BodyPair {
+            int first, second;                  /// Indices in bodies
+            double mu, restitution;             /// Combined coefficients
+            ContactManifold* manifold;          /// Cached contacts, nullptr without the contact cache
+            bool rebuilt;                       /// Whether the manifold was rebuilt this step
+        };
+        /// Particle pair found by the detection stage
+        struct BodyContact {
+            Particle* a;                        /// Particle of the first body
+            Particle* b;                        /// Particle of the second body
+            uint32_t ia, ib;                    /// Indices over the colliding particles of all bodies, for coloring
+            uint32_t pair;                      /// Index in body_pairs
+            ContactPair* cached;                /// State in the contact cache, or nullptr
+        };
+        bool contact_pipeline = false;                      /// Whether body collisions use the pipeline
+        std::unique_ptr<ThreadPool> pool;                   /// Workers of the parallel stages, nullptr if serial
+        std::vector<BodyPair> body_pairs;                   /// Pipeline scratch buffers, kept across steps
+        std::vector<std::vector<BodyContact>> contact_buffers;
+        std::vector<BodyContact> body_contacts;
+        std::vector<uint64_t> color_masks;
+        std::vector<uint32_t> color_order;
+
+        bool inStore(const Particle* p) const;
+
+        void captureState();
+        void saveSpike(double dt, double step_ms);
 
         // main steps
         void applyGravity();
@@ -71,6 +325,23 @@ namespace sim {
         void applyConstraints();
         void resolveCollisions(double dt);
         void collisionsWorld();
+        void collisionsWorldSwept();
+        void selectColliding();
+        const std::vector<Particle*>& nearParticles(const std::vector<Particle*>& particles, bool swept);
+        void updateClearance(const std::vector<Particle*>& particles);
+        void sortCollider(WorldCollider* collider, bool near);
+        bool inMask(WorldCollider* collider, uint32_t layer);
+        void resetClearance();
         void collisionsBodies(double dt);
+        void updateSphereTrees();
+        void collideParticles(int i, int j, double mu, double restitution, double dt);
+        void collideCached(SoftBody* obj1, SoftBody* obj2,
+                           const std::vector<Particle*>& p1, const std::vector<Particle*>& p2,
+                           double mu, double restitution, double dt);
+        void collisionsBodiesPipeline(double dt);
+        void collisionsBodiesEdges(double dt);
+        void collideEdges(const std::vector<Particle*>& particles, const std::vector<Particle*>& outline,
+                          const EdgeTree& tree, double mu, double restitution, double dt);
+        void runParallel(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn);
     };
 }
\ No newline at end of file
@@ -0,0 +1,133 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Simulation.h"
+#include "StepStats.h"
+#include "Vector2.h"
+
+namespace sim {
+    /**
+     * @brief Copy of the simulation state needed to draw one frame.
+     *
+     * Bodies follow the order of Simulation::getBodies(), the offset arrays
+     * hold the start of each body in the flat arrays plus their total size.
+     */
+    struct SimulationSnapshot {
+        uint64_t step = 0;                      /// Steps completed when the snapshot was taken
+        StepStats stats;                        /// Statistics of the last of these steps
+        std::vector<Vector2> borders;           /// Border positions of every body
+        std::vector<size_t> border_offsets;     /// Start of each body in borders
+
+        // Only captured with detail
+        std::vector<double> border_radii;       /// Radius of each border particle
+        std::vector<Vector2> particles;         /// Positions of every particle
+        std::vector<double> radii;              /// Radius of each particle
+        std::vector<size_t> particle_offsets;   /// Start of each body in particles
+        std::vector<Vector2> lines;             /// Constraint and prototype edge end points, two per line
+
+        /**
+         * @brief Overwrite the snapshot with the current state, reusing its storage.
+         * @param simulation The simulation to copy.
+         * @param detail Also copy every particle and constraint, for debug drawing.
+         */
+        void capture(Simulation& simulation, bool detail);
+    };
+
+    /**
+     * @brief Steps a simulation on a dedicated thread.
+     *
+     * request() queues a step and returns at once, the worker runs queued
+     * steps in order and publishes a snapshot after each one. Snapshots go
+     * through a triple buffer: the worker always has a slot to write, the
+     * reader always has a complete one, and latest() swaps in the newest
+     * without locking. While the worker exists, only it may touch the
+     * simulation; call wait() first to change it from another thread.
+     */
+    class SimulationWorker {
+    public:
+        /**
+         * @brief Start the worker and take a first snapshot.
+         * @param simulation The simulation to step, must outlive the worker.
+         */
+        explicit SimulationWorker(Simulation& simulation);
+        ~SimulationWorker();
+
+        SimulationWorker(const SimulationWorker&) = delete;
+        SimulationWorker& operator=(const SimulationWorker&) = delete;
+
+        /**
+         * @brief Queue a step, without waiting for it.
+         *
+         * The request is dropped when getMaxLag() steps are already queued,
+         * so a simulation slower than real time falls behind by a bounded
+         * number of frames instead of an ever growing one.
+         * @return Whether the step was queued.
+         */
+        bool request(double dt);
+
+        /**
+         * @brief The most recent snapshot, for the reader thread only.
+         *
+         * The reference stays valid until the next call.
+         */
+        const SimulationSnapshot& latest();
+
+        /**
+         * @brief Block until every queued step is done and published.
+         */
+        void wait();
+
+        /**
+         * @brief Fraction of the time the worker spent stepping since the previous call.
+         *
+         * For a single reader, e.g. a profiler polling once per frame.
+         * @return The busy time over the elapsed time, in [0, 1].
+         */
+        double takeUtilization();
+
+        // --- Accessors & mutators ----
+        /// Steps queued but not completed yet: how many frames the simulation is behind
+        uint64_t getLag() const { return requested.load() - completed.load(); }
+        uint64_t getCompleted() const { return completed.load(); }
+        uint64_t getDropped() const { return dropped.load(); }
+        void setMaxLag(int steps) { max_lag = steps < 1 ? 1 : steps; }
+        int getMaxLag() const { return max_lag; }
+        /// Capture particles and constraints in the snapshots, from the next step on
+        void setDetail(bool enabled) { detail = enabled; }
+        bool getDetail() const { return detail; }
+
+    private:
+        void run();
+        void publish();
+
+        static constexpr int FRESH = 4;         /// Flag of the spare slot index, set when it holds a new snapshot
+
+        Simulation& simulation;
+        std::thread thread;
+        std::mutex mutex;                       /// Guards the queue and stopping
+        std::condition_variable wake;           /// Signals a request or the shutdown
+        std::condition_variable idle;           /// Signals an empty queue
+        std::deque<double> queue;               /// Time steps of the queued steps
+        bool stopping = false;
+        std::atomic<uint64_t> requested{0};     /// Steps queued since the start
+        std::atomic<uint64_t> completed{0};     /// Steps done and published since the start
+        std::atomic<uint64_t> dropped{0};       /// Requests refused because of the lag
+        std::atomic<int> max_lag{2};
+        std::atomic<bool> detail{false};
+        std::atomic<uint64_t> busy_ns{0};       /// Time spent stepping and publishing since the start
+        uint64_t polled_busy_ns = 0;            /// busy_ns at the previous takeUtilization()
+        std::chrono::steady_clock::time_point polled_at;
+
+        SimulationSnapshot slots[3];            /// Triple buffer
+        int back = 0;                           /// Slot written by the worker
+        std::atomic<int> spare{1};              /// Slot exchanged between both sides, with FRESH
+        int front = 2;                          /// Slot read by the reader
+    };
+}
@@ -1,9 +1,13 @@
 #pragma once
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <nlohmann/json.hpp>
 
 #include "Particle.h"
 #include "Constraint.h"
+#include "Mesh.h"
+#include "SoftBodyPrototype.h"
 #include "Vector2.h"
 
 using json = nlohmann::json;
@@ -22,6 +26,8 @@ namespace sim {
          * @brief Creates a SoftBody from a polygon by generating a mesh of particles and constraints.
          * 
          * The polygon is meshed into particles and constraints forming a deformable body.
+         * When the MeshCache is enabled, a polygon already meshed with the same
+         * mesh_unit, radius and mesh_type reuses the cached mesh.
          * 
          * @param polygon The vertices of the polygon defining the soft body's shape.
          * @param mesh_unit The distance between particles in the mesh.
@@ -32,6 +38,8 @@ namespace sim {
          * @param friction The friction coefficient of the soft body.
          * @param restitution The restitution (bounciness) coefficient of the soft body.
          * @param is_pinned Whether the border particles should be pinned (immovable).
+         * @param mesh_type The interior meshing strategy.
+         * @param reorder Whether to renumber particles and constraints for memory locality.
          * @return SoftBody* A pointer to the newly created SoftBody instance.
          */
         static SoftBody* createFromPolygon(
@@ -43,7 +51,49 @@ namespace sim {
             double damping = 0.1,
             double friction = 0.1,
             double restitution = 0.9,
-            bool is_pinned = false
+            bool is_pinned = false,
+            MESH_TYPE mesh_type = RingMesh,
+            bool reorder = false
+        );
+
+        /**
+         * @brief Creates a SoftBody from an already generated mesh.
+         * 
+         * One particle is created per mesh point and one constraint per mesh edge.
+         * The parameters are the same as createFromPolygon.
+         * 
+         * @param mesh The mesh to instantiate.
+         * @return SoftBody* A pointer to the newly created SoftBody instance.
+         */
+        static SoftBody* createFromMesh(
+            const MeshData& mesh,
+            int mesh_unit = 10,
+            double mass = 1,
+            double radius = 1,
+            double stiffness = 0.8,
+            double damping = 0.1,
+            double friction = 0.1,
+            double restitution = 0.9,
+            bool is_pinned = false,
+            MESH_TYPE mesh_type = RingMesh
+        );
+
+        /**
+         * @brief Creates a SoftBody sharing the rest topology of a prototype.
+         * 
+         * Only the particles are allocated, placed at the prototype rest positions
+         * rotated then translated. Constraints are solved from the prototype edges,
+         * so getConstraints() is empty for instanced bodies.
+         * 
+         * @param prototype The shared rest shape.
+         * @param translation Position of the prototype origin.
+         * @param rotation Rotation around the prototype origin [rad].
+         * @return SoftBody* A pointer to the newly created SoftBody instance.
+         */
+        static SoftBody* instantiate(
+            std::shared_ptr<const SoftBodyPrototype> prototype,
+            const Vector2& translation = Vector2(),
+            double rotation = 0
         );
 
         SoftBody(
@@ -79,24 +129,115 @@ namespace sim {
          */
         void update(double dt);
 
+        /**
+         * @brief Replace every particle pointer held by the body.
+         *
+         * Used when the particles are moved in memory: the particle order of
+         * the body is kept, only the addresses change.
+         * @param remap Callable returning the new address of a particle.
+         */
+        template <typename F>
+        void remapParticles(F remap) {
+            for (auto& p : particles) p = remap(p);
+            for (auto& p : border) p = remap(p);
+            for (auto& p : surface) p = remap(p);
+            for (auto& p : interior) p = remap(p);
+            for (auto c : constraints)
+                c->setParticles(remap(c->getParticle1()), remap(c->getParticle2()));
+        }
+
         // --- Accessors & mutators ----
-        std::vector<Particle*> getParticles() { return particles; }
-        std::vector<Particle*> getBorder() { return border; }
-        std::vector<Constraint*> getConstraints() { return constraints; }
+        const std::vector<Particle*>& getParticles() const { return particles; }
+        const std::vector<Particle*>& getBorder() const { return border; }
+        /// Outline particles in order along the polygon, every particle for bodies built by hand
+        const std::vector<Particle*>& getSurface() const { return surface; }
+        /// Whether the surface is a closed ring, each particle joined to the next by an outline edge
+        bool hasOutline() const { return outline; }
+        const std::vector<Constraint*>& getConstraints() const { return constraints; }
         double getFriction() { return friction; }
         double getRestitution() { return restitution; }
+        void setFriction(double f) { friction = f; }
+        void setRestitution(double r) { restitution = r; }
+        MESH_TYPE getMeshType() { return mesh_type; }
+        /// Layers the body is in, one per bit
+        void setCollisionLayer(uint32_t layer) { collision_layer = layer; }
+        uint32_t getCollisionLayer() const { return collision_layer; }
+        /// Layers of the bodies it collides with
+        void setCollisionMask(uint32_t mask) { collision_mask = mask; }
+        uint32_t getCollisionMask() const { return collision_mask; }
+        /// Whether two bodies collide: each one is in a layer of the other's mask
+        bool collidesWith(const SoftBody* other) const {
+            return (collision_layer & other->collision_mask) && (other->collision_layer & collision_mask);
+        }
+        bool isReordered() { return reordered; }
+        /// Shared rest shape, nullptr unless the body was instanced
+        std::shared_ptr<const SoftBodyPrototype> getPrototype() { return prototype; }
+        Vector2 getTranslation() { return translation; }
+        double getRotation() { return rotation; }
+
+        /**
+         * @brief Whether the surface still encloses the other particles.
+         *
+         * Interior particles outside the outline polygon (or outside the bounds
+         * of the surface when it is not an ordered ring) mean the body folded
+         * over itself: they may then touch other bodies or colliders.
+         */
+        bool surfaceEncloses() const;
+
+        /**
+         * @brief Mean position of the particles.
+         */
+        Vector2 getCenter() const;
 
         // --- Saver & Loader ----
+        /**
+         * @brief Serialize the body definition.
+         *
+         * Meshed bodies store their rest polygon and meshing parameters, instanced
+         * bodies their prototype and transform, other bodies store their
+         * particles and constraints explicitly.
+         */
         json as_json();
         static SoftBody* from_json(json data);
 
+        /**
+         * @brief Serialize the dynamic state (position and previous position of every particle).
+         * @return A flat array [x, y, prev_x, prev_y, ...] in particle order.
+         */
+        json state_as_json();
+        /**
+         * @brief Restore a dynamic state saved with state_as_json().
+         * @param data The saved state.
+         * @return false if the state does not match the particle count.
+         */
+        bool state_from_json(const json& data);
+
     protected:
+        /**
+         * @brief Use the given particles, in order, as the outline ring of the body.
+         * @param ring Index of each outline particle.
+         */
+        void setOutline(const std::vector<int>& ring);
+
         std::vector<Particle*> particles;       /// Particles making up the soft body
         std::vector<Particle*> border;          /// Border particles of the soft body
+        std::vector<Particle*> surface;         /// Outline particles, the ones collisions test
+        bool outline = false;                   /// Whether surface is an ordered outline ring
+        std::vector<Particle*> interior;        /// Particles off the outline ring, empty without one
+        mutable std::vector<int> band_start;    /// Start of each height band in band_edges, for surfaceEncloses()
+        mutable std::vector<int> band_edges;    /// Outline edges overlapping each height band
+        std::vector<Vector2> rest_border;       /// Border positions at creation (mesh source polygon)
         std::vector<Constraint*> constraints;   /// Constraints connecting the particles
         double friction;                        /// Friction coefficient of the soft body [smooth 0 < 1 rough]
         double restitution;                     /// Restitution (bounciness) coefficient of the soft body [sticky 0 < 1 reflect]
         int mesh_unit;                          /// Distance between particles in the mesh
+        MESH_TYPE mesh_type = RingMesh;         /// Meshing strategy used by createFromPolygon
+        uint32_t collision_layer = 1;           /// Layers the body is in
+        uint32_t collision_mask = 1;            /// Layers of the bodies it collides with
+        bool reordered = false;                 /// Whether the mesh was renumbered for locality
+        std::shared_ptr<const SoftBodyPrototype> prototype; /// Shared rest shape of instanced bodies
+        Vector2 translation;                    /// Placement of the prototype
+        double rotation = 0;                    /// Rotation of the prototype [rad]
     };
     
 
@@ -132,4 +273,42 @@ namespace sim {
         }
         return out;
     }
+
+    // ---------------------------------------------------------------------------
+    // Polygon point-in-test (convex or concave): even-odd rule
+    // ---------------------------------------------------------------------------
+
+    /**
+     * @brief Check if edge ab crosses the horizontal ray going left of p
+     * 
+     * Half-open in y so a vertex shared by two edges is counted once.
+     */
+    inline bool crossesLeftOf(const Vector2& p, const Vector2& a, const Vector2& b) {
+        return (a.y <= p.y) != (b.y <= p.y) && a.x + (p.y - a.y) * (b.x - a.x) / (b.y - a.y) <= p.x;
+    }
+
+    /**
+     * @brief Check if point p is inside the polygon defined by poly vertices
+     * 
+     * Counts the edges crossed by the horizontal ray going left of p, with the
+     * same rule as the scanlines of the lattice mesher.
+     * 
+     * @param p The point to test
+     * @param poly The vertices of the polygon (convex or concave)
+     * @param position Callable returning the position of a vertex
+     * @return True if point is inside the polygon, false otherwise
+     */
+    template <typename Vertex, typename Position>
+    bool pointInPolygon(const Vector2& p, const std::vector<Vertex>& poly, Position position) {
+        size_t n = poly.size();
+        if (n < 3) return false;
+        bool inside = false;
+        for (size_t i = 0, j = n - 1; i < n; j = i++)
+            if (crossesLeftOf(p, position(poly[i]), position(poly[j]))) inside = !inside;
+        return inside;
+    }
+
+    inline bool pointInPolygon(const Vector2& p, const std::vector<Vector2>& poly) {
+        return pointInPolygon(p, poly, [](const Vector2& v) -> const Vector2& { return v; });
+    }
 }
\ No newline at end of file
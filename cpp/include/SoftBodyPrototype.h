@@ -0,0 +1,106 @@
+#pragma once
+#include <memory>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "Mesh.h"
+#include "Vector2.h"
+
+using json = nlohmann::json;
+
+namespace sim {
+    /**
+     * @brief Immutable rest shape shared by every SoftBody instanced from it.
+     *
+     * Holds what identical bodies would otherwise each duplicate: the rest
+     * positions, the constraint topology with its rest lengths and
+     * coefficients, and the border indices. Instances only own their particles
+     * (see SoftBody::instantiate), and solve their constraints directly from
+     * the prototype edges.
+     */
+    class SoftBodyPrototype {
+    public:
+        /**
+         * @brief Mesh a polygon into a prototype.
+         *
+         * Parameters are the same as SoftBody::createFromPolygon. The polygon is
+         * given in the prototype frame, instances place it with their transform.
+         */
+        static std::shared_ptr<const SoftBodyPrototype> createFromPolygon(
+            const std::vector<Vector2>& polygon,
+            int mesh_unit = 10,
+            double mass = 1,
+            double radius = 1,
+            double stiffness = 0.8,
+            double damping = 0.1,
+            double friction = 0.1,
+            double restitution = 0.9,
+            bool is_pinned = false,
+            MESH_TYPE mesh_type = RingMesh,
+            bool reorder = false
+        );
+
+        /**
+         * @brief Build a prototype from an already generated mesh.
+         *
+         * @param reordered Whether the mesh was renumbered by reorderMesh, kept for serialization.
+         */
+        static std::shared_ptr<const SoftBodyPrototype> createFromMesh(
+            const MeshData& mesh,
+            int mesh_unit = 10,
+            double mass = 1,
+            double radius = 1,
+            double stiffness = 0.8,
+            double damping = 0.1,
+            double friction = 0.1,
+            double restitution = 0.9,
+            bool is_pinned = false,
+            MESH_TYPE mesh_type = RingMesh,
+            bool reordered = false
+        );
+
+        // --- Accessors ----
+        const std::vector<Vector2>& getRestPositions() const { return rest_positions; }
+        const std::vector<std::pair<int,int>>& getEdges() const { return edges; }
+        const std::vector<double>& getRestLengths() const { return rest_lengths; }
+        const std::vector<int>& getBorder() const { return border; }
+        const std::vector<int>& getSurface() const { return surface; }
+        double getMass() const { return mass; }
+        double getRadius() const { return radius; }
+        double getStiffness() const { return stiffness; }
+        double getDamping() const { return damping; }
+        double getFriction() const { return friction; }
+        double getRestitution() const { return restitution; }
+        bool isPinned() const { return pinned; }
+        int getMeshUnit() const { return mesh_unit; }
+        MESH_TYPE getMeshType() const { return mesh_type; }
+        bool isReordered() const { return reordered; }
+
+        // --- Saver & Loader ----
+        /**
+         * @brief Serialize the prototype in the format of a meshed SoftBody.
+         */
+        json as_json() const;
+        static std::shared_ptr<const SoftBodyPrototype> from_json(const json& data);
+
+    private:
+        SoftBodyPrototype() {}
+
+        std::vector<Vector2> rest_positions;    /// Rest position of every particle
+        std::vector<std::pair<int,int>> edges;  /// Constraint topology, as particle indices
+        std::vector<double> rest_lengths;       /// Rest length of every edge
+        std::vector<int> border;                /// Particle index of each border vertex
+        std::vector<int> surface;               /// Particle index of each outline particle, in order
+        double mass = 1;                        /// Mass of each particle
+        double radius = 1;                      /// Radius of each particle
+        double stiffness = 0.8;                 /// Stiffness of every edge
+        double damping = 0.1;                   /// Damping of every edge
+        double friction = 0.1;                  /// Default friction of the instances
+        double restitution = 0.9;               /// Default restitution of the instances
+        bool pinned = false;                    /// Whether the particles are pinned
+        int mesh_unit = 10;                     /// Distance between particles in the mesh
+        MESH_TYPE mesh_type = RingMesh;         /// Meshing strategy
+        bool reordered = false;                 /// Whether the mesh was renumbered for locality
+    };
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <utility>
+#include <vector>
+
+#include "Particle.h"
+#include "Vector2.h"
+
+namespace sim {
+    /**
+     * @brief Shallow bounding sphere hierarchy over clusters of a body's particles.
+     *
+     * Clusters are found once, by median splits of the positions at build
+     * time, and keep their particles: constraints hold the particles of a
+     * cluster together, so refit() only recomputes the spheres each step.
+     * Unlike a single box per body, the hierarchy of a concave or elongated
+     * body leaves out the empty space around it, and forEachPair() only
+     * reaches the particles of clusters that actually overlap.
+     */
+    class SphereTree {
+    public:
+        /**
+         * @brief Cluster a list of particles and fit the spheres to their positions.
+         * @param particles The particles, the list must outlive the tree.
+         */
+        void build(const std::vector<Particle*>& particles);
+
+        /**
+         * @brief Recompute every sphere from the current particle positions.
+         */
+        void refit();
+
+        /**
+         * @brief Call visit(i, j) for the particles of overlapping clusters of two trees.
+         *
+         * Both trees are descended together from their roots, a particle is
+         * only paired with a cluster of the other tree whose sphere it touches.
+         * Indices are positions in the lists the trees were built over, the
+         * particles themselves may not touch.
+         * @return The number of leaf cluster pairs that overlapped.
+         */
+        template <typename F>
+        static size_t forEachPair(const SphereTree& a, const SphereTree& b, F&& visit) {
+            if (a.nodes.empty() || b.nodes.empty()) return 0;
+            size_t leaf_pairs = 0;
+            std::pair<int,int> stack[128];
+            int top = 0;
+            stack[top++] = { 0, 0 };
+            while (top > 0) {
+                auto [ia, ib] = stack[--top];
+                const Node& na = a.nodes[ia];
+                const Node& nb = b.nodes[ib];
+                if (!overlap(na.center, na.radius, nb.center, nb.radius)) continue;
+                bool leaf_a = na.count > 0, leaf_b = nb.count > 0;
+                if (leaf_a && leaf_b) {
+                    leaf_pairs++;
+                    for (int i = na.first; i < na.first + na.count; i++) {
+                        const Particle* p = (*a.particles)[a.order[i]];
+                        if (!overlap(p->getPosition(), p->getRadius(), nb.center, nb.radius)) continue;
+                        for (int j = nb.first; j < nb.first + nb.count; j++)
+                            visit(a.order[i], b.order[j]);
+                    }
+                } else if (leaf_b || (!leaf_a && na.radius >= nb.radius)) {
+                    // Split the larger sphere
+                    stack[top++] = { na.first, ib };
+                    stack[top++] = { ia + 1, ib };
+                } else {
+                    stack[top++] = { ia, nb.first };
+                    stack[top++] = { ia, ib + 1 };
+                }
+            }
+            return leaf_pairs;
+        }
+
+        // --- Accessors ----
+        /// List the tree was built over, nullptr before build()
+        const std::vector<Particle*>* getParticles() const { return particles; }
+        size_t getNodeCount() const { return nodes.size(); }
+        /// Sphere enclosing every particle, only valid when the tree is not empty
+        Vector2 getCenter() const { return nodes[0].center; }
+        double getRadius() const { return nodes[0].radius; }
+        bool empty() const { return nodes.empty(); }
+
+    private:
+        /// Hierarchy node, the left child of an inner node directly follows it
+        struct Node {
+            Vector2 center;     /// Bounding sphere of the particles below the node
+            double radius;
+            int first;          /// Leaf: first index in order, inner: index of the right child
+            int count;          /// Number of particles of a leaf, 0 for inner nodes
+        };
+
+        static bool overlap(const Vector2& c1, double r1, const Vector2& c2, double r2) {
+            double r = r1 + r2;
+            return (c1 - c2).lengthSquared() < r * r;
+        }
+
+        int build(int begin, int end);
+
+        const std::vector<Particle*>* particles = nullptr;  /// Clustered particles
+        std::vector<int> order;     /// Particle indices, grouped by leaf
+        std::vector<Node> nodes;    /// Hierarchy nodes, the root first
+    };
+}
@@ -0,0 +1,166 @@
+#pragma once
+#include <cstdint>
+
+namespace sim {
+    /**
+     * @brief Phases of a simulation step, used to index the step statistics.
+     */
+    enum STEP_PHASE {
+        GravityPhase,           /// Global forces applied to every body
+        ConstraintsPhase,       /// Distance constraints solving
+        WorldCollisionsPhase,   /// Particles against world colliders (both passes)
+        BodyCollisionsPhase,    /// Particles against particles of other bodies
+        IntegrationPhase,       /// Verlet integration of the particles
+        SortPhase,              /// Periodic re-sort of the particle storage
+        PHASE_COUNT
+    };
+
+    /**
+     * @brief Human readable name of a step phase.
+     * @param phase The phase to name.
+     * @return A static string naming the phase.
+     */
+    inline const char* phaseName(STEP_PHASE phase) {
+        switch (phase) {
+        case GravityPhase:         return "gravity";
+        case ConstraintsPhase:     return "constraints";
+        case WorldCollisionsPhase: return "collisions_world";
+        case BodyCollisionsPhase:  return "collisions_bodies";
+        case IntegrationPhase:     return "integration";
+        case SortPhase:            return "sort";
+        default:                   return "unknown";
+        }
+    }
+
+    /**
+     * @brief Hardware counters sampled around each phase (see PerfCounters).
+     */
+    enum PERF_COUNTER {
+        CyclesCounter,          /// CPU cycles
+        InstructionsCounter,    /// Retired instructions
+        L1MissesCounter,        /// L1 data cache read misses
+        LLCMissesCounter,       /// Last level cache read misses
+        BranchMissesCounter,    /// Mispredicted branches
+        COUNTER_COUNT
+    };
+
+    /**
+     * @brief Human readable name of a hardware counter.
+     * @param counter The counter to name.
+     * @return A static string naming the counter.
+     */
+    inline const char* counterName(PERF_COUNTER counter) {
+        switch (counter) {
+        case CyclesCounter:       return "cycles";
+        case InstructionsCounter: return "instructions";
+        case L1MissesCounter:     return "l1d_misses";
+        case LLCMissesCounter:    return "llc_misses";
+        case BranchMissesCounter: return "branch_misses";
+        default:                  return "unknown";
+        }
+    }
+
+    /**
+     * @brief Statistics gathered while running Simulation::step.
+     *
+     * Timings describe the last step only, the step counter
+     * accumulates until the statistics are reset.
+     */
+    struct StepStats {
+        double phase_ms[PHASE_COUNT] = {};  /// Time spent in each phase during the last step [ms]
+        double step_ms = 0.0;               /// Total duration of the last step [ms]
+        unsigned long long steps = 0;       /// Number of steps since the last reset
+        unsigned long long spikes = 0;      /// Steps slower than the spike threshold
+        unsigned long long sorts = 0;       /// Re-sorts of the particle storage
+        double sort_total_ms = 0.0;         /// Time spent re-sorting since the last reset [ms]
+
+        // Scene size and activity during the last step
+        unsigned long long bodies = 0;              /// Bodies in the simulation
+        unsigned long long particles = 0;           /// Particles of every body
+        unsigned long long constraints = 0;         /// Constraints and prototype edges of every body
+        unsigned long long resting_bodies = 0;      /// Bodies whose center moved slower than Simulation::setRestSpeed
+        unsigned long long body_contacts = 0;       /// Touching particle / particle or particle / edge pairs between bodies
+
+        // World collider culling, counted over both world passes of the last step
+        unsigned long long world_pairs = 0;         /// Body / collider pairs considered
+        unsigned long long world_pairs_skipped = 0; /// Pairs skipped by WorldCollider::mayCollide
+        unsigned long long world_particles_skipped = 0; /// Particles skipped by Simulation::setWorldClearance
+
+        // Collision layers, see SoftBody::setCollisionLayer and WorldCollider::setCollisionMask
+        unsigned long long masked_pairs = 0;        /// Body / body and body / collider pairs skipped by their masks
+
+        // Surface collisions, see Simulation::setSurfaceCollisions
+        unsigned long long collision_particles = 0; /// Particles taking part in the collisions of the last step
+        unsigned long long surface_fallbacks = 0;   /// Bodies colliding every particle because they folded
+
+        // Sphere trees, only filled when enabled with Simulation::setSphereTrees
+        double sphere_refit_ms = 0.0;               /// Building and refitting the hierarchies during the last step [ms]
+        unsigned long long sphere_leaf_pairs = 0;   /// Overlapping cluster pairs whose particles were tested
+
+        // Edge contacts, only filled when enabled with Simulation::setEdgeContacts
+        unsigned long long edge_contacts = 0;       /// Particle against edge contacts resolved during the last step
+
+        // Contact cache, only filled when enabled with Simulation::setContactCache
+        unsigned long long contact_pairs = 0;       /// Cached particle pairs resolved during the last step
+        unsigned long long manifolds_reused = 0;    /// Body pairs that skipped the narrowphase
+        unsigned long long manifolds_rebuilt = 0;   /// Body pairs that ran it
+
+        // Contact pipeline, only filled when enabled with Simulation::setContactPipeline
+        unsigned long long contacts = 0;            /// Contacts found by the detection stage
+        unsigned long long contact_colors = 0;      /// Colors used to resolve them
+        double contact_detect_ms = 0.0;             /// Detection stage of the last step [ms]
+        double contact_color_ms = 0.0;              /// Coloring stage of the last step [ms]
+        double contact_resolve_ms = 0.0;            /// Resolution stage of the last step [ms]
+
+        // Hardware counters, only filled when enabled with Simulation::setPerfCounters
+        uint64_t phase_counters[PHASE_COUNT][COUNTER_COUNT] = {};   /// Counter deltas of each phase during the last step
+        bool counters_available[COUNTER_COUNT] = {};                /// Counters that could be opened on this machine
+
+        /**
+         * @brief Instructions per cycle of a phase during the last step.
+         * @param phase The phase to query.
+         * @return The IPC, or 0 when cycles were not measured.
+         */
+        double ipc(STEP_PHASE phase) const {
+            uint64_t cycles = phase_counters[phase][CyclesCounter];
+            return cycles ? double(phase_counters[phase][InstructionsCounter]) / double(cycles) : 0.0;
+        }
+
+        /**
+         * @brief Re-sort cost spread over every step.
+         * @return Average time per step spent re-sorting [ms].
+         */
+        double amortizedSortMs() const {
+            return steps ? sort_total_ms / double(steps) : 0.0;
+        }
+
+        /**
+         * @brief Clear the per-step values before a new step.
+         */
+        void beginStep() {
+            for (auto& t : phase_ms) t = 0.0;
+            for (auto& phase : phase_counters)
+                for (auto& c : phase) c = 0;
+            step_ms = 0.0;
+            resting_bodies = 0;
+            body_contacts = 0;
+            world_pairs = 0;
+            world_pairs_skipped = 0;
+            world_particles_skipped = 0;
+            masked_pairs = 0;
+            collision_particles = 0;
+            surface_fallbacks = 0;
+            sphere_refit_ms = 0.0;
+            sphere_leaf_pairs = 0;
+            edge_contacts = 0;
+            contact_pairs = 0;
+            manifolds_reused = 0;
+            manifolds_rebuilt = 0;
+            contacts = 0;
+            contact_colors = 0;
+            contact_detect_ms = 0.0;
+            contact_color_ms = 0.0;
+            contact_resolve_ms = 0.0;
+        }
+    };
+}
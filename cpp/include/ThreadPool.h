@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sim {
+    /**
+     * @brief Fixed set of worker threads running data parallel loops.
+     *
+     * parallelFor() cuts a range into chunks that the workers and the calling
+     * thread pick in turn, and returns once every chunk is done. Chunks only
+     * depend on the range and the grain, not on the number of threads, so a
+     * loop writing one output buffer per chunk produces the same result
+     * whatever the pool size.
+     */
+    class ThreadPool {
+    public:
+        /**
+         * @brief Start the workers.
+         * @param threads Threads taking part in a loop, the calling thread included.
+         */
+        explicit ThreadPool(int threads);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * @brief Run fn(begin, end) over [0, count) in chunks of grain items.
+         *
+         * Blocks until all chunks are done. Must not be called from fn.
+         */
+        void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+        int size() const { return (int)workers.size() + 1; }
+
+    private:
+        void work();
+        void runChunks();
+
+        std::vector<std::thread> workers;                           /// Worker threads, the caller not included
+        std::mutex mutex;                                           /// Guards the job fields below
+        std::condition_variable wake;                               /// Signals a new job or the shutdown
+        std::condition_variable done;                               /// Signals the end of a job
+        const std::function<void(size_t, size_t)>* job = nullptr;   /// Loop body of the current job
+        size_t job_count = 0;                                       /// Range of the current job
+        size_t job_grain = 1;                                       /// Chunk size of the current job
+        std::atomic<size_t> next{0};                                /// First item of the next free chunk
+        int busy = 0;                                               /// Workers still running the current job
+        uint64_t generation = 0;                                    /// Incremented for every job
+        bool stopping = false;                                      /// Set to end the workers
+    };
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace sim {
+    /**
+     * @brief A completed duration event, as stored in the trace buffers.
+     */
+    struct TraceEvent {
+        const char* name;       /// Event name (must be a static string)
+        const char* category;   /// Event category (must be a static string)
+        uint64_t start_ns;      /// Start time since the recorder epoch [ns]
+        uint64_t duration_ns;   /// Duration of the event [ns]
+    };
+
+    /**
+     * @brief Records timeline events and exports them as Chrome/Perfetto trace JSON.
+     *
+     * Every thread appends to its own fixed-size buffer, so recording never takes
+     * a lock: the owning thread is the only writer and publishes its event count
+     * with a release store. A mutex is only taken the first time a thread records.
+     * When a buffer is full, further events of that thread are dropped and counted.
+     * A thread hands its buffer back when it exits, with the events recorded so
+     * far: the next thread of the same name to record continues it instead of
+     * allocating another, so recreated worker threads do not grow the memory.
+     *
+     * The recorder is disabled by default, in which case a TraceScope costs a
+     * single relaxed atomic load.
+     */
+    class TraceRecorder {
+    public:
+        /**
+         * @brief Access the process wide recorder.
+         */
+        static TraceRecorder& instance();
+
+        /**
+         * @brief Start recording events.
+         * @param events_per_thread Capacity of the buffer allocated for each thread.
+         */
+        void enable(size_t events_per_thread = 1 << 16);
+        /**
+         * @brief Stop recording events, already recorded events are kept.
+         */
+        void disable() { enabled.store(false, std::memory_order_relaxed); }
+        bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Append a completed event to the calling thread buffer.
+         * @param name Static event name.
+         * @param category Static event category.
+         * @param start_ns Start time as returned by now().
+         * @param duration_ns Duration of the event.
+         */
+        void record(const char* name, const char* category, uint64_t start_ns, uint64_t duration_ns);
+
+        /**
+         * @brief Name the track of the calling thread in the exported trace.
+         *
+         * The thread that loaded the library is "main", other threads are
+         * numbered unless they call this before their first event.
+         * @param name Static thread name.
+         */
+        void setThreadName(const char* name);
+
+        /**
+         * @brief Drop every recorded event.
+         *
+         * Must not be called while other threads are recording.
+         */
+        void clear();
+
+        /**
+         * @brief Number of events currently held by all buffers.
+         */
+        size_t eventCount();
+        /**
+         * @brief Number of events dropped because a buffer was full.
+         */
+        size_t droppedCount();
+
+        /**
+         * @brief Monotonic time since the recorder epoch.
+         * @return Time in nanoseconds.
+         */
+        static uint64_t now();
+
+        // --- Saver ----
+        /**
+         * @brief Build the Chrome trace-event document ("traceEvents" array of "X" events).
+         */
+        json as_json();
+        /**
+         * @brief Write the trace to a file loadable by chrome://tracing or ui.perfetto.dev.
+         * @param file_path Path of the JSON file to write.
+         * @return true if the file was written.
+         */
+        bool save(const std::string& file_path);
+
+    private:
+        /**
+         * @brief Single producer buffer owned by one thread.
+         */
+        struct ThreadBuffer {
+            std::vector<TraceEvent> events;     /// Preallocated event storage
+            std::atomic<size_t> count{0};       /// Number of published events
+            std::atomic<size_t> dropped{0};     /// Events lost because the buffer was full
+            uint32_t tid = 0;                   /// Sequential id used in the exported trace
+            const char* name = nullptr;         /// Name of the track, nullptr to number it
+        };
+
+        /**
+         * @brief Thread local handle returning the buffer of a thread when it exits.
+         */
+        struct BufferLease {
+            ThreadBuffer* buffer = nullptr;     /// Buffer of the thread, acquired on its first event
+            const char* name = nullptr;         /// Name given by setThreadName()
+            ~BufferLease();
+        };
+
+        TraceRecorder() = default;
+        ThreadBuffer* localBuffer();
+        static BufferLease& lease();
+
+        std::atomic<bool> enabled{false};                   /// Whether events are recorded
+        size_t capacity = 1 << 16;                          /// Capacity of newly created buffers
+        std::mutex registry_mutex;                          /// Guards the buffers list
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers; /// One buffer per thread recording at once
+        std::vector<ThreadBuffer*> free_buffers;            /// Buffers of exited threads, reused first
+    };
+
+    /**
+     * @brief RAII helper recording the lifetime of a scope as a trace event.
+     *
+     * @code
+     * {
+     *     TraceScope scope("createFromPolygon", "mesh");
+     *     ...
+     * }
+     * @endcode
+     */
+    class TraceScope {
+    public:
+        TraceScope(const char* name, const char* category)
+            : name(name), category(category),
+              active(TraceRecorder::instance().isEnabled()),
+              start(active ? TraceRecorder::now() : 0) {}
+        ~TraceScope() {
+            if (active)
+                TraceRecorder::instance().record(name, category, start, TraceRecorder::now() - start);
+        }
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+
+    private:
+        const char* name;       /// Event name
+        const char* category;   /// Event category
+        bool active;            /// Whether the recorder was enabled on entry
+        uint64_t start;         /// Start time [ns]
+    };
+}
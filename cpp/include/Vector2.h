@@ -45,6 +45,11 @@ namespace sim {
             return (len != 0.0f) ? (*this / len) : Vector2(0.0f, 0.0f);
         }
 
+        Vector2 rotated(double angle) const {
+            double c = std::cos(angle), s = std::sin(angle);
+            return {c * x - s * y, s * x + c * y};
+        }
+
         Vector2 abs() const {
             return {std::abs(x), std::abs(y)};
         }
@@ -55,10 +60,10 @@ namespace sim {
         }
 
         // --- Saver & Loader ----
-        json as_json() {
+        json as_json() const {
             json data;
             data["x"] = x;
-            data["y"] = x;
+            data["y"] = y;
             return data;
         }
         static Vector2 from_json(json data) {
@@ -1,6 +1,9 @@
 #pragma once
+#include <cstdint>
+#include <limits>
 #include <nlohmann/json.hpp>
 
+#include "AABB.h"
 #include "Particle.h"
 
 using json = nlohmann::json;
@@ -30,17 +33,90 @@ namespace sim {
          */
         virtual bool collide(Particle* p, double friction, double restitution) = 0;
 
+        /**
+         * @brief Handle collision of a particle along its Verlet motion
+         * 
+         * Tests the segment from the previous to the current position of the
+         * particle, so that a particle that crossed the collider during the
+         * step is caught at its time of impact and responded to at the contact
+         * point. The default is collide(), enough for colliders that bound a
+         * half space, since a particle cannot get through them.
+         * 
+         * @return true if a collision occurred and was handled, false otherwise
+         */
+        virtual bool collideSwept(Particle* p, double friction, double restitution) {
+            return collide(p, friction, restitution);
+        }
+
+        /**
+         * @brief Cheap conservative test against the bounds of a body
+         * 
+         * When it returns false, collide() is guaranteed to do nothing for any
+         * particle whose disc lies in the box, so the whole body can be skipped.
+         * 
+         * @param box Bounds of the particles, radii included
+         * @return false if no particle in the box can touch the collider
+         */
+        virtual bool mayCollide(const AABB& /*box*/) const { return true; }
+
+        /**
+         * @brief Signed distance from a point to the collider surface
+         * 
+         * Positive on the side particles are kept on, negative in the region
+         * they are pushed out of. Used to bake colliders into an SDFCollider.
+         * 
+         * @param point Position to evaluate
+         * @return The signed distance, +infinity for colliders without a distance field
+         */
+        virtual double signedDistance(const Vector2& /*point*/) const {
+            return std::numeric_limits<double>::infinity();
+        }
+
+        /**
+         * @brief Conservative distance from a point to the collider
+         * 
+         * A lower bound that changes at most as fast as the point moves, and
+         * stays below the radius of any particle collide() acts on. A particle
+         * whose bound exceeds its radius by m can thus move by m before it
+         * needs testing again (see Simulation::setWorldClearance).
+         * 
+         * @param point Position to evaluate
+         * @return The bound, 0 for colliders without one so that they are always tested
+         */
+        virtual double clearance(const Vector2& /*point*/) const { return 0.0; }
+
+        // --- Accessors & mutators ----
+        /// Layers of the bodies the collider acts on (see SoftBody::setCollisionLayer()), all by default
+        void setCollisionMask(uint32_t mask) { collision_mask = mask; }
+        uint32_t getCollisionMask() const { return collision_mask; }
+
         // --- Saver & Loader ----
         virtual json as_json() = 0;
         static WorldCollider* from_json(json data);
 
     protected:
+        /**
+         * @brief Move a particle to a contact and apply friction and restitution
+         * 
+         * The only response of the colliders, static and swept collisions alike.
+         * 
+         * @param p The particle
+         * @param position Position of the particle at the contact
+         * @param n Unit collision normal, pointing away from the collider
+         * @param vel Verlet displacement of the particle before the contact
+         */
+        void respond(Particle* p, const Vector2& position, const Vector2& n, const Vector2& vel,
+                     double friction, double restitution) const;
+
         double worldFriction;   /// Friction coefficient of the collider [smooth 0 < 1 rough]
         double worldRestitution; /// Restitution (bounciness) coefficient of the collider [sticky 0 < 1 reflect]
+        uint32_t collision_mask = 0xFFFFFFFF; /// Layers of the bodies it acts on
     };
     enum COLLIDER_TYPE {
         PlaneColliderType,
         OuterCircleColliderType,
-        InnerCircleCollideTyper
+        InnerCircleCollideTyper,
+        SDFColliderType,
+        SegmentMeshColliderType
     };
 }
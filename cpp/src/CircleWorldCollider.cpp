@@ -1,8 +1,29 @@
 #include "CircleWorldCollider.h"
 #include <algorithm>
+#include <cmath>
 
 using namespace sim;
 
+// Relative margin of the batch pre-tests, flagged particles are re-tested exactly
+static constexpr double BATCH_SLACK = 1e-12;
+
+/**
+ * @brief Intersections of the motion p0 + t * v with a circle.
+ * @return false if the line misses the circle, else t0 <= t1 are the entry and exit times.
+ */
+static bool sweepCircle(const Vector2& p0, const Vector2& v, const Vector2& center, double R, double& t0, double& t1) {
+    Vector2 f = p0 - center;
+    double a = v.dot(v);
+    if (a == 0.0) return false;
+    double b = f.dot(v);
+    double disc = b * b - a * (f.dot(f) - R * R);
+    if (disc < 0.0) return false;
+    double root = std::sqrt(disc);
+    t0 = (-b - root) / a;
+    t1 = (-b + root) / a;
+    return true;
+}
+
 CircleCollider::CircleCollider(Vector2 center, double radius, double friction, double restitution)
     : WorldCollider(friction, restitution), center(center), radius(radius) {}
 
@@ -27,24 +48,71 @@ bool InnerCircleCollider::collide(Particle *p, double friction, double restituti
         Vector2 vel = p->getPosition() - p->getPrevPosition();
         Vector2 n = toP / dist; // Collision normal
 
-        // --- Positional correction ---
-        p->setPosition(center + n * maxDist);
+        respond(p, center + n * maxDist, n, vel, friction, restitution);
+
+        return true;
+    }
+    return false;
+}
+
+bool InnerCircleCollider::collideSwept(Particle* p, double friction, double restitution) {
+    if (p->isPinned()) return false;
 
-        double effectiveFriction    = 0.5 * (worldFriction + friction);
-        double effectiveRestitution = std::min(worldRestitution, restitution);
+    Vector2 p0 = p->getPrevPosition();
+    Vector2 vel = p->getPosition() - p0;
+    double maxDist = radius - p->getRadius();
+    double t0, t1;
+    if (maxDist <= 0.0 || (p0 - center).length() > maxDist || !sweepCircle(p0, vel, center, maxDist, t0, t1))
+        return collide(p, friction, restitution);
+    if (t1 >= 1.0) return false;
+
+    // Exit of the allowed disc
+    Vector2 contact = p0 + vel * t1;
+    Vector2 n = (contact - center) / maxDist;
+    respond(p, contact, n, vel, friction, restitution);
+    return true;
+}
 
-        double velAlongNormal = vel.dot(n);
-        Vector2 tangentVel = vel - velAlongNormal * n;
+bool InnerCircleCollider::mayCollide(const AABB& box) const {
+    // Farthest corner of the box from the center
+    double dx = std::max(std::abs(box.min.x - center.x), std::abs(box.max.x - center.x));
+    double dy = std::max(std::abs(box.min.y - center.y), std::abs(box.max.y - center.y));
+    return dx * dx + dy * dy >= radius * radius;
+}
 
-        Vector2 correctedNormal = effectiveRestitution * velAlongNormal * n;
-        Vector2 correctedTangent = (1.0 - effectiveFriction) * tangentVel;
+double InnerCircleCollider::signedDistance(const Vector2& point) const {
+    return radius - (point - center).length();
+}
 
-        Vector2 correctedVel = correctedNormal - correctedTangent;
-        p->setPrevPosition(p->getPosition() + correctedVel);
+double InnerCircleCollider::clearance(const Vector2& point) const {
+    double dist = (point - center).length();
+    return std::min(radius - dist, dist);
+}
 
-        return true;
+void InnerCircleCollider::collideBatch(ParticleBatch& batch, double friction, double restitution) {
+    const size_t n = batch.size();
+    const double* x = batch.x.data();
+    const double* y = batch.y.data();
+    const double* r = batch.radius.data();
+    const uint8_t* active = batch.active.data();
+    uint8_t* hit = batch.hit.data();
+    const double cx = center.x, cy = center.y, R = radius;
+
+    // Pass 1: outside the allowed disc, a particle at the center counts as dist = 1.
+    // Squared distances avoid the square root, the slack absorbs their rounding.
+    for (size_t i = 0; i < n; i++) {
+        double dx = x[i] - cx, dy = y[i] - cy;
+        double d2 = dx * dx + dy * dy;
+        d2 = d2 == 0.0 ? 1.0 : d2;
+        double maxDist = R - r[i];
+        hit[i] = active[i] & ((maxDist < 0.0) | (d2 * (1.0 + BATCH_SLACK) > maxDist * maxDist));
+    }
+
+    // Pass 2: response on the flagged particles
+    for (size_t i = 0; i < n; i++) {
+        if (!hit[i]) continue;
+        if (InnerCircleCollider::collide(batch.particles[i], friction, restitution)) batch.sync(i);
     }
-    return false;
 }
 
 json InnerCircleCollider::as_json()
@@ -53,6 +121,9 @@ json InnerCircleCollider::as_json()
     data["ColliderType"] = COLLIDER_TYPE::InnerCircleCollideTyper;
     data["point"] = center.as_json();
     data["distance"] = radius;
+    data["friction"] = worldFriction;
+    data["restitution"] = worldRestitution;
+    data["collision_mask"] = collision_mask;
     return data;
 }
 
@@ -75,24 +146,65 @@ bool OuterCircleCollider::collide(Particle* p, double friction, double restituti
         Vector2 vel = p->getPosition() - p->getPrevPosition();
         Vector2 n = toP / dist; // Collision normal
 
-        // --- Positional correction ---
-        p->setPosition(center + n * maxDist);
+        respond(p, center + n * maxDist, n, vel, friction, restitution);
+
+        return true;
+    }
+    return false;
+}
+
+bool OuterCircleCollider::collideSwept(Particle* p, double friction, double restitution) {
+    if (p->isPinned()) return false;
 
-        double effectiveFriction    = 0.5 * (worldFriction + friction);
-        double effectiveRestitution = std::min(worldRestitution, restitution);
+    Vector2 p0 = p->getPrevPosition();
+    Vector2 vel = p->getPosition() - p0;
+    double maxDist = radius + p->getRadius();
+    if ((p0 - center).length() < maxDist) return collide(p, friction, restitution);
+    double t0, t1;
+    if (!sweepCircle(p0, vel, center, maxDist, t0, t1) || t0 < 0.0 || t0 >= 1.0) return false;
+
+    // Entry in the obstacle, also when the whole motion went through it
+    Vector2 contact = p0 + vel * t0;
+    Vector2 n = (contact - center) / maxDist;
+    respond(p, contact, n, vel, friction, restitution);
+    return true;
+}
 
-        double velAlongNormal = vel.dot(n);
-        Vector2 tangentVel = vel - velAlongNormal * n;
+bool OuterCircleCollider::mayCollide(const AABB& box) const {
+    // Closest point of the box to the center
+    double dx = center.x - std::clamp(center.x, box.min.x, box.max.x);
+    double dy = center.y - std::clamp(center.y, box.min.y, box.max.y);
+    return dx * dx + dy * dy <= radius * radius;
+}
 
-        Vector2 correctedNormal = effectiveRestitution * velAlongNormal * n;
-        Vector2 correctedTangent = (1.0 - effectiveFriction) * tangentVel;
+double OuterCircleCollider::signedDistance(const Vector2& point) const {
+    return (point - center).length() - radius;
+}
 
-        Vector2 correctedVel = correctedNormal - correctedTangent;
-        p->setPrevPosition(p->getPosition() + correctedVel);
+void OuterCircleCollider::collideBatch(ParticleBatch& batch, double friction, double restitution) {
+    const size_t n = batch.size();
+    const double* x = batch.x.data();
+    const double* y = batch.y.data();
+    const double* r = batch.radius.data();
+    const uint8_t* active = batch.active.data();
+    uint8_t* hit = batch.hit.data();
+    const double cx = center.x, cy = center.y, R = radius;
+
+    // Pass 1: inside the obstacle, a particle at the center counts as dist = 1.
+    // Squared distances avoid the square root, the slack absorbs their rounding.
+    for (size_t i = 0; i < n; i++) {
+        double dx = x[i] - cx, dy = y[i] - cy;
+        double d2 = dx * dx + dy * dy;
+        d2 = d2 == 0.0 ? 1.0 : d2;
+        double maxDist = R + r[i];
+        hit[i] = active[i] & (d2 < maxDist * maxDist * (1.0 + BATCH_SLACK));
+    }
 
-        return true;
+    // Pass 2: response on the flagged particles
+    for (size_t i = 0; i < n; i++) {
+        if (!hit[i]) continue;
+        if (OuterCircleCollider::collide(batch.particles[i], friction, restitution)) batch.sync(i);
     }
-    return false;
 }
 
 json OuterCircleCollider::as_json()
@@ -101,5 +213,8 @@ json OuterCircleCollider::as_json()
     data["ColliderType"] = COLLIDER_TYPE::OuterCircleColliderType;
     data["point"] = center.as_json();
     data["distance"] = radius;
+    data["friction"] = worldFriction;
+    data["restitution"] = worldRestitution;
+    data["collision_mask"] = collision_mask;
     return data;
 }
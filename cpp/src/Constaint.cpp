@@ -11,6 +11,10 @@ Constraint::Constraint(Particle *part1, Particle *part2, double stiffness, doubl
 Constraint::~Constraint() {}
 
 void Constraint::applyConstraint() {
+    solve(part1, part2, restLength, stiffness, damping);
+}
+
+void Constraint::solve(Particle* part1, Particle* part2, double restLength, double stiffness, double damping) {
     Vector2 delta = part2->getPosition() - part1->getPosition();
     double dist = delta.length();
     if (dist < 1e-8) return;
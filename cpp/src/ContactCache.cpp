@@ -0,0 +1,53 @@
+#include "ContactCache.h"
+
+using namespace sim;
+
+bool ContactManifold::isValid(const std::vector<Particle*>& p1, const std::vector<Particle*>& p2, double skin) const {
+    if (anchors.size() != p1.size() + p2.size()) return false;
+
+    double limit = 0.25 * skin * skin;
+    for (size_t i = 0; i < p1.size(); i++)
+        if ((p1[i]->getPosition() - anchors[i]).lengthSquared() >= limit) return false;
+    for (size_t i = 0; i < p2.size(); i++)
+        if ((p2[i]->getPosition() - anchors[p1.size() + i]).lengthSquared() >= limit) return false;
+    return true;
+}
+
+void ContactManifold::rebuild(const std::vector<Particle*>& p1, const std::vector<Particle*>& p2, double skin) {
+    // Previous state of the pairs, by particle indices
+    std::unordered_map<uint64_t, const ContactPair*> previous;
+    if (anchors.size() == p1.size() + p2.size()) {
+        previous.reserve(pairs.size());
+        for (auto& pair : pairs)
+            previous[(uint64_t)pair.a << 32 | (uint32_t)pair.b] = &pair;
+    }
+
+    std::vector<ContactPair> found;
+    for (int i = 0; i < (int)p1.size(); i++) {
+        for (int j = 0; j < (int)p2.size(); j++) {
+            double reach = p1[i]->getRadius() + p2[j]->getRadius() + skin;
+            if ((p1[i]->getPosition() - p2[j]->getPosition()).lengthSquared() >= reach * reach) continue;
+            auto it = previous.find((uint64_t)i << 32 | (uint32_t)j);
+            found.push_back(it != previous.end() ? *it->second : ContactPair{ i, j });
+        }
+    }
+    pairs.swap(found);
+
+    anchors.resize(p1.size() + p2.size());
+    for (size_t i = 0; i < p1.size(); i++) anchors[i] = p1[i]->getPosition();
+    for (size_t i = 0; i < p2.size(); i++) anchors[p1.size() + i] = p2[i]->getPosition();
+}
+
+ContactManifold& ContactCache::manifold(const SoftBody* first, const SoftBody* second) {
+    ContactManifold& m = manifolds[{ first, second }];
+    m.last_step = step;
+    return m;
+}
+
+void ContactCache::endStep() {
+    for (auto it = manifolds.begin(); it != manifolds.end();) {
+        if (it->second.last_step != step) it = manifolds.erase(it);
+        else ++it;
+    }
+    step++;
+}
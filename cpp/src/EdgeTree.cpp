@@ -0,0 +1,68 @@
+#include "EdgeTree.h"
+#include <algorithm>
+
+using namespace sim;
+
+// Edges per BVH leaf
+static constexpr int LEAF_SIZE = 4;
+
+static AABB merge(const AABB& a, const AABB& b) {
+    return { Vector2(std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y)),
+             Vector2(std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y)) };
+}
+
+void EdgeTree::build(const std::vector<Particle*>& outline) {
+    // A ring of two particles has a single edge
+    int n = outline.size() > 2 ? (int)outline.size() : (int)outline.size() - 1;
+    n = std::max(n, 0);
+    boxes.assign(n, AABB{});
+    nodes.clear();
+    if (n == 0) return;
+    nodes.reserve(2 * (n / LEAF_SIZE + 1));
+    build(0, n);
+    refit(outline);
+}
+
+int EdgeTree::build(int begin, int end) {
+    int index = (int)nodes.size();
+    nodes.push_back({});
+    if (end - begin <= LEAF_SIZE) {
+        nodes[index].first = begin;
+        nodes[index].count = end - begin;
+        return index;
+    }
+    // Consecutive edges are neighbours along the outline, halving the run keeps leaves compact
+    int mid = (begin + end) / 2;
+    build(begin, mid);
+    int right = build(mid, end);
+    nodes[index].first = right;
+    nodes[index].count = 0;
+    return index;
+}
+
+void EdgeTree::refit(const std::vector<Particle*>& outline) {
+    int n = (int)boxes.size();
+    double area = 0.0;
+    for (int i = 0; i < n; i++) {
+        const Particle* a = outline[i];
+        const Particle* b = outline[(i + 1) % outline.size()];
+        double r = std::max(a->getRadius(), b->getRadius());
+        const Vector2& pa = a->getPosition();
+        const Vector2& pb = b->getPosition();
+        boxes[i] = { Vector2(std::min(pa.x, pb.x) - r, std::min(pa.y, pb.y) - r),
+                     Vector2(std::max(pa.x, pb.x) + r, std::max(pa.y, pb.y) + r) };
+        area += pa.x * pb.y - pb.x * pa.y;
+    }
+    winding = area < 0.0 ? -1.0 : 1.0;
+    // Children follow their parent, so a reverse sweep sees them fitted first
+    for (int k = (int)nodes.size() - 1; k >= 0; k--) {
+        Node& node = nodes[k];
+        if (node.count > 0) {
+            node.box = boxes[node.first];
+            for (int i = node.first + 1; i < node.first + node.count; i++)
+                node.box = merge(node.box, boxes[i]);
+        } else {
+            node.box = merge(nodes[k + 1].box, nodes[node.first].box);
+        }
+    }
+}
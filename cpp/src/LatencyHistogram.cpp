@@ -0,0 +1,64 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+
+using namespace sim;
+
+static constexpr uint64_t HALF_SUB_BUCKETS = LatencyHistogram::SUB_BUCKETS / 2;
+
+LatencyHistogram::LatencyHistogram()
+    : buckets(bucketIndex(UINT64_MAX) + 1, 0) {}
+
+size_t LatencyHistogram::bucketIndex(uint64_t value) {
+    if (value < SUB_BUCKETS) return (size_t)value;
+
+    // Position of the most significant bit, >= SUB_BUCKET_BITS here
+    int msb = 63;
+    while (!(value >> msb)) msb--;
+    // Keep SUB_BUCKET_BITS - 1 bits below the most significant one
+    int shift = msb - (SUB_BUCKET_BITS - 1);
+    uint64_t sub = value >> shift;  // in [HALF_SUB_BUCKETS, SUB_BUCKETS)
+    return (size_t)(SUB_BUCKETS + (shift - 1) * HALF_SUB_BUCKETS + (sub - HALF_SUB_BUCKETS));
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < SUB_BUCKETS) return index;
+
+    uint64_t k = index - SUB_BUCKETS;
+    int shift = (int)(k / HALF_SUB_BUCKETS) + 1;
+    uint64_t sub = k % HALF_SUB_BUCKETS + HALF_SUB_BUCKETS;
+    if (shift + SUB_BUCKET_BITS > 64) return UINT64_MAX;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    buckets[bucketIndex(value)]++;
+    count++;
+    sum += value;
+    min = std::min(min, value);
+    max = std::max(max, value);
+}
+
+uint64_t LatencyHistogram::percentile(double percent) const {
+    if (count == 0) return 0;
+    percent = std::clamp(percent, 0.0, 100.0);
+
+    // Rank of the requested sample, at least the first one
+    uint64_t rank = (uint64_t)(percent / 100.0 * double(count) + 0.5);
+    rank = std::clamp<uint64_t>(rank, 1, count);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= rank) return std::min(bucketUpperBound(i), max);
+    }
+    return max;
+}
+
+void LatencyHistogram::reset() {
+    std::fill(buckets.begin(), buckets.end(), 0);
+    count = 0;
+    min = UINT64_MAX;
+    max = 0;
+    sum = 0;
+}
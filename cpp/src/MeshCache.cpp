@@ -0,0 +1,216 @@
+#include "MeshCache.h"
+#include "Trace.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <nlohmann/json.hpp>
+
+using namespace sim;
+using json = nlohmann::json;
+
+// Bump when the mesher output changes, so stale files on disk are ignored
+static constexpr int MESH_CACHE_VERSION = 3;
+
+MeshCache& MeshCache::instance() {
+    static MeshCache cache;
+    return cache;
+}
+
+// FNV-1a over the raw bytes of a value
+template <typename T>
+static void hashValue(uint64_t& h, const T& value) {
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    for (unsigned char b : bytes) {
+        h ^= b;
+        h *= 1099511628211ull;
+    }
+}
+
+uint64_t MeshCache::key(const std::vector<Vector2>& polygon, int mesh_unit, double radius, MESH_TYPE mesh_type, bool reorder) {
+    uint64_t h = 14695981039346656037ull;
+    hashValue(h, MESH_CACHE_VERSION);
+    hashValue(h, mesh_unit);
+    hashValue(h, radius);
+    hashValue(h, (int)mesh_type);
+    hashValue(h, reorder);
+    for (auto& p : polygon) {
+        hashValue(h, p.x);
+        hashValue(h, p.y);
+    }
+    return h;
+}
+
+bool MeshCache::matches(const Entry& entry, const std::vector<Vector2>& polygon, int mesh_unit, double radius, MESH_TYPE mesh_type, bool reorder) {
+    if (entry.mesh_unit != mesh_unit || entry.radius != radius || entry.mesh_type != mesh_type || entry.reorder != reorder)
+        return false;
+    if (entry.polygon.size() != polygon.size()) return false;
+    for (size_t i = 0; i < polygon.size(); i++) {
+        if (entry.polygon[i].x != polygon[i].x || entry.polygon[i].y != polygon[i].y) return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const MeshData> MeshCache::mesh(const std::vector<Vector2>& polygon, int mesh_unit, double radius, MESH_TYPE mesh_type, bool reorder) {
+    if (!isEnabled())
+        return std::make_shared<const MeshData>(meshPolygon(polygon, mesh_unit, radius, mesh_type, reorder));
+
+    std::shared_ptr<const MeshData> result = find(polygon, mesh_unit, radius, mesh_type, reorder);
+    if (!result) {
+        result = std::make_shared<const MeshData>(meshPolygon(polygon, mesh_unit, radius, mesh_type, reorder));
+        store(polygon, mesh_unit, radius, mesh_type, reorder, result);
+    }
+    return result;
+}
+
+std::shared_ptr<const MeshData> MeshCache::find(const std::vector<Vector2>& polygon, int mesh_unit, double radius, MESH_TYPE mesh_type, bool reorder) {
+    uint64_t k = key(polygon, mesh_unit, radius, mesh_type, reorder);
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = entries.find(k);
+    if (it != entries.end()) {
+        for (auto& entry : it->second) {
+            if (matches(entry, polygon, mesh_unit, radius, mesh_type, reorder)) {
+                hits++;
+                return entry.mesh;
+            }
+        }
+    }
+
+    Entry entry;
+    if (loadFile(k, entry) && matches(entry, polygon, mesh_unit, radius, mesh_type, reorder)) {
+        entries[k].push_back(entry);
+        hits++;
+        return entry.mesh;
+    }
+    misses++;
+    return nullptr;
+}
+
+void MeshCache::store(const std::vector<Vector2>& polygon, int mesh_unit, double radius, MESH_TYPE mesh_type, bool reorder,
+                      std::shared_ptr<const MeshData> mesh) {
+    uint64_t k = key(polygon, mesh_unit, radius, mesh_type, reorder);
+    Entry entry{polygon, mesh_unit, radius, mesh_type, reorder, std::move(mesh)};
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto& slot = entries[k];
+    for (auto& e : slot) {
+        if (matches(e, polygon, mesh_unit, radius, mesh_type, reorder)) {
+            e.mesh = entry.mesh;
+            return;
+        }
+    }
+    slot.push_back(entry);
+    saveFile(k, entry);
+}
+
+void MeshCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    hits = 0;
+    misses = 0;
+}
+
+void MeshCache::setDirectory(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    directory = path;
+}
+
+std::string MeshCache::getDirectory() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return directory;
+}
+
+size_t MeshCache::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t n = 0;
+    for (auto& [k, slot] : entries) n += slot.size();
+    return n;
+}
+
+// ---------------------------------------------------------------------------
+// On-disk store
+// ---------------------------------------------------------------------------
+
+std::string MeshCache::filePath(uint64_t k) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.cbor", (unsigned long long)k);
+    if (directory.empty() || directory.back() == '/') return directory + name;
+    return directory + "/" + name;
+}
+
+bool MeshCache::loadFile(uint64_t k, Entry& entry) const {
+    if (directory.empty()) return false;
+    TraceScope trace("MeshCache::loadFile", "mesh");
+    std::ifstream file(filePath(k), std::ios::binary);
+    if (!file) return false;
+
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    json data = json::from_cbor(bytes, true, false);
+    // value() throws on valid CBOR that is not an object
+    if (!data.is_object() || data.value("version", 0) != MESH_CACHE_VERSION) return false;
+
+    try {
+        entry.mesh_unit = data["mesh_unit"];
+        entry.radius = data["radius"];
+        entry.mesh_type = (MESH_TYPE)data["mesh_type"].get<int>();
+        entry.reorder = data["reorder"];
+        std::vector<double> poly = data["polygon"];
+        for (size_t i = 0; i + 1 < poly.size(); i += 2)
+            entry.polygon.push_back(Vector2(poly[i], poly[i+1]));
+
+        auto mesh = std::make_shared<MeshData>();
+        std::vector<double> points = data["points"];
+        for (size_t i = 0; i + 1 < points.size(); i += 2)
+            mesh->points.push_back(Vector2(points[i], points[i+1]));
+        std::vector<int> edges = data["edges"];
+        for (size_t i = 0; i + 1 < edges.size(); i += 2)
+            mesh->edges.push_back({edges[i], edges[i+1]});
+        mesh->border = data["border"].get<std::vector<int>>();
+        mesh->surface = data["surface"].get<std::vector<int>>();
+
+        // Reject files with out of range indices rather than crashing later
+        int n = (int)mesh->points.size();
+        for (auto& e : mesh->edges)
+            if (e.first < 0 || e.first >= n || e.second < 0 || e.second >= n) return false;
+        for (int b : mesh->border)
+            if (b < 0 || b >= n) return false;
+        for (int s : mesh->surface)
+            if (s < 0 || s >= n) return false;
+        entry.mesh = mesh;
+    } catch (const json::exception&) {
+        return false;
+    }
+    return true;
+}
+
+void MeshCache::saveFile(uint64_t k, const Entry& entry) const {
+    if (directory.empty()) return;
+    TraceScope trace("MeshCache::saveFile", "mesh");
+
+    // Flat arrays keep the file compact
+    std::vector<double> poly, points;
+    std::vector<int> edges;
+    for (auto& p : entry.polygon) { poly.push_back(p.x); poly.push_back(p.y); }
+    for (auto& p : entry.mesh->points) { points.push_back(p.x); points.push_back(p.y); }
+    for (auto& e : entry.mesh->edges) { edges.push_back(e.first); edges.push_back(e.second); }
+
+    json data;
+    data["version"] = MESH_CACHE_VERSION;
+    data["mesh_unit"] = entry.mesh_unit;
+    data["radius"] = entry.radius;
+    data["mesh_type"] = (int)entry.mesh_type;
+    data["reorder"] = entry.reorder;
+    data["polygon"] = poly;
+    data["points"] = points;
+    data["edges"] = edges;
+    data["border"] = entry.mesh->border;
+    data["surface"] = entry.mesh->surface;
+
+    std::vector<uint8_t> bytes = json::to_cbor(data);
+    std::ofstream file(filePath(k), std::ios::binary);
+    if (!file) return;
+    file.write((const char*)bytes.data(), (std::streamsize)bytes.size());
+}
@@ -0,0 +1,124 @@
+#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+using namespace sim;
+
+PerfCounters::PerfCounters() {
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        fds[i] = -1;
+        slot[i] = -1;
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    close();
+}
+
+#ifdef __linux__
+
+/**
+ * @brief Fill the perf_event_attr type and config of a counter.
+ */
+static void describe(PERF_COUNTER counter, perf_event_attr& attr) {
+    switch (counter) {
+    case CyclesCounter:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case InstructionsCounter:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case L1MissesCounter:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_L1D
+                    | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    case LLCMissesCounter:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_LL
+                    | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    case BranchMissesCounter:
+    default:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    }
+}
+
+bool PerfCounters::open() {
+    close();
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        describe((PERF_COUNTER)i, attr);
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.disabled = leader < 0 ? 1 : 0;    // the group starts with its leader
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        // pid 0 / cpu -1: this thread, on any CPU
+        int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+        if (fd < 0) continue;  // unsupported or not permitted, e.g. in containers
+        if (leader < 0) leader = fd;
+        fds[i] = fd;
+        slot[i] = opened++;
+    }
+    if (leader < 0) return false;
+
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+void PerfCounters::close() {
+    if (leader >= 0)
+        ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    // members first, the leader last
+    for (int i = COUNTER_COUNT - 1; i >= 0; i--) {
+        if (fds[i] >= 0 && fds[i] != leader) ::close(fds[i]);
+        fds[i] = -1;
+        slot[i] = -1;
+    }
+    if (leader >= 0) ::close(leader);
+    leader = -1;
+    opened = 0;
+}
+
+void PerfCounters::read(uint64_t values[COUNTER_COUNT]) const {
+    for (int i = 0; i < COUNTER_COUNT; i++) values[i] = 0;
+    if (leader < 0) return;
+
+    // PERF_FORMAT_GROUP layout: { nr, value[nr] }
+    uint64_t buffer[1 + COUNTER_COUNT];
+    ssize_t n = ::read(leader, buffer, sizeof(buffer));
+    if (n < (ssize_t)sizeof(uint64_t)) return;
+    uint64_t nr = buffer[0];
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        if (slot[i] >= 0 && (uint64_t)slot[i] < nr)
+            values[i] = buffer[1 + slot[i]];
+    }
+}
+
+#else
+
+bool PerfCounters::open() { return false; }
+
+void PerfCounters::close() {}
+
+void PerfCounters::read(uint64_t values[COUNTER_COUNT]) const {
+    for (int i = 0; i < COUNTER_COUNT; i++) values[i] = 0;
+}
+
+#endif
@@ -19,32 +19,58 @@ bool PlaneCollider::collide(Particle* p, double friction, double restitution) {
         // --- Velocity (Verlet displacement) ---
         Vector2 vel = p->getPosition() - p->getPrevPosition();
 
-        // --- Positional correction ---
-        p->setPosition(p->getPosition() + normal * penetration);
+        respond(p, p->getPosition() + normal * penetration, normal, vel, friction, restitution);
 
-        // --- Effective coefficients ---
-        double effectiveFriction    = 0.5 * (worldFriction + friction);
-        double effectiveRestitution = std::min(worldRestitution, restitution);
+        return true;
+    }
+    return false;
+}
+
+bool PlaneCollider::collideSwept(Particle* p, double friction, double restitution) {
+    if (p->isPinned()) return false;
 
-        // --- Decompose velocity ---
-        double velAlongNormal = vel.dot(normal);
-        Vector2 tangentVel = vel - velAlongNormal * normal;
+    double r = p->getRadius();
+    double d0 = p->getPrevPosition().dot(normal) - d;
+    if (d0 < r) return collide(p, friction, restitution);
+    double d1 = p->getPosition().dot(normal) - d;
+    if (d1 >= r) return false;
 
-        // --- Apply restitution on normal axis ---
-        Vector2 correctedNormal = effectiveRestitution * velAlongNormal * normal;
+    // Time of impact of the disc on the plane
+    Vector2 vel = p->getPosition() - p->getPrevPosition();
+    double t = (d0 - r) / (d0 - d1);
+    respond(p, p->getPrevPosition() + vel * t, normal, vel, friction, restitution);
+    return true;
+}
+
+bool PlaneCollider::mayCollide(const AABB& box) const {
+    // Lowest point of the box along the normal
+    double x = normal.x > 0 ? box.min.x : box.max.x;
+    double y = normal.y > 0 ? box.min.y : box.max.y;
+    return x * normal.x + y * normal.y - d <= 0.0;
+}
 
-        // --- Apply friction on tangent axis ---
-        Vector2 correctedTangent = (1.0 - effectiveFriction) * tangentVel;
+double PlaneCollider::signedDistance(const Vector2& point) const {
+    return point.dot(normal) - d;
+}
 
-        // --- New corrected velocity ---
-        Vector2 correctedVel = correctedNormal - correctedTangent;
+void PlaneCollider::collideBatch(ParticleBatch& batch, double friction, double restitution) {
+    const size_t n = batch.size();
+    const double* x = batch.x.data();
+    const double* y = batch.y.data();
+    const double* r = batch.radius.data();
+    const uint8_t* active = batch.active.data();
+    uint8_t* hit = batch.hit.data();
+    const double nx = normal.x, ny = normal.y;
 
-        // --- Update prevPosition with corrected velocity ---
-        p->setPrevPosition(p->getPosition() + correctedVel);
+    // Pass 1: penetration test, no branches
+    for (size_t i = 0; i < n; i++)
+        hit[i] = active[i] & (x[i] * nx + y[i] * ny - d < r[i]);
 
-        return true;
+    // Pass 2: response on the flagged particles
+    for (size_t i = 0; i < n; i++) {
+        if (!hit[i]) continue;
+        if (PlaneCollider::collide(batch.particles[i], friction, restitution)) batch.sync(i);
     }
-    return false;
 }
 
 json PlaneCollider::as_json()
@@ -53,5 +79,8 @@ json PlaneCollider::as_json()
     data["ColliderType"] = COLLIDER_TYPE::PlaneColliderType;
     data["point"] = normal.as_json();
     data["distance"] = d;
+    data["friction"] = worldFriction;
+    data["restitution"] = worldRestitution;
+    data["collision_mask"] = collision_mask;
     return data;
 }
@@ -0,0 +1,187 @@
+#include "SDFWorldCollider.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+using namespace sim;
+
+SDFCollider::SDFCollider(Vector2 origin, double cell, int width, int height, std::vector<double> distances,
+                         double friction, double restitution)
+    : WorldCollider(friction, restitution), origin(origin), cell(cell), width(width), height(height),
+      distances(std::move(distances))
+{
+    if (width < 2 || height < 2 || cell <= 0.0)
+        throw std::invalid_argument("SDFCollider: the grid needs at least 2x2 nodes and a positive cell");
+    if (this->distances.size() != (size_t)width * height)
+        throw std::invalid_argument("SDFCollider: distances do not match the grid size");
+    computeGradients();
+}
+
+// --- Baking ----
+
+/**
+ * @brief Signed distance to a polygon, negative inside (even-odd rule).
+ */
+static double polygonDistance(const std::vector<Vector2>& polygon, const Vector2& p) {
+    double best = std::numeric_limits<double>::infinity();
+    bool inside = false;
+    size_t n = polygon.size();
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        const Vector2& a = polygon[j];
+        const Vector2& b = polygon[i];
+
+        // Distance to the edge
+        Vector2 ab = b - a;
+        double len2 = ab.dot(ab);
+        double t = len2 > 0.0 ? std::clamp((p - a).dot(ab) / len2, 0.0, 1.0) : 0.0;
+        best = std::min(best, (p - (a + ab * t)).length());
+
+        // Crossing of a ray toward +x
+        if ((a.y > p.y) != (b.y > p.y) && p.x < a.x + (p.y - a.y) / (b.y - a.y) * (b.x - a.x))
+            inside = !inside;
+    }
+    return inside ? -best : best;
+}
+
+SDFCollider* SDFCollider::bake(const AABB& bounds, double cell,
+                               const std::vector<std::vector<Vector2>>& polygons,
+                               const std::vector<const WorldCollider*>& colliders,
+                               double friction, double restitution)
+{
+    TraceScope trace("SDFCollider::bake", "mesh");
+    if (cell <= 0.0)
+        throw std::invalid_argument("SDFCollider::bake: cell must be positive");
+
+    int width = std::max(2, (int)std::ceil((bounds.max.x - bounds.min.x) / cell) + 1);
+    int height = std::max(2, (int)std::ceil((bounds.max.y - bounds.min.y) / cell) + 1);
+
+    // Nodes far from any geometry are clamped so the field stays finite
+    double far = (bounds.max - bounds.min).length() + cell;
+
+    std::vector<double> distances((size_t)width * height);
+    for (int j = 0; j < height; j++) {
+        for (int i = 0; i < width; i++) {
+            Vector2 p(bounds.min.x + i * cell, bounds.min.y + j * cell);
+            double d = far;
+            for (auto& polygon : polygons)
+                if (polygon.size() >= 3) d = std::min(d, polygonDistance(polygon, p));
+            for (auto* c : colliders)
+                d = std::min(d, c->signedDistance(p));
+            distances[(size_t)j * width + i] = d;
+        }
+    }
+    return new SDFCollider(bounds.min, cell, width, height, std::move(distances), friction, restitution);
+}
+
+void SDFCollider::computeGradients() {
+    // Central differences, one-sided on the border of the grid
+    gradients.resize(distances.size());
+    auto at = [&](int i, int j) { return distances[(size_t)j * width + i]; };
+    for (int j = 0; j < height; j++) {
+        for (int i = 0; i < width; i++) {
+            int i0 = std::max(i - 1, 0), i1 = std::min(i + 1, width - 1);
+            int j0 = std::max(j - 1, 0), j1 = std::min(j + 1, height - 1);
+            gradients[(size_t)j * width + i] = Vector2(
+                (at(i1, j) - at(i0, j)) / ((i1 - i0) * cell),
+                (at(i, j1) - at(i, j0)) / ((j1 - j0) * cell));
+        }
+    }
+
+    // Each partial derivative of the bilinear field is bounded by the steepest
+    // edge of the grid, 1 for exact distances
+    double edge = 0.0;
+    for (int j = 0; j < height; j++) {
+        for (int i = 0; i < width; i++) {
+            if (i + 1 < width) edge = std::max(edge, std::abs(at(i + 1, j) - at(i, j)));
+            if (j + 1 < height) edge = std::max(edge, std::abs(at(i, j + 1) - at(i, j)));
+        }
+    }
+    slope = std::max(1.0, std::sqrt(2.0) * edge / cell);
+}
+
+// --- Queries ----
+
+double SDFCollider::sample(const Vector2& point, Vector2& gradient) const {
+    double fx = std::clamp((point.x - origin.x) / cell, 0.0, (double)(width - 1));
+    double fy = std::clamp((point.y - origin.y) / cell, 0.0, (double)(height - 1));
+    int i = std::min((int)fx, width - 2);
+    int j = std::min((int)fy, height - 2);
+    double tx = fx - i, ty = fy - j;
+
+    size_t k00 = (size_t)j * width + i, k10 = k00 + 1;
+    size_t k01 = k00 + width, k11 = k01 + 1;
+    double w00 = (1 - tx) * (1 - ty), w10 = tx * (1 - ty);
+    double w01 = (1 - tx) * ty, w11 = tx * ty;
+
+    gradient = gradients[k00] * w00 + gradients[k10] * w10 + gradients[k01] * w01 + gradients[k11] * w11;
+    return distances[k00] * w00 + distances[k10] * w10 + distances[k01] * w01 + distances[k11] * w11;
+}
+
+double SDFCollider::signedDistance(const Vector2& point) const {
+    Vector2 gradient;
+    return sample(point, gradient);
+}
+
+double SDFCollider::clearance(const Vector2& point) const {
+    // Outside the grid collide() does nothing, the clamped sample is still a bound
+    return signedDistance(point) / slope;
+}
+
+AABB SDFCollider::getBounds() const {
+    return { origin, Vector2(origin.x + (width - 1) * cell, origin.y + (height - 1) * cell) };
+}
+
+bool SDFCollider::mayCollide(const AABB& box) const {
+    if (!aabbOverlap(box, getBounds())) return false;
+
+    // The bilinear field varies at most slope times as fast as the distance,
+    // so a center far enough from the geometry clears the whole box
+    Vector2 center = (box.min + box.max) * 0.5;
+    AABB grid = getBounds();
+    if (center.x < grid.min.x || center.x > grid.max.x || center.y < grid.min.y || center.y > grid.max.y)
+        return true;
+    double halfDiagonal = (box.max - box.min).length() * 0.5;
+    return signedDistance(center) <= slope * halfDiagonal;
+}
+
+bool SDFCollider::collide(Particle* p, double friction, double restitution) {
+    if (p->isPinned()) return false;
+
+    Vector2 pos = p->getPosition();
+    AABB grid = getBounds();
+    if (pos.x < grid.min.x || pos.x > grid.max.x || pos.y < grid.min.y || pos.y > grid.max.y)
+        return false;
+
+    Vector2 gradient;
+    double dist = sample(pos, gradient);
+    double penetration = p->getRadius() - dist;
+    if (penetration <= 0.0) return false;
+
+    double length = gradient.length();
+    Vector2 n = length > 0.0 ? gradient / length : Vector2(0, 1); // Collision normal
+
+    Vector2 vel = pos - p->getPrevPosition();
+
+    respond(p, pos + n * penetration, n, vel, friction, restitution);
+
+    return true;
+}
+
+// --- Saver & Loader ----
+
+json SDFCollider::as_json()
+{
+    json data;
+    data["ColliderType"] = COLLIDER_TYPE::SDFColliderType;
+    data["origin"] = origin.as_json();
+    data["cell"] = cell;
+    data["width"] = width;
+    data["height"] = height;
+    data["distances"] = distances;
+    data["friction"] = worldFriction;
+    data["restitution"] = worldRestitution;
+    data["collision_mask"] = collision_mask;
+    return data;
+}
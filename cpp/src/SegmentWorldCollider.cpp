@@ -0,0 +1,332 @@
+#include "SegmentWorldCollider.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+
+using namespace sim;
+
+// Segments per BVH leaf
+static constexpr int LEAF_SIZE = 4;
+// Above this many segments near a body, particles query the tree one by one
+static constexpr size_t DIRECT_CANDIDATES = 64;
+
+SegmentMeshCollider::SegmentMeshCollider(std::vector<Segment> segments, double friction, double restitution)
+    : WorldCollider(friction, restitution), segments(std::move(segments))
+{
+    TraceScope trace("SegmentMeshCollider::build", "mesh");
+    int n = (int)this->segments.size();
+    boxes.reserve(n);
+    order.reserve(n);
+    for (int i = 0; i < n; i++) {
+        const Segment& s = this->segments[i];
+        boxes.push_back({ Vector2(std::min(s.a.x, s.b.x), std::min(s.a.y, s.b.y)),
+                          Vector2(std::max(s.a.x, s.b.x), std::max(s.a.y, s.b.y)) });
+        order.push_back(i);
+    }
+    if (n > 0) {
+        nodes.reserve(2 * (n / LEAF_SIZE + 1));
+        build(0, n);
+    }
+}
+
+std::vector<Segment> SegmentMeshCollider::polyline(const std::vector<Vector2>& points, bool closed) {
+    std::vector<Segment> out;
+    for (size_t i = 0; i + 1 < points.size(); i++)
+        out.push_back({ points[i], points[i + 1] });
+    if (closed && points.size() > 2)
+        out.push_back({ points.back(), points.front() });
+    return out;
+}
+
+int SegmentMeshCollider::build(int begin, int end) {
+    int index = (int)nodes.size();
+    nodes.push_back({});
+
+    AABB box = boxes[order[begin]];
+    for (int i = begin + 1; i < end; i++) {
+        const AABB& b = boxes[order[i]];
+        box.min = Vector2(std::min(box.min.x, b.min.x), std::min(box.min.y, b.min.y));
+        box.max = Vector2(std::max(box.max.x, b.max.x), std::max(box.max.y, b.max.y));
+    }
+    nodes[index].box = box;
+
+    if (end - begin <= LEAF_SIZE) {
+        nodes[index].first = begin;
+        nodes[index].count = end - begin;
+        return index;
+    }
+
+    // Median split of the centers along the longest axis
+    bool alongX = box.max.x - box.min.x >= box.max.y - box.min.y;
+    auto center = [&](int s) {
+        const AABB& b = boxes[s];
+        return alongX ? b.min.x + b.max.x : b.min.y + b.max.y;
+    };
+    int mid = (begin + end) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+                     [&](int l, int r) { return center(l) < center(r); });
+
+    build(begin, mid);
+    int right = build(mid, end);
+    nodes[index].first = right;
+    nodes[index].count = 0;
+    return index;
+}
+
+void SegmentMeshCollider::query(const AABB& box, std::vector<int>& out) const {
+    forEachOverlap(box, [&](int s) { out.push_back(s); });
+}
+
+bool SegmentMeshCollider::resolve(Particle* p, const Segment& s, double friction, double restitution) {
+    Vector2 pos = p->getPosition();
+    double radius = p->getRadius();
+
+    // Closest point of the segment
+    Vector2 ab = s.b - s.a;
+    double len2 = ab.dot(ab);
+    double t = len2 > 0.0 ? std::clamp((pos - s.a).dot(ab) / len2, 0.0, 1.0) : 0.0;
+    Vector2 closest = s.a + ab * t;
+
+    Vector2 toP = pos - closest;
+    double dist = toP.length();
+    if (dist >= radius) return false;
+
+    Vector2 vel = pos - p->getPrevPosition();
+    Vector2 n; // Collision normal
+    if (dist > 0.0) {
+        n = toP / dist;
+    } else {
+        // On the segment: go back to the side the particle came from
+        n = len2 > 0.0 ? Vector2(-ab.y, ab.x) / std::sqrt(len2) : Vector2(0, 1);
+        if (n.dot(vel) > 0.0) n = -n;
+    }
+
+    respond(p, closest + n * radius, n, vel, friction, restitution);
+
+    return true;
+}
+
+/**
+ * @brief Distance from a point to a box, 0 inside.
+ */
+static double boxDistance(const AABB& box, const Vector2& p) {
+    double dx = std::max({ box.min.x - p.x, 0.0, p.x - box.max.x });
+    double dy = std::max({ box.min.y - p.y, 0.0, p.y - box.max.y });
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+double SegmentMeshCollider::clearance(const Vector2& point) const {
+    double best = std::numeric_limits<double>::infinity();
+    if (nodes.empty()) return best;
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (boxDistance(node.box, point) >= best) continue;
+        if (node.count > 0) {
+            for (int i = node.first; i < node.first + node.count; i++) {
+                const Segment& s = segments[order[i]];
+                Vector2 ab = s.b - s.a;
+                double len2 = ab.dot(ab);
+                double t = len2 > 0.0 ? std::clamp((point - s.a).dot(ab) / len2, 0.0, 1.0) : 0.0;
+                best = std::min(best, (point - (s.a + ab * t)).length());
+            }
+        } else {
+            // Nearer child last, so that it is visited first
+            int self = (int)(&node - nodes.data());
+            int left = self + 1, right = node.first;
+            if (boxDistance(nodes[left].box, point) < boxDistance(nodes[right].box, point)) std::swap(left, right);
+            stack[top++] = left;
+            stack[top++] = right;
+        }
+    }
+    return best;
+}
+
+bool SegmentMeshCollider::collide(Particle* p, double friction, double restitution) {
+    if (p->isPinned()) return false;
+
+    Vector2 pos = p->getPosition();
+    double r = p->getRadius();
+    bool collided = false;
+    forEachOverlap({ Vector2(pos.x - r, pos.y - r), Vector2(pos.x + r, pos.y + r) }, [&](int s) {
+        collided |= resolve(p, segments[s], friction, restitution);
+    });
+    return collided;
+}
+
+/**
+ * @brief Time of impact of a disc moving along p0 + t * v on a segment.
+ *
+ * A disc already touching the segment hits it at t = 0, pushed out on the
+ * side of p0.
+ *
+ * @param t Receives the time of impact in [0, 1]
+ * @param n Receives the collision normal
+ * @param contact Receives the position of the disc at the impact
+ * @return Whether the disc hits the segment during the motion
+ */
+static bool sweepSegment(const Vector2& p0, const Vector2& v, double r, const Segment& s,
+                         double& t, Vector2& n, Vector2& contact) {
+    Vector2 ab = s.b - s.a;
+    double len2 = ab.dot(ab);
+    double u0 = len2 > 0.0 ? std::clamp((p0 - s.a).dot(ab) / len2, 0.0, 1.0) : 0.0;
+    Vector2 closest = s.a + ab * u0;
+    double dist = (p0 - closest).length();
+    if (dist < r) {
+        if (dist > 0.0) {
+            n = (p0 - closest) / dist;
+        } else {
+            n = len2 > 0.0 ? Vector2(-ab.y, ab.x) / std::sqrt(len2) : Vector2(0, 1);
+            if (n.dot(v) > 0.0) n = -n;
+        }
+        t = 0.0;
+        contact = closest + n * r;
+        return true;
+    }
+
+    double best = 2.0;
+
+    // Sides of the segment, offset by the radius
+    if (len2 > 0.0) {
+        Vector2 m = Vector2(-ab.y, ab.x) / std::sqrt(len2);
+        double g0 = (p0 - s.a).dot(m);
+        double side = g0 >= 0.0 ? 1.0 : -1.0;
+        double approach = v.dot(m) * side;
+        if (approach < 0.0) {
+            double ts = (g0 * side - r) / -approach;
+            double u = (p0 + v * ts - s.a).dot(ab) / len2;
+            if (ts >= 0.0 && ts <= 1.0 && u >= 0.0 && u <= 1.0) {
+                best = ts;
+                n = m * side;
+            }
+        }
+    }
+
+    // Rounded ends
+    double a = v.dot(v);
+    for (const Vector2& end : { s.a, s.b }) {
+        Vector2 f = p0 - end;
+        double b = f.dot(v);
+        double disc = b * b - a * (f.dot(f) - r * r);
+        if (a == 0.0 || b >= 0.0 || disc < 0.0) continue;
+        double te = (-b - std::sqrt(disc)) / a;
+        if (te >= 0.0 && te < best) {
+            best = te;
+            n = (p0 + v * te - end) / r;
+        }
+    }
+
+    if (best > 1.0) return false;
+    t = best;
+    contact = p0 + v * t;
+    return true;
+}
+
+bool SegmentMeshCollider::collideSwept(Particle* p, double friction, double restitution) {
+    if (p->isPinned()) return false;
+
+    Vector2 p0 = p->getPrevPosition();
+    Vector2 p1 = p->getPosition();
+    Vector2 vel = p1 - p0;
+    double r = p->getRadius();
+    AABB sweep = { Vector2(std::min(p0.x, p1.x) - r, std::min(p0.y, p1.y) - r),
+                   Vector2(std::max(p0.x, p1.x) + r, std::max(p0.y, p1.y) + r) };
+
+    // Earliest impact over the segments near the motion
+    double first = 2.0;
+    Vector2 normal, contact;
+    forEachOverlap(sweep, [&](int s) {
+        double t;
+        Vector2 n, c;
+        if (sweepSegment(p0, vel, r, segments[s], t, n, c) && t < first) {
+            first = t;
+            normal = n;
+            contact = c;
+        }
+    });
+    if (first > 1.0) return false;
+
+    respond(p, contact, normal, vel, friction, restitution);
+    // Other segments touching the contact position, resolved on the side it is on
+    collide(p, friction, restitution);
+    return true;
+}
+
+bool SegmentMeshCollider::mayCollide(const AABB& box) const {
+    return !nodes.empty() && aabbOverlap(nodes[0].box, box);
+}
+
+void SegmentMeshCollider::collideBatch(ParticleBatch& batch, double friction, double restitution) {
+    const size_t n = batch.size();
+    if (n == 0 || nodes.empty()) return;
+
+    // One traversal for the bounds of the whole batch
+    AABB box = { Vector2(batch.x[0], batch.y[0]), Vector2(batch.x[0], batch.y[0]) };
+    for (size_t i = 0; i < n; i++) {
+        box.min = Vector2(std::min(box.min.x, batch.x[i] - batch.radius[i]), std::min(box.min.y, batch.y[i] - batch.radius[i]));
+        box.max = Vector2(std::max(box.max.x, batch.x[i] + batch.radius[i]), std::max(box.max.y, batch.y[i] + batch.radius[i]));
+    }
+    std::vector<int> candidates;
+    query(box, candidates);
+    if (candidates.empty()) return;
+
+    // Many candidates: per particle traversals are cheaper than scanning them all
+    if (candidates.size() > DIRECT_CANDIDATES) {
+        for (size_t i = 0; i < n; i++) {
+            if (batch.active[i] && SegmentMeshCollider::collide(batch.particles[i], friction, restitution))
+                batch.sync(i);
+        }
+        return;
+    }
+
+    // Few candidates: scan them, they come in tree order so the result matches collide()
+    for (size_t i = 0; i < n; i++) {
+        if (!batch.active[i]) continue;
+        double x = batch.x[i], y = batch.y[i], r = batch.radius[i];
+        AABB disc = { Vector2(x - r, y - r), Vector2(x + r, y + r) };
+        bool collided = false;
+        for (int s : candidates) {
+            if (aabbOverlap(boxes[s], disc))
+                collided |= resolve(batch.particles[i], segments[s], friction, restitution);
+        }
+        if (collided) batch.sync(i);
+    }
+}
+
+// --- Saver & Loader ----
+
+json SegmentMeshCollider::as_json()
+{
+    // Flat array of a.x, a.y, b.x, b.y per segment
+    std::vector<double> flat;
+    flat.reserve(segments.size() * 4);
+    for (auto& s : segments) {
+        flat.push_back(s.a.x);
+        flat.push_back(s.a.y);
+        flat.push_back(s.b.x);
+        flat.push_back(s.b.y);
+    }
+    json data;
+    data["ColliderType"] = COLLIDER_TYPE::SegmentMeshColliderType;
+    data["segments"] = flat;
+    data["friction"] = worldFriction;
+    data["restitution"] = worldRestitution;
+    data["collision_mask"] = collision_mask;
+    return data;
+}
+
+std::vector<uint8_t> SegmentMeshCollider::to_cbor() {
+    return json::to_cbor(as_json());
+}
+
+SegmentMeshCollider* SegmentMeshCollider::from_cbor(const std::vector<uint8_t>& bytes) {
+    json data = json::from_cbor(bytes, true, false);
+    if (data.is_discarded() || data.value("ColliderType", -1) != COLLIDER_TYPE::SegmentMeshColliderType)
+        throw std::invalid_argument("SegmentMeshCollider::from_cbor: not a segment mesh collider");
+    return static_cast<SegmentMeshCollider*>(WorldCollider::from_json(data));
+}
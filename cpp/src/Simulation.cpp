@@ -1,36 +1,193 @@
 #include "Simulation.h"
+#include "Morton.h"
+#include "Trace.h"
 #include <cmath>
+#include <chrono>
 #include <algorithm>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <typeinfo>
+#include <unordered_map>
 
 using namespace sim;
 
+/**
+ * @brief RAII helper timing a step phase into the statistics and the trace.
+ *
+ * When counters are given, their deltas over the phase are added as well.
+ */
+class PhaseScope {
+public:
+    PhaseScope(StepStats& stats, STEP_PHASE phase, const PerfCounters* counters = nullptr)
+        : stats(stats), phase(phase), counters(counters), trace(phaseName(phase), "step") {
+        if (counters) counters->read(counters_start);
+        start = std::chrono::steady_clock::now();
+    }
+    ~PhaseScope() {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        stats.phase_ms[phase] += elapsed.count();
+        if (counters) {
+            uint64_t counters_end[COUNTER_COUNT];
+            counters->read(counters_end);
+            for (int i = 0; i < COUNTER_COUNT; i++)
+                stats.phase_counters[phase][i] += counters_end[i] - counters_start[i];
+        }
+    }
+
+private:
+    StepStats& stats;
+    STEP_PHASE phase;
+    const PerfCounters* counters;
+    TraceScope trace;
+    uint64_t counters_start[COUNTER_COUNT];
+    std::chrono::steady_clock::time_point start;
+};
+
 void Simulation::addBody(SoftBody* body) {
     bodies.push_back(body);
 }
 
 void Simulation::addCollider(WorldCollider* col) {
     colliders.push_back(col);
+    // Exact types only: a subclass may override collide()
+    if (typeid(*col) == typeid(PlaneCollider))
+        planes.push_back(static_cast<PlaneCollider*>(col));
+    else if (typeid(*col) == typeid(InnerCircleCollider))
+        inner_circles.push_back(static_cast<InnerCircleCollider*>(col));
+    else if (typeid(*col) == typeid(OuterCircleCollider))
+        outer_circles.push_back(static_cast<OuterCircleCollider*>(col));
+    else if (typeid(*col) == typeid(SegmentMeshCollider))
+        segment_meshes.push_back(static_cast<SegmentMeshCollider*>(col));
+    else
+        other_colliders.push_back(col);
+    // The bounds of the particles do not account for the new collider
+    resetClearance();
 }
 
 Simulation::~Simulation(){
     clear();
 }
 
+void Simulation::setPerfCounters(bool enable) {
+    perf_enabled = enable;
+    if (!enable) {
+        counters.close();
+        perf_thread = std::thread::id();
+        for (auto& a : stats.counters_available) a = false;
+    }
+}
+
+void Simulation::setSpikeCapture(double threshold_ms, const std::string& file_path) {
+    spike_threshold_ms = threshold_ms;
+    spike_file = file_path;
+    worst_spike_ms = 0.0;
+    spike_state.clear();
+}
+
+void Simulation::captureState() {
+    spike_state.clear();
+    for (auto& b : bodies) {
+        for (auto& p : b->getParticles()) {
+            spike_state.push_back(p->getPosition().x);
+            spike_state.push_back(p->getPosition().y);
+            spike_state.push_back(p->getPrevPosition().x);
+            spike_state.push_back(p->getPrevPosition().y);
+        }
+    }
+}
+
+void Simulation::saveSpike(double dt, double step_ms) {
+    TraceScope trace("saveSpike", "io");
+    json data = as_json();
+    data["state"] = json::array();
+    size_t offset = 0;
+    for (auto& b : bodies) {
+        size_t n = 4 * b->getParticles().size();
+        data["state"].push_back(json(std::vector<double>(
+            spike_state.begin() + offset, spike_state.begin() + offset + n)));
+        offset += n;
+    }
+    data["dt"] = dt;
+    data["step_ms"] = step_ms;
+    data["step_index"] = stats.steps;
+
+    std::ofstream file(spike_file);
+    if (file.is_open()) {
+        file << data;
+    } else {
+        std::cerr << "Error: " << spike_file << " is not valid!\n";
+    }
+}
+
 void Simulation::step(double dt)
 {
+    TraceScope trace("step", "step");
+    bool capture = spike_threshold_ms > 0.0;
+    if (capture) captureState();
+
+    auto start = std::chrono::steady_clock::now();
+    stats.beginStep();
+    stats.bodies = bodies.size();
+    stats.particles = 0;
+    stats.constraints = 0;
+    for (auto& b : bodies) {
+        stats.particles += b->getParticles().size();
+        stats.constraints += b->getConstraints().size();
+        if (auto proto = b->getPrototype()) stats.constraints += proto->getEdges().size();
+    }
+
+    // Counters only measure the thread that opened them
+    if (perf_enabled && perf_thread != std::this_thread::get_id()) {
+        perf_thread = std::this_thread::get_id();
+        counters.open();
+        for (int i = 0; i < COUNTER_COUNT; i++)
+            stats.counters_available[i] = counters.isAvailable((PERF_COUNTER)i);
+    }
+    const PerfCounters* pc = counters.isOpen() ? &counters : nullptr;
+
+    // 0. Keep the particle storage in spatial order
+    if (sort_interval > 0 && ++steps_since_sort >= sort_interval) {
+        PhaseScope phase(stats, SortPhase, pc);
+        sortParticles();
+        steps_since_sort = 0;
+    }
 
     // 1. Apply global forces (gravity, wind, etc.)
-    applyGravity();
+    {
+        PhaseScope phase(stats, GravityPhase, pc);
+        applyGravity();
+    }
 
     // 2. Satisfy constraints (distance constraints, springs, etc.)
-    applyConstraints();
+    {
+        PhaseScope phase(stats, ConstraintsPhase, pc);
+        applyConstraints();
+    }
 
     // 3. Resolve collisions (world boundaries, objects, etc.)
     resolveCollisions(dt);
 
     // 4. Integrate particles (Verlet integration)
-    updateObjects(dt);
+    {
+        PhaseScope phase(stats, IntegrationPhase, pc);
+        updateObjects(dt);
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    stats.step_ms = std::chrono::duration<double, std::milli>(elapsed).count();
+    stats.steps++;
+    step_histogram.record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+
+    if (capture && stats.step_ms > spike_threshold_ms) {
+        stats.spikes++;
+        if (stats.step_ms > worst_spike_ms) {
+            worst_spike_ms = stats.step_ms;
+            saveSpike(dt, stats.step_ms);
+        }
+    }
 }
 
 void Simulation::clear() {
@@ -39,26 +196,109 @@ void Simulation::clear() {
             delete c;
         }
         for (auto& p: b->getParticles()) {
-            delete p;
+            if (!inStore(p)) delete p;
         }
-        b->getParticles().clear();
-        b->getConstraints().clear();
         delete b;
     }
     bodies.clear();
+    particle_store.clear();
 
     for (auto& c: colliders) {
         delete c;
     }
     colliders.clear();
+    planes.clear();
+    inner_circles.clear();
+    outer_circles.clear();
+    segment_meshes.clear();
+    contacts.clear();
+    edge_trees.clear();
+    body_spheres.clear();
+    rest_centers.clear();
+    other_colliders.clear();
+}
+
+bool Simulation::inStore(const Particle* p) const {
+    std::less<const Particle*> before;
+    const Particle* begin = particle_store.data();
+    return !particle_store.empty() && !before(p, begin) && before(p, begin + particle_store.size());
+}
+
+void Simulation::sortParticles() {
+    TraceScope trace("sortParticles", "step");
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<Particle*> all;
+    for (auto& b : bodies) {
+        for (auto p : b->getParticles()) all.push_back(p);
+    }
+    size_t n = all.size();
+    if (n == 0) return;
+
+    // Morton code of the positions quantized on 16 bits over the scene bounds
+    Vector2 lo = all[0]->getPosition(), hi = lo;
+    for (auto p : all) {
+        const Vector2& pos = p->getPosition();
+        lo = Vector2(std::min(lo.x, pos.x), std::min(lo.y, pos.y));
+        hi = Vector2(std::max(hi.x, pos.x), std::max(hi.y, pos.y));
+    }
+    double scale = 65535.0 / std::max({hi.x - lo.x, hi.y - lo.y, 1e-9});
+    std::vector<uint64_t> codes(n);
+    for (size_t i = 0; i < n; i++) {
+        Vector2 q = (all[i]->getPosition() - lo) * scale;
+        codes[i] = mortonCode((uint32_t)q.x, (uint32_t)q.y);
+    }
+    std::vector<uint32_t> order(n);
+    for (size_t i = 0; i < n; i++) order[i] = (uint32_t)i;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return codes[a] < codes[b]; });
+
+    // Copy into the new storage; reserve keeps the addresses stable while filling it
+    std::vector<Particle> store;
+    store.reserve(n);
+    std::vector<Particle*> moved(n);
+    for (uint32_t i : order) {
+        store.push_back(*all[i]);
+        moved[i] = &store.back();
+    }
+
+    // Remap table: particles of the previous storage are found by offset,
+    // particles of bodies added since then by address
+    std::vector<Particle*> from_store(particle_store.size(), nullptr);
+    std::unordered_map<Particle*, Particle*> from_heap;
+    for (size_t i = 0; i < n; i++) {
+        if (inStore(all[i])) from_store[all[i] - particle_store.data()] = moved[i];
+        else from_heap[all[i]] = moved[i];
+    }
+    auto remap = [&](Particle* p) {
+        if (inStore(p)) return from_store[p - particle_store.data()];
+        auto it = from_heap.find(p);
+        return it != from_heap.end() ? it->second : p;
+    };
+    for (auto& b : bodies) b->remapParticles(remap);
+
+    // The heap particles were copied, the store now owns them
+    for (auto& [old, _] : from_heap) delete old;
+    particle_store.swap(store);
+
+    stats.sorts++;
+    stats.sort_total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
 json Simulation::as_json()
 {
     json data;
     data["gravity"] = gravity.as_json();
-    for (auto b: bodies)
-        data["bodies"].push_back(b->as_json());
+    // Instanced bodies refer to a shared list of prototypes, each saved once
+    std::unordered_map<const SoftBodyPrototype*, int> prototypes;
+    for (auto b: bodies) {
+        json jb = b->as_json();
+        if (b->getPrototype()) {
+            auto [it, added] = prototypes.insert({b->getPrototype().get(), (int)prototypes.size()});
+            if (added) data["prototypes"].push_back(jb["prototype"]);
+            jb["prototype"] = it->second;
+        }
+        data["bodies"].push_back(jb);
+    }
     for (auto c: colliders)
         data["colliders"].push_back(c->as_json());
     return data;
@@ -68,10 +308,32 @@ void Simulation::from_json(json data)
 {
     this->clear();
     this->setGravity(Vector2::from_json(data["gravity"]));
-    for (auto jb: data["bodies"])
-        this->addBody(SoftBody::from_json(jb));
+    std::vector<std::shared_ptr<const SoftBodyPrototype>> prototypes;
+    for (auto& jp: data.value("prototypes", json::array()))
+        prototypes.push_back(SoftBodyPrototype::from_json(jp));
+    for (auto jb: data["bodies"]) {
+        if (jb.contains("prototype") && jb["prototype"].is_number()) {
+            SoftBody* body = SoftBody::instantiate(prototypes.at(jb["prototype"].get<size_t>()),
+                Vector2::from_json(jb["translation"]), jb["rotation"]);
+            body->setFriction(jb["friction"]);
+            body->setRestitution(jb["restitution"]);
+            body->setCollisionLayer(jb.value("collision_layer", 1u));
+            body->setCollisionMask(jb.value("collision_mask", 1u));
+            this->addBody(body);
+        } else {
+            this->addBody(SoftBody::from_json(jb));
+        }
+    }
     for (auto jc: data["colliders"])
         this->addCollider(WorldCollider::from_json(jc));
+
+    // Snapshots also carry the dynamic state of the particles
+    if (data.contains("state")) {
+        for (size_t i = 0; i < bodies.size() && i < data["state"].size(); i++) {
+            if (!bodies[i]->state_from_json(data["state"][i]))
+                std::cerr << "Warning: state of body " << i << " does not match its mesh\n";
+        }
+    }
 }
 
 void Simulation::applyGravity() {
@@ -80,8 +342,16 @@ void Simulation::applyGravity() {
 }
 
 void Simulation::updateObjects(double dt) {
-    for (auto& b : bodies) {
-        b->update(dt);
+    // Particles of a resting body keep jittering in their contacts, its center does not move
+    double rest_distance = rest_speed * dt;
+    bool known = rest_centers.size() == bodies.size();
+    rest_centers.resize(bodies.size());
+    for (size_t i = 0; i < bodies.size(); i++) {
+        bodies[i]->update(dt);
+        Vector2 center = bodies[i]->getCenter();
+        if (known && (center - rest_centers[i]).lengthSquared() <= rest_distance * rest_distance)
+            stats.resting_bodies++;
+        rest_centers[i] = center;
     }
 }
 
@@ -92,129 +362,717 @@ void Simulation::applyConstraints() {
 }
 
 void Simulation::resolveCollisions(double dt) {
-    collisionsWorld();
-    collisionsBodies(dt); // body vs body collisions (particle-particle cross-body)
-    collisionsWorld();
+    const PerfCounters* pc = counters.isOpen() ? &counters : nullptr;
+    {
+        PhaseScope phase(stats, WorldCollisionsPhase, pc);
+        selectColliding();
+        // Only the first pass sees the true motion of the step
+        if (continuous_collisions) collisionsWorldSwept();
+        else collisionsWorld();
+    }
+    {
+        PhaseScope phase(stats, BodyCollisionsPhase, pc);
+        collisionsBodies(dt); // body vs body collisions (particle-particle cross-body)
+    }
+    {
+        PhaseScope phase(stats, WorldCollisionsPhase, pc);
+        collisionsWorld();
+    }
+}
+
+// Margin kept below the clearance bounds, absorbs the rounding of the collider tests
+static constexpr double CLEARANCE_SLACK = 1e-9;
+
+void Simulation::setWorldClearance(bool enable) {
+    world_clearance = enable;
+    resetClearance();
+}
+
+void Simulation::resetClearance() {
+    for (auto& body : bodies)
+        for (auto& p : body->getParticles()) p->setClearance(p->getPosition(), -1.0);
+}
+
+void Simulation::selectColliding() {
+    colliding.resize(bodies.size());
+    for (size_t b = 0; b < bodies.size(); b++) {
+        SoftBody* body = bodies[b];
+        bool surface = surface_collisions && body->getSurface().size() < body->getParticles().size();
+        if (surface && !body->surfaceEncloses()) {
+            surface = false;
+            stats.surface_fallbacks++;
+        }
+        colliding[b] = surface ? &body->getSurface() : &body->getParticles();
+        stats.collision_particles += colliding[b]->size();
+    }
+}
+
+const std::vector<Particle*>& Simulation::nearParticles(const std::vector<Particle*>& particles, bool swept) {
+    if (!world_clearance) return particles;
+    near_particles.clear();
+    for (auto& p : particles) {
+        // A swept particle also needs its previous position clear, the disc is convex
+        bool clear = p->isClear(p->getPosition()) && (!swept || p->isClear(p->getPrevPosition()));
+        if (!clear) near_particles.push_back(p);
+    }
+    stats.world_particles_skipped += particles.size() - near_particles.size();
+    return near_particles;
+}
+
+void Simulation::sortCollider(WorldCollider* collider, bool near) {
+    if (!world_clearance) return;
+    (near ? near_colliders : far_colliders).push_back(collider);
+}
+
+/**
+ * @brief Smallest clearance of the colliders at a point, stopping once it drops to a floor.
+ */
+static double minClearance(const std::vector<WorldCollider*>& first, const std::vector<WorldCollider*>& second,
+                           const Vector2& point, double floor) {
+    double d = std::numeric_limits<double>::infinity();
+    for (auto* list : { &first, &second }) {
+        for (auto collider : *list) {
+            d = std::min(d, collider->clearance(point));
+            if (d <= floor) return d;
+        }
+    }
+    return d;
+}
+
+void Simulation::updateClearance(const std::vector<Particle*>& particles) {
+    if (!world_clearance) return;
+    // The bounds change at most as fast as the point, so one evaluation at
+    // the center of the particles bounds them all, up to their distance to it
+    bool centered = false;
+    Vector2 center;
+    double center_clearance = 0.0;
+    for (auto& p : particles) {
+        // Particles in contact are tested anyway, bound them again once they moved away
+        Vector2 pos = p->getPosition();
+        double r = p->getRadius();
+        if (p->getClearance() == 0.0 && (pos - p->getClearanceAnchor()).lengthSquared() < r * r) continue;
+
+        if (!centered) {
+            AABB box = computeAABB(particles);
+            center = (box.min + box.max) * 0.5;
+            center_clearance = minClearance(near_colliders, far_colliders, center, 0.0);
+            centered = true;
+        }
+        double margin = center_clearance - (pos - center).length() - r - CLEARANCE_SLACK;
+
+        // Too close to a collider for the shared bound, particles touching
+        // one stop at the first colliders, those near the body
+        if (margin <= 0.0)
+            margin = minClearance(near_colliders, far_colliders, pos, r + CLEARANCE_SLACK) - r - CLEARANCE_SLACK;
+        p->setClearance(pos, std::max(margin, 0.0));
+    }
+    near_colliders.clear();
+    far_colliders.clear();
+}
+
+/**
+ * @brief Whether a collider acts on a body layer, the pairs it skips are counted.
+ */
+bool Simulation::inMask(WorldCollider* collider, uint32_t layer) {
+    if (collider->getCollisionMask() & layer) return true;
+    stats.masked_pairs++;
+    // Still part of the clearance bounds, which then stay valid when masks change
+    if (world_clearance) far_colliders.push_back(collider);
+    return false;
 }
 
 void Simulation::collisionsWorld() {
-    for (auto& body : bodies) {
-        for (auto& p : body->getParticles()) {
-            for (auto collider : colliders) {
-                collider->collide(p, body->getFriction(), body->getRestitution());
+    std::vector<WorldCollider*> candidates;
+    candidates.reserve(other_colliders.size());
+    for (size_t b = 0; b < bodies.size(); b++) {
+        SoftBody* body = bodies[b];
+        double friction = body->getFriction();
+        double restitution = body->getRestitution();
+
+        // Particles clear of every collider are skipped
+        const std::vector<Particle*>& particles = nearParticles(*colliding[b], false);
+        if (particles.empty()) {
+            stats.world_pairs += colliders.size();
+            stats.world_pairs_skipped += colliders.size();
+            continue;
+        }
+
+        // Skip the colliders the body cannot reach
+        AABB box = computeAABB(particles);
+        uint32_t layer = body->getCollisionLayer();
+        bool gathered = false;
+        size_t tested = 0;
+        auto collideAll = [&](auto& typed) {
+            for (auto collider : typed) {
+                if (!inMask(collider, layer)) continue;
+                bool near = collider->mayCollide(box);
+                sortCollider(collider, near);
+                if (!near) continue;
+                if (!gathered) {
+                    batch.gather(particles);
+                    gathered = true;
+                }
+                collider->collideBatch(batch, friction, restitution);
+                tested++;
             }
+        };
+        // Built-in colliders, a whole body per call
+        collideAll(planes);
+        collideAll(inner_circles);
+        collideAll(outer_circles);
+        collideAll(segment_meshes);
+
+        // Other colliders, a virtual call per particle
+        candidates.clear();
+        for (auto collider : other_colliders) {
+            if (!inMask(collider, layer)) continue;
+            bool near = collider->mayCollide(box);
+            sortCollider(collider, near);
+            if (near) candidates.push_back(collider);
         }
+        tested += candidates.size();
+        if (!candidates.empty()) {
+            for (auto& p : particles) {
+                for (auto collider : candidates) {
+                    collider->collide(p, friction, restitution);
+                }
+            }
+        }
+        stats.world_pairs += colliders.size();
+        stats.world_pairs_skipped += colliders.size() - tested;
+        updateClearance(particles);
+    }
+}
+
+void Simulation::collisionsWorldSwept() {
+    std::vector<WorldCollider*> candidates;
+    candidates.reserve(colliders.size());
+    for (size_t b = 0; b < bodies.size(); b++) {
+        SoftBody* body = bodies[b];
+        double friction = body->getFriction();
+        double restitution = body->getRestitution();
+
+        const std::vector<Particle*>& particles = nearParticles(*colliding[b], true);
+        if (particles.empty()) {
+            stats.world_pairs += colliders.size();
+            stats.world_pairs_skipped += colliders.size();
+            continue;
+        }
+
+        // Bounds of the whole motion, radii included
+        AABB box = computeAABB(particles);
+        for (auto& p : particles) {
+            Vector2 prev = p->getPrevPosition();
+            double r = p->getRadius();
+            box.min = Vector2(std::min(box.min.x, prev.x - r), std::min(box.min.y, prev.y - r));
+            box.max = Vector2(std::max(box.max.x, prev.x + r), std::max(box.max.y, prev.y + r));
+        }
+        uint32_t layer = body->getCollisionLayer();
+        candidates.clear();
+        for (auto collider : colliders) {
+            if (!inMask(collider, layer)) continue;
+            bool near = collider->mayCollide(box);
+            sortCollider(collider, near);
+            if (near) candidates.push_back(collider);
+        }
+        stats.world_pairs += colliders.size();
+        stats.world_pairs_skipped += colliders.size() - candidates.size();
+        if (candidates.empty()) {
+            updateClearance(particles);
+            continue;
+        }
+
+        for (auto& p : particles) {
+            // After a response the previous position no longer follows the
+            // motion, the remaining colliders use the static test
+            bool hit = false;
+            for (auto collider : candidates) {
+                if (hit) collider->collide(p, friction, restitution);
+                else hit = collider->collideSwept(p, friction, restitution);
+            }
+        }
+        updateClearance(particles);
     }
 }
 
 /**
- * Axis-Aligned Bounding Box (AABB) structure
+ * @brief Separate two particles of different bodies and damp their relative velocity.
+ * @return The overlap resolved, 0 if the particles did not touch.
  */
-struct AABB {
-    Vector2 min;
-    Vector2 max;
-};
+static double resolveParticles(Particle* part1, Particle* part2, double mu, double restitution, double dt) {
+    Vector2 delta = part1->getPosition() - part2->getPosition();
+    double dist = delta.length();
+    double min_dist = (part1->getRadius() + part2->getRadius());
+    if (!(dist > 0 && dist < min_dist)) return 0.0;
+
+    Vector2 n = delta / dist; // Collision normal
+    double overlap = min_dist - dist;
+
+    // --- Relative velocity ---
+    Vector2 relVel = (part1->getPosition() - part1->getPrevPosition()) 
+                - (part2->getPosition() - part2->getPrevPosition());
+
+    double velAlongNormal = relVel.dot(n);
+    Vector2 tangentVel = relVel - velAlongNormal * n;
+
+    // --- Positional correction ---
+    double m1 = part1->getMass();
+    double m2 = part2->getMass();
+    double f1 = m1 / (m1 + m2);
+    double f2 = m2 / (m1 + m2);
 
-double INF = 1e300;
+    if (!part1->isPinned())
+        part1->setPosition(part1->getPosition() + n * (overlap * f1));
+    if (!part2->isPinned())
+        part2->setPosition(part2->getPosition() - n * (overlap * f2));
+
+    // Only resolve if particles are moving toward each other
+    if (velAlongNormal < 0) {
+        double invMass1 = part1->isPinned() ? 0.0 : 1.0 / m1;
+        double invMass2 = part2->isPinned() ? 0.0 : 1.0 / m2;
+
+        // --- Apply restitution on normal axis ---
+        Vector2 correctedNormal = restitution * velAlongNormal * n;
+
+        // --- Apply friction on tangent axis ---
+        Vector2 correctedTangent = (1.0 - mu) * tangentVel;
+
+        // --- Combined correction ---
+        Vector2 correctedVel = correctedNormal + correctedTangent;
+
+        if (!part1->isPinned())
+            part1->setPrevPosition(part1->getPrevPosition() - correctedVel * invMass1 * dt);
+        if (!part2->isPinned())
+            part2->setPrevPosition(part2->getPrevPosition() + correctedVel * invMass2 * dt);
+    }
+    return overlap;
+}
 
 /**
- * @brief Computes the Axis-Aligned Bounding Box (AABB) for a set of particles.
- * 
- * @param particles The particles to compute the AABB for.
- * @return AABB The computed AABB.
+ * @brief Push two touching particles apart along their normal, positions only.
+ * @return The separation applied.
  */
-AABB computeAABB(std::vector<Particle*> particles) {
-    AABB aabb;
-    aabb.min = { INF,  INF};
-    aabb.max = {-INF, -INF};
+static double separateParticles(Particle* part1, Particle* part2, double amount) {
+    Vector2 delta = part1->getPosition() - part2->getPosition();
+    double dist = delta.length();
+    double min_dist = part1->getRadius() + part2->getRadius();
+    if (!(dist > 0 && dist < min_dist)) return 0.0;
+    amount = std::min(amount, min_dist - dist);
 
-    for (auto& p : particles) {
-        aabb.min.x = std::min(aabb.min.x, p->getPosition().x - p->getRadius());
-        aabb.min.y = std::min(aabb.min.y, p->getPosition().y - p->getRadius());
-        aabb.max.x = std::max(aabb.max.x, p->getPosition().x + p->getRadius());
-        aabb.max.y = std::max(aabb.max.y, p->getPosition().y + p->getRadius());
-    }
-    return aabb;
+    Vector2 n = delta / dist;
+    double m1 = part1->getMass();
+    double m2 = part2->getMass();
+    if (!part1->isPinned())
+        part1->setPosition(part1->getPosition() + n * (amount * m1 / (m1 + m2)));
+    if (!part2->isPinned())
+        part2->setPosition(part2->getPosition() - n * (amount * m2 / (m1 + m2)));
+    return amount;
 }
 
 /**
- * @brief Checks if two AABBs overlap.
- * 
- * @param a The first AABB.
- * @param b The second AABB.
- * @return true If the AABBs overlap.
+ * @brief Separate a particle from the edge of another body and damp their relative velocity.
+ *
+ * The edge acts at its closest point to the particle, its end particles
+ * share the correction by their weight in that point. The edge is as thick
+ * as its end particles, interpolated along it. A particle already behind
+ * the edge, inside the other body, is pushed back out along the outward
+ * normal given by the winding of the outline.
+ * @return The overlap resolved, 0 if the particle did not touch the edge.
  */
-bool aabbOverlap(const AABB& a, const AABB& b) {
-    return !(a.max.x < b.min.x || a.min.x > b.max.x ||
-             a.max.y < b.min.y || a.min.y > b.max.y);
+static double resolveEdge(Particle* p, Particle* e1, Particle* e2, double winding,
+                          double mu, double restitution, double dt) {
+    Vector2 a = e1->getPosition();
+    Vector2 ab = e2->getPosition() - a;
+    double len2 = ab.dot(ab);
+    double t = len2 > 0.0 ? std::clamp((p->getPosition() - a).dot(ab) / len2, 0.0, 1.0) : 0.0;
+    double w1 = 1.0 - t, w2 = t;
+
+    Vector2 delta = p->getPosition() - (a + ab * t);
+    double dist = delta.length();
+    double min_dist = p->getRadius() + w1 * e1->getRadius() + w2 * e2->getRadius();
+
+    // Past the end particles the edge acts as a particle, along it it has two sides
+    Vector2 n; // Collision normal, toward the particle
+    double overlap;
+    double side = t > 0.0 && t < 1.0 ? delta.dot(Vector2(ab.y, -ab.x)) * winding : 0.0;
+    if (side >= 0.0) {
+        if (!(dist > 0 && dist < min_dist)) return 0.0;
+        n = delta / dist;
+        overlap = min_dist - dist;
+    } else {
+        if (dist >= min_dist) return 0.0;
+        n = Vector2(ab.y, -ab.x) * (winding / std::sqrt(len2));
+        overlap = min_dist + dist;
+    }
+
+    double inv_p = p->isPinned() ? 0.0 : 1.0 / p->getMass();
+    double inv_1 = e1->isPinned() ? 0.0 : 1.0 / e1->getMass();
+    double inv_2 = e2->isPinned() ? 0.0 : 1.0 / e2->getMass();
+    double inv_sum = inv_p + w1 * w1 * inv_1 + w2 * w2 * inv_2;
+    if (inv_sum <= 0.0) return 0.0;
+
+    // --- Relative velocity ---
+    Vector2 relVel = (p->getPosition() - p->getPrevPosition())
+                - w1 * (e1->getPosition() - e1->getPrevPosition())
+                - w2 * (e2->getPosition() - e2->getPrevPosition());
+    double velAlongNormal = relVel.dot(n);
+    Vector2 tangentVel = relVel - velAlongNormal * n;
+
+    // --- Positional correction ---
+    double s = overlap / inv_sum;
+    if (inv_p > 0.0) p->setPosition(p->getPosition() + n * (s * inv_p));
+    if (inv_1 > 0.0) e1->setPosition(e1->getPosition() - n * (s * w1 * inv_1));
+    if (inv_2 > 0.0) e2->setPosition(e2->getPosition() - n * (s * w2 * inv_2));
+
+    // Only resolve if the particle moves toward the edge
+    if (velAlongNormal < 0) {
+        Vector2 correctedVel = restitution * velAlongNormal * n + (1.0 - mu) * tangentVel;
+        if (inv_p > 0.0) p->setPrevPosition(p->getPrevPosition() - correctedVel * inv_p * dt);
+        if (inv_1 > 0.0) e1->setPrevPosition(e1->getPrevPosition() + correctedVel * (w1 * inv_1 * dt));
+        if (inv_2 > 0.0) e2->setPrevPosition(e2->getPrevPosition() + correctedVel * (w2 * inv_2 * dt));
+    }
+    return overlap;
 }
 
 void Simulation::collisionsBodies(double dt) {
+    if (sphere_trees) updateSphereTrees();
+    if (edge_contacts) {
+        collisionsBodiesEdges(dt);
+        return;
+    }
+    if (contact_pipeline) {
+        collisionsBodiesPipeline(dt);
+        return;
+    }
     const int object_cnt = bodies.size();
     for (int i = 0; i < object_cnt; i++) {
         auto& obj1 = bodies[i];
-        AABB border1 = computeAABB(obj1->getParticles());
+        const auto& parts1 = *colliding[i];
+        AABB border1 = computeAABB(parts1);
         for (int j = i + 1; j < object_cnt; j++) {
             auto& obj2 = bodies[j];
+            const auto& parts2 = *colliding[j];
+            if (!obj1->collidesWith(obj2)) {
+                stats.masked_pairs++;
+                continue;
+            }
 
-            AABB border2 = computeAABB(obj2->getParticles());
+            AABB border2 = computeAABB(parts2);
             if (!aabbOverlap(border1, border2)) continue;
             // Average friction coefficient
             double mu = 0.5 * (obj1->getFriction() + obj2->getFriction());
             // Minimum restitution
             double restitution = std::min(obj1->getRestitution(), obj2->getRestitution());
 
-            for (auto& part1 : obj1->getParticles()) {
-                for (auto& part2 : obj2->getParticles()) {
+            if (contact_cache) {
+                collideCached(obj1, obj2, parts1, parts2, mu, restitution, dt);
+                continue;
+            }
+            collideParticles(i, j, mu, restitution, dt);
+        }
+    }
+    if (contact_cache) contacts.endStep();
+}
 
-                    Vector2 delta = part1->getPosition() - part2->getPosition();
-                    double dist = delta.length();
-                    double min_dist = (part1->getRadius() + part2->getRadius());
+void Simulation::updateSphereTrees() {
+    auto start = std::chrono::steady_clock::now();
+    body_spheres.resize(bodies.size());
+    for (size_t i = 0; i < bodies.size(); i++) {
+        SphereTree& tree = body_spheres[i];
+        // Clusters are rebuilt when the body switches between its surface and all its particles
+        if (tree.getParticles() != colliding[i]) tree.build(*colliding[i]);
+        else tree.refit();
+    }
+    stats.sphere_refit_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
 
-                    if (dist > 0 && dist < min_dist) {
-                        Vector2 n = delta / dist; // Collision normal
-                        double overlap = min_dist - dist;
+void Simulation::collideParticles(int i, int j, double mu, double restitution, double dt) {
+    const auto& parts1 = *colliding[i];
+    const auto& parts2 = *colliding[j];
+    if (sphere_trees) {
+        stats.sphere_leaf_pairs += SphereTree::forEachPair(body_spheres[i], body_spheres[j], [&](int a, int b) {
+            if (resolveParticles(parts1[a], parts2[b], mu, restitution, dt) > 0.0) stats.body_contacts++;
+        });
+        return;
+    }
+    unsigned long long touching = 0;
+    for (auto& part1 : parts1) {
+        for (auto& part2 : parts2) {
+            if (resolveParticles(part1, part2, mu, restitution, dt) > 0.0) touching++;
+        }
+    }
+    stats.body_contacts += touching;
+}
 
-                        // --- Relative velocity ---
-                        Vector2 relVel = (part1->getPosition() - part1->getPrevPosition()) 
-                                    - (part2->getPosition() - part2->getPrevPosition());
+void Simulation::collisionsBodiesEdges(double dt) {
+    const int object_cnt = bodies.size();
+    edge_trees.resize(object_cnt);
+    std::vector<AABB> boxes(object_cnt);
+    for (int i = 0; i < object_cnt; i++) {
+        SoftBody* body = bodies[i];
+        const auto& outline = body->getSurface();
+        EdgeTree& tree = edge_trees[i];
+        // The outline of a folded body no longer bounds its particles
+        if (!body->hasOutline() || (colliding[i] != &outline && !body->surfaceEncloses())) {
+            if (!tree.empty()) tree.build({});
+        } else if (tree.getEdgeCount() != (outline.size() > 2 ? outline.size() : outline.size() - 1)) {
+            tree.build(outline);
+        } else {
+            tree.refit(outline);
+        }
+        boxes[i] = computeAABB(*colliding[i]);
+    }
 
-                        double velAlongNormal = relVel.dot(n);
-                        Vector2 tangentVel = relVel - velAlongNormal * n;
+    for (int i = 0; i < object_cnt; i++) {
+        auto& obj1 = bodies[i];
+        const auto& parts1 = *colliding[i];
+        for (int j = i + 1; j < object_cnt; j++) {
+            auto& obj2 = bodies[j];
+            const auto& parts2 = *colliding[j];
+            if (!obj1->collidesWith(obj2)) {
+                stats.masked_pairs++;
+                continue;
+            }
+            if (!aabbOverlap(boxes[i], boxes[j])) continue;
+            double mu = 0.5 * (obj1->getFriction() + obj2->getFriction());
+            double restitution = std::min(obj1->getRestitution(), obj2->getRestitution());
 
-                        // --- Positional correction ---
-                        double m1 = part1->getMass();
-                        double m2 = part2->getMass();
-                        double f1 = m1 / (m1 + m2);
-                        double f2 = m2 / (m1 + m2);
+            // Each side's particles against the other side's edges, the edges cover their end particles
+            if (edge_trees[i].empty() && edge_trees[j].empty()) {
+                collideParticles(i, j, mu, restitution, dt);
+                continue;
+            }
+            if (!edge_trees[j].empty())
+                collideEdges(parts1, obj2->getSurface(), edge_trees[j], mu, restitution, dt);
+            if (!edge_trees[i].empty())
+                collideEdges(parts2, obj1->getSurface(), edge_trees[i], mu, restitution, dt);
+        }
+    }
+}
 
-                        if (!part1->isPinned())
-                            part1->setPosition(part1->getPosition() + n * (overlap * f1));
-                        if (!part2->isPinned())
-                            part2->setPosition(part2->getPosition() - n * (overlap * f2));
+void Simulation::collideEdges(const std::vector<Particle*>& particles, const std::vector<Particle*>& outline,
+                              const EdgeTree& tree, double mu, double restitution, double dt) {
+    const AABB& bounds = tree.getBounds();
+    size_t n = outline.size();
+    for (auto& p : particles) {
+        double r = p->getRadius();
+        const Vector2& pos = p->getPosition();
+        AABB box = { Vector2(pos.x - r, pos.y - r), Vector2(pos.x + r, pos.y + r) };
+        if (!aabbOverlap(box, bounds)) continue;
+        tree.forEachOverlap(box, [&](int e) {
+            if (resolveEdge(p, outline[e], outline[(e + 1) % n], tree.getWinding(), mu, restitution, dt) > 0.0) {
+                stats.edge_contacts++;
+                stats.body_contacts++;
+            }
+        });
+    }
+}
 
-                        // Only resolve if particles are moving toward each other
-                        if (velAlongNormal < 0) {
-                            double invMass1 = part1->isPinned() ? 0.0 : 1.0 / m1;
-                            double invMass2 = part2->isPinned() ? 0.0 : 1.0 / m2;
+void Simulation::setThreadCount(int n) {
+    if (n > 1) pool = std::make_unique<ThreadPool>(n);
+    else pool.reset();
+}
 
-                            // --- Apply restitution on normal axis ---
-                            Vector2 correctedNormal = restitution * velAlongNormal * n;
+void Simulation::runParallel(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+    if (pool) {
+        pool->parallelFor(count, grain, fn);
+        return;
+    }
+    for (size_t begin = 0; begin < count; begin += grain)
+        fn(begin, std::min(begin + grain, count));
+}
 
-                            // --- Apply friction on tangent axis ---
-                            Vector2 correctedTangent = (1.0 - mu) * tangentVel;
+void Simulation::collisionsBodiesPipeline(double dt) {
+    using clock = std::chrono::steady_clock;
+    auto elapsed = [](clock::time_point from) {
+        return std::chrono::duration<double, std::milli>(clock::now() - from).count();
+    };
+    auto start = clock::now();
+    // Replaced at each stage, emplace() ends the previous event
+    std::optional<TraceScope> stage;
+    stage.emplace("contactDetect", "step");
 
-                            // --- Combined correction ---
-                            Vector2 correctedVel = correctedNormal + correctedTangent;
+    // --- Detection ----
+    // Overlapping body pairs, and the index of the first colliding particle of each body
+    const size_t object_cnt = bodies.size();
+    std::vector<AABB> boxes(object_cnt);
+    std::vector<uint32_t> offsets(object_cnt + 1, 0);
+    for (size_t i = 0; i < object_cnt; i++) {
+        boxes[i] = computeAABB(*colliding[i]);
+        offsets[i + 1] = offsets[i] + (uint32_t)colliding[i]->size();
+    }
+    body_pairs.clear();
+    for (size_t i = 0; i < object_cnt; i++) {
+        for (size_t j = i + 1; j < object_cnt; j++) {
+            if (!bodies[i]->collidesWith(bodies[j])) {
+                stats.masked_pairs++;
+                continue;
+            }
+            if (!aabbOverlap(boxes[i], boxes[j])) continue;
+            double mu = 0.5 * (bodies[i]->getFriction() + bodies[j]->getFriction());
+            double restitution = std::min(bodies[i]->getRestitution(), bodies[j]->getRestitution());
+            // Manifolds are created here, the parallel stage only fills them
+            ContactManifold* manifold = contact_cache ? &contacts.manifold(bodies[i], bodies[j]) : nullptr;
+            body_pairs.push_back({ (int)i, (int)j, mu, restitution, manifold, false });
+        }
+    }
 
-                            if (!part1->isPinned())
-                                part1->setPrevPosition(part1->getPrevPosition() - correctedVel * invMass1 * dt);
-                            if (!part2->isPinned())
-                                part2->setPrevPosition(part2->getPrevPosition() + correctedVel * invMass2 * dt);
-                        }
-                    }
+    // One buffer per chunk, merged in chunk order: the contact order does not depend on the threads
+    const size_t grain = 4;
+    contact_buffers.resize((body_pairs.size() + grain - 1) / grain);
+    std::vector<size_t> leaf_pairs(contact_buffers.size(), 0);
+    runParallel(body_pairs.size(), grain, [&](size_t begin, size_t end) {
+        std::vector<BodyContact>& out = contact_buffers[begin / grain];
+        out.clear();
+        for (size_t k = begin; k < end; k++) {
+            BodyPair& bp = body_pairs[k];
+            const auto& p1 = *colliding[bp.first];
+            const auto& p2 = *colliding[bp.second];
+            uint32_t o1 = offsets[bp.first], o2 = offsets[bp.second];
+            if (bp.manifold) {
+                if (!bp.manifold->isValid(p1, p2, contact_skin)) {
+                    bp.manifold->rebuild(p1, p2, contact_skin);
+                    bp.rebuilt = true;
                 }
+                for (auto& cp : bp.manifold->pairs)
+                    out.push_back({ p1[cp.a], p2[cp.b], o1 + cp.a, o2 + cp.b, (uint32_t)k, &cp });
+                continue;
+            }
+            auto detect = [&](uint32_t a, uint32_t b) {
+                double min_dist = p1[a]->getRadius() + p2[b]->getRadius();
+                if ((p1[a]->getPosition() - p2[b]->getPosition()).lengthSquared() < min_dist * min_dist)
+                    out.push_back({ p1[a], p2[b], o1 + a, o2 + b, (uint32_t)k, nullptr });
+            };
+            if (sphere_trees) {
+                leaf_pairs[begin / grain] += SphereTree::forEachPair(body_spheres[bp.first], body_spheres[bp.second], detect);
+                continue;
             }
+            for (uint32_t a = 0; a < p1.size(); a++)
+                for (uint32_t b = 0; b < p2.size(); b++) detect(a, b);
+        }
+    });
+    for (size_t count : leaf_pairs) stats.sphere_leaf_pairs += count;
+    body_contacts.clear();
+    for (auto& buffer : contact_buffers)
+        body_contacts.insert(body_contacts.end(), buffer.begin(), buffer.end());
+    for (auto& bp : body_pairs) {
+        if (!bp.manifold) continue;
+        if (bp.rebuilt) stats.manifolds_rebuilt++;
+        else stats.manifolds_reused++;
+    }
+    stats.contact_detect_ms += elapsed(start);
+    start = clock::now();
+    stage.emplace("contactColor", "step");
+
+    // --- Coloring ----
+    // Greedy: the lowest color free on both particles, pinned particles never move
+    // so they do not constrain; contacts left without one of the 64 colors go last
+    const int OVERFLOW_COLOR = 64;
+    const size_t n = body_contacts.size();
+    color_masks.assign(offsets[object_cnt], 0);
+    std::vector<uint8_t> colors(n);
+    size_t counts[OVERFLOW_COLOR + 2] = {};
+    for (size_t k = 0; k < n; k++) {
+        const BodyContact& c = body_contacts[k];
+        uint64_t ma = c.a->isPinned() ? 0 : color_masks[c.ia];
+        uint64_t mb = c.b->isPinned() ? 0 : color_masks[c.ib];
+        uint64_t used = ma | mb;
+        int color = OVERFLOW_COLOR;
+        if (~used) {
+            color = 0;
+            while (used >> color & 1) color++;
+            if (!c.a->isPinned()) color_masks[c.ia] |= 1ull << color;
+            if (!c.b->isPinned()) color_masks[c.ib] |= 1ull << color;
+        }
+        colors[k] = (uint8_t)color;
+        counts[color + 1]++;
+    }
+    for (int c = 0; c <= OVERFLOW_COLOR; c++) counts[c + 1] += counts[c];
+    std::vector<size_t> first(counts, counts + OVERFLOW_COLOR + 2);
+    color_order.resize(n);
+    for (size_t k = 0; k < n; k++) color_order[counts[colors[k]]++] = (uint32_t)k;
+    for (int c = 0; c <= OVERFLOW_COLOR; c++)
+        stats.contact_colors += first[c + 1] > first[c];
+    stats.contacts += n;
+    stats.contact_color_ms += elapsed(start);
+    start = clock::now();
+    stage.emplace("contactResolve", "step");
+
+    // --- Resolution ----
+    // Contacts of one color share no moving particle and run concurrently,
+    // fn counts in the counter of its chunk, the sum over the colors is returned
+    const size_t color_grain = 256;
+    std::vector<size_t> chunk_counts;
+    auto byColor = [&](const std::function<void(const BodyContact&, size_t, size_t&)>& fn) {
+        size_t total = 0;
+        for (int c = 0; c <= OVERFLOW_COLOR; c++) {
+            size_t begin = first[c], count = first[c + 1] - first[c];
+            if (count == 0) continue;
+            chunk_counts.assign((count + color_grain - 1) / color_grain, 0);
+            auto run = [&](size_t from, size_t to) {
+                size_t& counter = chunk_counts[from / color_grain];
+                for (size_t k = begin + from; k < begin + to; k++)
+                    fn(body_contacts[color_order[k]], color_order[k], counter);
+            };
+            if (c == OVERFLOW_COLOR) run(0, count);
+            else runParallel(count, color_grain, run);
+            for (size_t counter : chunk_counts) total += counter;
+        }
+        return total;
+    };
+    std::vector<double>& warm = warm_scratch;
+    warm.assign(n, 0.0);
+    if (contact_cache && warm_start > 0.0) {
+        byColor([&](const BodyContact& c, size_t k, size_t&) {
+            if (c.cached->age > 1 && c.cached->correction > 0.0)
+                warm[k] = separateParticles(c.a, c.b, warm_start * c.cached->correction);
+        });
+    }
+    // Only contacts that moved their particles, like the serial paths
+    stats.body_contacts += byColor([&](const BodyContact& c, size_t k, size_t& resolved_count) {
+        const BodyPair& bp = body_pairs[c.pair];
+        double resolved = resolveParticles(c.a, c.b, bp.mu, bp.restitution, dt);
+        if (resolved > 0.0) resolved_count++;
+        if (c.cached) {
+            c.cached->correction = warm[k] + resolved;
+            c.cached->age = c.cached->correction > 0.0 ? c.cached->age + 1 : 0;
+        }
+    });
+    if (contact_cache) {
+        for (auto& bp : body_pairs) stats.contact_pairs += bp.manifold->pairs.size();
+        contacts.endStep();
+    }
+    stats.contact_resolve_ms += elapsed(start);
+}
+
+void Simulation::collideCached(SoftBody* obj1, SoftBody* obj2,
+                               const std::vector<Particle*>& p1, const std::vector<Particle*>& p2,
+                               double mu, double restitution, double dt) {
+    ContactManifold& manifold = contacts.manifold(obj1, obj2);
+    if (manifold.isValid(p1, p2, contact_skin)) {
+        stats.manifolds_reused++;
+    } else {
+        manifold.rebuild(p1, p2, contact_skin);
+        stats.manifolds_rebuilt++;
+    }
+
+    // Warm start: first re-apply part of the correction each resting pair needed last step
+    std::vector<double>& warm = warm_scratch;
+    warm.assign(manifold.pairs.size(), 0.0);
+    if (warm_start > 0.0) {
+        for (size_t k = 0; k < manifold.pairs.size(); k++) {
+            const ContactPair& pair = manifold.pairs[k];
+            if (pair.age > 1 && pair.correction > 0.0)
+                warm[k] = separateParticles(p1[pair.a], p2[pair.b], warm_start * pair.correction);
         }
     }
+
+    for (size_t k = 0; k < manifold.pairs.size(); k++) {
+        ContactPair& pair = manifold.pairs[k];
+        double resolved = resolveParticles(p1[pair.a], p2[pair.b], mu, restitution, dt);
+        if (resolved > 0.0) stats.body_contacts++;
+        pair.correction = warm[k] + resolved;
+        pair.age = pair.correction > 0.0 ? pair.age + 1 : 0;
+    }
+    stats.contact_pairs += manifold.pairs.size();
 }
@@ -0,0 +1,128 @@
+#include "SimulationWorker.h"
+#include <algorithm>
+#include "SoftBody.h"
+#include "Trace.h"
+
+using namespace sim;
+
+void SimulationSnapshot::capture(Simulation& simulation, bool detail) {
+    stats = simulation.getStats();
+    // clear() keeps the capacity, steady state captures do not allocate
+    borders.clear();
+    border_offsets.clear();
+    border_radii.clear();
+    particles.clear();
+    radii.clear();
+    particle_offsets.clear();
+    lines.clear();
+
+    for (SoftBody* body : simulation.getBodies()) {
+        border_offsets.push_back(borders.size());
+        for (const Particle* p : body->getBorder()) {
+            borders.push_back(p->getPosition());
+            if (detail) border_radii.push_back(p->getRadius());
+        }
+        if (!detail) continue;
+
+        const auto& body_particles = body->getParticles();
+        particle_offsets.push_back(particles.size());
+        for (const Particle* p : body_particles) {
+            particles.push_back(p->getPosition());
+            radii.push_back(p->getRadius());
+        }
+        for (Constraint* c : body->getConstraints()) {
+            lines.push_back(c->getPart1());
+            lines.push_back(c->getPart2());
+        }
+        if (auto proto = body->getPrototype()) {
+            for (auto& e : proto->getEdges()) {
+                lines.push_back(body_particles[e.first]->getPosition());
+                lines.push_back(body_particles[e.second]->getPosition());
+            }
+        }
+    }
+    border_offsets.push_back(borders.size());
+    if (detail) particle_offsets.push_back(particles.size());
+}
+
+SimulationWorker::SimulationWorker(Simulation& simulation) : simulation(simulation) {
+    polled_at = std::chrono::steady_clock::now();
+    slots[front].capture(simulation, detail);
+    thread = std::thread([this] { run(); });
+}
+
+SimulationWorker::~SimulationWorker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    thread.join();
+}
+
+bool SimulationWorker::request(double dt) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if ((int)queue.size() >= max_lag) {
+            dropped++;
+            return false;
+        }
+        queue.push_back(dt);
+        requested++;
+    }
+    wake.notify_one();
+    return true;
+}
+
+const SimulationSnapshot& SimulationWorker::latest() {
+    if (spare.load(std::memory_order_acquire) & FRESH)
+        front = spare.exchange(front, std::memory_order_acq_rel) & ~FRESH;
+    return slots[front];
+}
+
+void SimulationWorker::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return queue.empty(); });
+}
+
+double SimulationWorker::takeUtilization() {
+    auto now = std::chrono::steady_clock::now();
+    uint64_t busy = busy_ns.load();
+    double elapsed = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(now - polled_at).count();
+    double utilization = elapsed > 0.0 ? (double)(busy - polled_busy_ns) / elapsed : 0.0;
+    polled_at = now;
+    polled_busy_ns = busy;
+    return std::min(utilization, 1.0);
+}
+
+void SimulationWorker::run() {
+    TraceRecorder::instance().setThreadName("simulation");
+    while (true) {
+        double dt;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) return;
+            dt = queue.front();
+        }
+        auto start = std::chrono::steady_clock::now();
+        simulation.step(dt);
+        publish();
+        busy_ns += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        {
+            // The step leaves the queue only once published, so the lag counts it
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.pop_front();
+            completed++;
+        }
+        idle.notify_all();
+    }
+}
+
+void SimulationWorker::publish() {
+    TraceScope trace("publishSnapshot", "step");
+    SimulationSnapshot& snapshot = slots[back];
+    snapshot.capture(simulation, detail);
+    snapshot.step = completed.load() + 1;
+    back = spare.exchange(back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+}
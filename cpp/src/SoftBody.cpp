@@ -1,6 +1,9 @@
 #include "SoftBody.h"
+#include "AABB.h"
 #include <unordered_map>
 #include <array>
+#include <algorithm>
+#include <cmath>
 
 using namespace sim;
 
@@ -9,7 +12,7 @@ SoftBody::SoftBody(
         std::vector<Constraint *> constraints,
         double friction, double restitution
     )
-    : border({}), particles(particles), constraints(constraints),
+    : particles(particles), border({}), surface(particles), constraints(constraints),
       friction(friction), restitution(restitution), mesh_unit(-1) {}
 
 SoftBody::SoftBody(
@@ -18,8 +21,36 @@ SoftBody::SoftBody(
         std::vector<Constraint *> constraints,
         double friction, double restitution, int unit
     )
-    : border(border), particles(particles), constraints(constraints),
-      friction(friction), restitution(restitution), mesh_unit(unit) {}
+    : particles(particles), border(border), surface(particles), constraints(constraints),
+      friction(friction), restitution(restitution), mesh_unit(unit) {
+    for (auto b : border)
+        rest_border.push_back(b->getPosition());
+}
+
+SoftBody* SoftBody::instantiate(
+        std::shared_ptr<const SoftBodyPrototype> prototype,
+        const Vector2& translation, double rotation
+    ) {
+    std::vector<Particle*> _particles;
+    std::vector<Particle*> _border;
+    _particles.reserve(prototype->getRestPositions().size());
+    for (auto& rest : prototype->getRestPositions()) {
+        _particles.push_back(new Particle(rest.rotated(rotation) + translation,
+            prototype->getMass(), prototype->getRadius(), prototype->isPinned()));
+    }
+    for (int idx : prototype->getBorder()) {
+        _border.push_back(_particles[idx]);
+    }
+    SoftBody* body = new SoftBody(_border, _particles, {},
+        prototype->getFriction(), prototype->getRestitution(), prototype->getMeshUnit());
+    if (!prototype->getSurface().empty()) body->setOutline(prototype->getSurface());
+    body->mesh_type = prototype->getMeshType();
+    body->reordered = prototype->isReordered();
+    body->prototype = prototype;
+    body->translation = translation;
+    body->rotation = rotation;
+    return body;
+}
 
 SoftBody::~SoftBody() {};
 
@@ -33,6 +64,16 @@ void SoftBody::solveConstraint() {
     for (auto& c : constraints) {
         c->applyConstraint();
     }
+    if (prototype) {
+        const auto& edges = prototype->getEdges();
+        const auto& rest_lengths = prototype->getRestLengths();
+        double stiffness = prototype->getStiffness();
+        double damping = prototype->getDamping();
+        for (size_t i = 0; i < edges.size(); i++) {
+            Constraint::solve(particles[edges[i].first], particles[edges[i].second],
+                rest_lengths[i], stiffness, damping);
+        }
+    }
 }
 
 
@@ -42,38 +83,186 @@ void SoftBody::update(double dt) {
     }
 }
 
+Vector2 SoftBody::getCenter() const {
+    Vector2 center;
+    if (particles.empty()) return center;
+    for (auto& p : particles) center += p->getPosition();
+    return center / (double)particles.size();
+}
+
+void SoftBody::setOutline(const std::vector<int>& ring) {
+    std::vector<bool> on_ring(particles.size(), false);
+    surface.clear();
+    for (int idx : ring) {
+        surface.push_back(particles[idx]);
+        on_ring[idx] = true;
+    }
+    interior.clear();
+    for (size_t i = 0; i < particles.size(); i++)
+        if (!on_ring[i]) interior.push_back(particles[i]);
+    outline = true;
+}
+
+bool SoftBody::surfaceEncloses() const {
+    if (surface.size() == particles.size()) return true;
+    AABB box = computeAABB(surface);
+    auto inBox = [&](const Vector2& pos) {
+        return pos.x >= box.min.x && pos.x <= box.max.x && pos.y >= box.min.y && pos.y <= box.max.y;
+    };
+    if (!outline) {
+        for (auto& p : particles)
+            if (!inBox(p->getPosition())) return false;
+        return true;
+    }
+
+    // A concave outline can fold over particles that stay within its bounds:
+    // point in polygon test, each particle only crossing the edges of its band
+    int n = (int)surface.size();
+    int bands = std::max(1, (int)std::sqrt((double)n));
+    double scale = bands / std::max(box.max.y - box.min.y, 1e-12);
+    auto band = [&](double y) { return std::min(bands - 1, std::max(0, (int)((y - box.min.y) * scale))); };
+
+    band_start.assign(bands + 1, 0);
+    for (int e = 0; e < n; e++) {
+        double ya = surface[e]->getPosition().y, yb = surface[(e + 1) % n]->getPosition().y;
+        for (int b = band(std::min(ya, yb)); b <= band(std::max(ya, yb)); b++) band_start[b + 1]++;
+    }
+    for (int b = 0; b < bands; b++) band_start[b + 1] += band_start[b];
+    band_edges.resize(band_start[bands]);
+    // Fill each band from its start, which leaves band_start[b] at the start of b + 1
+    for (int e = 0; e < n; e++) {
+        double ya = surface[e]->getPosition().y, yb = surface[(e + 1) % n]->getPosition().y;
+        for (int b = band(std::min(ya, yb)); b <= band(std::max(ya, yb)); b++) band_edges[band_start[b]++] = e;
+    }
+    for (int b = bands; b > 0; b--) band_start[b] = band_start[b - 1];
+    band_start[0] = 0;
+
+    for (auto& p : interior) {
+        const Vector2& pos = p->getPosition();
+        if (!inBox(pos)) return false;
+        int b = band(pos.y);
+        bool inside = false;
+        for (int k = band_start[b]; k < band_start[b + 1]; k++) {
+            int e = band_edges[k];
+            if (crossesLeftOf(pos, surface[e]->getPosition(), surface[(e + 1) % n]->getPosition())) inside = !inside;
+        }
+        if (!inside) return false;
+    }
+    return true;
+}
+
 json sim::SoftBody::as_json() {
     json data;
-    if (mesh_unit < 0) return data;
-    data["firction"] = friction;
+    data["friction"] = friction;
     data["restitution"] = restitution;
+    data["collision_layer"] = collision_layer;
+    data["collision_mask"] = collision_mask;
+    if (prototype) {
+        data["prototype"] = prototype->as_json();
+        data["translation"] = translation.as_json();
+        data["rotation"] = rotation;
+        return data;
+    }
+    if (mesh_unit < 0 || border.empty() || constraints.empty()) {
+        // Hand-built body: store the particles and constraints themselves
+        data["particles"] = json::array();
+        data["constraints"] = json::array();
+        std::unordered_map<Particle*, int> index;
+        for (int i = 0; i < (int)particles.size(); i++) {
+            Particle* p = particles[i];
+            index[p] = i;
+            json jp;
+            jp["position"] = p->getPosition().as_json();
+            jp["mass"] = p->getMass();
+            jp["radius"] = p->getRadius();
+            jp["pinned"] = p->isPinned();
+            data["particles"].push_back(jp);
+        }
+        for (auto c: constraints) {
+            json jc;
+            jc["a"] = index[c->getParticle1()];
+            jc["b"] = index[c->getParticle2()];
+            jc["rest_length"] = c->getRestLength();
+            jc["stiffness"] = c->getStiffness();
+            jc["damping"] = c->getDamping();
+            data["constraints"].push_back(jc);
+        }
+        return data;
+    }
     data["mesh_unit"] = mesh_unit;
+    data["mesh_type"] = mesh_type;
+    data["reorder"] = reordered;
     data["radius"]  = border[0]->getRadius();
     data["mass"]  = border[0]->getMass();
     data["pinned"]  = border[0]->isPinned();
     data["stiffness"]  = constraints[0]->getStiffness();
     data["damping"]  = constraints[0]->getDamping();
-    for (auto b: border){
-        data["border"].push_back(b->as_json());
+    for (auto b: rest_border){
+        data["border"].push_back(b.as_json());
     }
     return data;
 }
 
 SoftBody *sim::SoftBody::from_json(json data) {
-    std::vector<Vector2> border;
-    for (auto b: data["border"])
-        border.push_back(Particle::from_json(b));
-    int unit = data["mesh_unit"];
-    double mass =  data["mass"];
-    double radius = data["radius"];
-    bool is_pinned = data["pinned"];
-    double stiffness = data["stiffness"];
-    double damping = data["damping"];
-    double friction = data["friction"];
-    double restitution = data["restitution"];
-    return createFromPolygon(border, unit,
-        mass, radius,
-        stiffness, damping,
-        friction, restitution, is_pinned
-    );
+    SoftBody* body;
+    if (data.contains("prototype")) {
+        body = instantiate(SoftBodyPrototype::from_json(data["prototype"]),
+            Vector2::from_json(data["translation"]), data["rotation"]);
+        body->setFriction(data["friction"]);
+        body->setRestitution(data["restitution"]);
+    } else if (data.contains("particles")) {
+        std::vector<Particle*> parts;
+        std::vector<Constraint*> cons;
+        for (auto jp: data["particles"])
+            parts.push_back(new Particle(Vector2::from_json(jp["position"]),
+                jp["mass"], jp["radius"], jp["pinned"]));
+        for (auto jc: data["constraints"]) {
+            Constraint* c = new Constraint(parts[jc["a"]], parts[jc["b"]], jc["stiffness"], jc["damping"]);
+            c->setRestLength(jc["rest_length"]);
+            cons.push_back(c);
+        }
+        body = new SoftBody(parts, cons, data["friction"], data["restitution"]);
+    } else {
+        std::vector<Vector2> border;
+        for (auto b: data["border"])
+            border.push_back(Particle::from_json(b));
+        int unit = data["mesh_unit"];
+        double mass =  data["mass"];
+        double radius = data["radius"];
+        bool is_pinned = data["pinned"];
+        double stiffness = data["stiffness"];
+        double damping = data["damping"];
+        double friction = data["friction"];
+        double restitution = data["restitution"];
+        MESH_TYPE mesh_type = data.value("mesh_type", RingMesh);
+        bool reorder = data.value("reorder", false);
+        body = createFromPolygon(border, unit,
+            mass, radius,
+            stiffness, damping,
+            friction, restitution, is_pinned, mesh_type, reorder
+        );
+    }
+    body->setCollisionLayer(data.value("collision_layer", 1u));
+    body->setCollisionMask(data.value("collision_mask", 1u));
+    return body;
+}
+
+json sim::SoftBody::state_as_json() {
+    json data = json::array();
+    for (auto p: particles) {
+        data.push_back(p->getPosition().x);
+        data.push_back(p->getPosition().y);
+        data.push_back(p->getPrevPosition().x);
+        data.push_back(p->getPrevPosition().y);
+    }
+    return data;
+}
+
+bool sim::SoftBody::state_from_json(const json& data) {
+    if (data.size() != 4 * particles.size()) return false;
+    for (size_t i = 0; i < particles.size(); i++) {
+        particles[i]->setPosition(Vector2(data[4*i], data[4*i + 1]));
+        particles[i]->setPrevPosition(Vector2(data[4*i + 2], data[4*i + 3]));
+    }
+    return true;
 }
@@ -1,5 +1,9 @@
 #include "SoftBody.h"
+#include "MeshCache.h"
+#include "Morton.h"
+#include "Trace.h"
 
+#include <cstdint>
 #include <unordered_set>
 #include <unordered_map>
 #include <functional>
@@ -14,79 +18,107 @@ static double PI = 3.14;
 // ---------------------------------------------------------------------------
 
 /**
- * @brief Node structure for linked list to store unique Vector2 points with tolerance
+ * @brief Spatial hash to manage unique Vector2 points with tolerance
+ *
+ * Points are bucketed in square cells of side `cell`. As long as the tolerance
+ * does not exceed the cell size, two matching points lie in the same or in
+ * adjacent cells, so a lookup only scans the 3x3 neighbourhood.
  */
-struct VecNode {
-    Vector2 point;
-    int id;
-    VecNode* next = nullptr;
-    VecNode(Vector2 p, int i): point(p), id(i) {}
-};
+class PointGrid {
+    struct Cell {
+        long long x, y;
+        bool operator==(const Cell& o) const { return x == o.x && y == o.y; }
+    };
+    struct CellHash {
+        size_t operator()(const Cell& c) const noexcept {
+            size_t h1 = std::hash<long long>()(c.x);
+            size_t h2 = std::hash<long long>()(c.y);
+            return h1 ^ (h2 + 0x9e3779b97f4a7c15ULL + (h1<<6) + (h1>>2));
+        }
+    };
+    struct Entry {
+        Vector2 point;
+        int id;
+    };
 
-/**
- * @brief Linked list to manage unique Vector2 points with tolerance
- */
-class VecList {
+    double cell;
     double eps;
-    VecNode* root = nullptr;
+    std::unordered_map<Cell, std::vector<Entry>, CellHash> cells;
 
-    bool VecEq(const Vector2& a, const Vector2& b) const {
-        return (a - b).length() <= eps;
+    Cell cellOf(const Vector2& p) const {
+        return { (long long)std::floor(p.x / cell), (long long)std::floor(p.y / cell) };
     }
 
-    bool exist(VecNode* node, const Vector2& p) {
-        if (VecEq(node->point, p)) return true;
-        if (!node->next) return false;
-        return exist(node->next, p);
-    }
-    int find(VecNode* node, const Vector2& p, int p_id) {
-        if (VecEq(node->point, p)) {
-            return node->id;
-        }
-        if (!node->next) {
-            node->next = new VecNode(p, p_id);
-            return p_id;
+    // Lowest id within eps of p (the first inserted one), -1 if none
+    int lookup(const Vector2& p) const {
+        Cell c = cellOf(p);
+        long long r = std::max(1LL, (long long)std::ceil(eps / cell));
+        double eps2 = eps * eps;
+        int best = -1;
+        for (long long dx = -r; dx <= r; dx++) {
+            for (long long dy = -r; dy <= r; dy++) {
+                auto it = cells.find({c.x + dx, c.y + dy});
+                if (it == cells.end()) continue;
+                for (auto& e : it->second) {
+                    if ((e.point - p).lengthSquared() <= eps2 && (best < 0 || e.id < best))
+                        best = e.id;
+                }
+            }
         }
-        return find(node->next, p, p_id);
-    }
-    void clear(VecNode* node) {
-        if (node->next) clear(node);
-        delete node;
+        return best;
     }
 public:
-    VecList(double tolerance) : eps(tolerance) {}
-
-    bool exist(const Vector2& p){
-        if (!root) return false;
-        return exist(root, p);
+    /**
+     * @param cell_size Side of the hash cells, should be the largest tolerance used
+     * @param tolerance Distance under which two points are considered equal
+     */
+    PointGrid(double cell_size, double tolerance)
+        : cell(std::max(cell_size, 1e-12)), eps(tolerance) {}
+
+    bool exist(const Vector2& p) const {
+        return lookup(p) >= 0;
     }
     int find(const Vector2& p, int p_id) {
-        if (!root) {
-            root = new VecNode(p, p_id);
-            return p_id;
+        int id = lookup(p);
+        if (id >= 0) return id;
+        cells[cellOf(p)].push_back({p, p_id});
+        return p_id;
+    }
+    /**
+     * @brief Collect the points closer than r to p, nearest first
+     */
+    void within(const Vector2& p, double r, std::vector<std::pair<double,int>>& out) const {
+        out.clear();
+        Cell c = cellOf(p);
+        long long n = std::max(1LL, (long long)std::ceil(r / cell));
+        for (long long dx = -n; dx <= n; dx++) {
+            for (long long dy = -n; dy <= n; dy++) {
+                auto it = cells.find({c.x + dx, c.y + dy});
+                if (it == cells.end()) continue;
+                for (auto& e : it->second) {
+                    double d = (e.point - p).length();
+                    if (d <= r) out.push_back({d, e.id});
+                }
+            }
         }
-        return find(root, p, p_id);
+        std::sort(out.begin(), out.end());
     }
     void set_eps(const double& e) { eps = e; }
-    void clear() {
-        if (!root) return;
-        clear(root);
-        delete root;
-    }
+    void clear() { cells.clear(); }
 };
 
 /**
- * @brief Get unique ID for a Vector2 point, adding it to the list if not present
+ * @brief Get unique ID for a Vector2 point, adding it to the grid if not present
  * 
  * @param p The Vector2 point
- * @param idmap The VecList managing unique points
+ * @param idmap The PointGrid managing unique points
  * @param pts The vector of unique points
  * @return The unique ID of the point int pts
  * 
  */
 static int getID(
     const Vector2& p,
-    VecList& idmap,
+    PointGrid& idmap,
     std::vector<Vector2>& pts)
 {
     int id = (int)pts.size();
@@ -96,15 +128,15 @@ static int getID(
 }
 
 /**
- * @brief Check if a Vector2 point exists in the VecList
+ * @brief Check if a Vector2 point exists in the PointGrid
  * 
  * @param p The Vector2 point
- * @param idmap The VecList managing unique points
+ * @param idmap The PointGrid managing unique points
  * @return True if the point exists, false otherwise
  */
 static bool existId(
     const Vector2& p,
-    VecList& idmap)
+    PointGrid& idmap)
 {
     return idmap.exist(p);
 }
@@ -129,33 +161,41 @@ struct EdgeHash {
 };
 
 // ---------------------------------------------------------------------------
-// Convex polygon point-in-test (fast): check if always same sign
+// Polygon scanlines (convex or concave): even-odd rule, see pointInPolygon()
 // ---------------------------------------------------------------------------
 /**
- * @brief Check if point p is inside the convex polygon defined by poly vertices
+ * @brief Sorted x coordinates where the horizontal line at y crosses the polygon
+ * 
+ * Computed once per scanline in O(n log n), after which any point of the line
+ * is classified in O(log n) by insideRow().
  * 
- * @param p The point to test
- * @param poly The vertices of the convex polygon
- * @return True if point is inside the polygon, false otherwise
+ * @param y The height of the scanline
+ * @param poly The vertices of the polygon (convex or concave)
+ * @return The sorted crossing abscissas
  */
-static bool pointInConvexPolygon(const Vector2& p, const std::vector<Vector2>& poly) {
+static std::vector<double> rowCrossings(double y, const std::vector<Vector2>& poly) {
+    std::vector<double> xs;
     int n = (int)poly.size();
-    if (n < 3) return false;
-
-    // Determine sign using first non-zero cross
-    double sign = 0.0;
     for (int i = 0; i < n; ++i) {
         const Vector2& a = poly[i];
         const Vector2& b = poly[(i + 1) % n];
-        Vector2 edge = b - a;
-        Vector2 ap = p - a;
-        double c = edge.cross(ap);
-        if (std::abs(c) > 1e-9) {
-            if (sign == 0.0) sign = c;
-            else if (sign * c < 0.0) return false;
-        }
+        // Half-open rule so shared vertices are counted once
+        if ((a.y <= y) != (b.y <= y))
+            xs.push_back(a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y));
     }
-    return true;
+    std::sort(xs.begin(), xs.end());
+    return xs;
+}
+
+/**
+ * @brief Check if abscissa x of a scanline is inside the polygon
+ * 
+ * @param xs The crossings of the scanline, from rowCrossings()
+ * @param x The abscissa to test
+ * @return True if an odd number of crossings lie left of x
+ */
+static bool insideRow(const std::vector<double>& xs, double x) {
+    return (std::upper_bound(xs.begin(), xs.end(), x) - xs.begin()) % 2 == 1;
 }
 
 // ---------------------------------------------------------------------------
@@ -191,7 +231,7 @@ inline bool isClockwise(const std::vector<Vector2>& poly) {
 /**
  * @brief Create a mesh of points inside the polygon by generating inward rings
  * 
- * @param idmap The VecList managing unique points
+ * @param idmap The PointGrid managing unique points
  * @param pts The vector of unique points
  * @param edgeSet The set of edges to populate
  * @param polygon The vertices of the polygon
@@ -201,7 +241,7 @@ inline bool isClockwise(const std::vector<Vector2>& poly) {
  * @param border_spacing The border spacing for point deduplication
  */
 static void meshPolygone(
-    VecList& idmap,
+    PointGrid& idmap,
     std::vector<Vector2>& pts,
     std::unordered_set<Edge, EdgeHash>* edgeSet,
     const std::vector<Vector2>& polygon,
@@ -273,6 +313,7 @@ static void meshPolygone(
                 nextRingIdx.push_back(i);
             }
         }
+        if (nextRing.empty()) break;
         if (border) {
             for (int j = 0; j < nextRingIdx[0]; j++){
                 nextRing.push_back(nextRing.back());
@@ -319,9 +360,9 @@ static void meshPolygone(
 
         }
         ring.clear();
+        PointGrid ringSet(spacing, 1e-8);
         for (auto p: nextRing){
-            auto it = std::find(ring.begin(), ring.end(), p);
-            if (it == ring.end()){
+            if (ringSet.find(p, (int)ring.size()) == (int)ring.size()){
                 ring.push_back(p);
             }
         }
@@ -336,29 +377,132 @@ static void meshPolygone(
 
 
 // ---------------------------------------------------------------------------
-// High-level function: create SoftBody from polygon
+// Create mesh from a triangular lattice
+// ---------------------------------------------------------------------------
+/**
+ * @brief Fill the polygon with a triangular lattice and stitch it to the border
+ * 
+ * Rows are spaced by spacing * sqrt(3) / 2 and every other row is shifted by
+ * half a spacing, so interior particles form equilateral triangles. Lattice
+ * points closer than half a spacing to the border are dropped, then every
+ * border point is linked to its nearest lattice points. The particle count
+ * only depends on the polygon area and outline, not on its vertex order.
+ * 
+ * @param idmap The PointGrid managing unique points (holds the border points)
+ * @param pts The vector of unique points
+ * @param edgeSet The set of edges to populate
+ * @param polygon The vertices of the polygon
+ * @param segments The subdivided segments along the polygon edges
+ * @param spacing The lattice spacing
+ */
+static void meshLattice(
+    PointGrid& idmap,
+    std::vector<Vector2>& pts,
+    std::unordered_set<Edge, EdgeHash>* edgeSet,
+    const std::vector<Vector2>& polygon,
+    const std::vector<std::vector<Vector2>>& segments,
+    double spacing
+)
+{
+    // ---- 1. Border points, looked up for clearance and stitching ----
+    std::vector<int> ring;
+    for (auto& seg : segments)
+        for (int i = 0; i + 1 < (int)seg.size(); i++)
+            ring.push_back(getID(seg[i], idmap, pts));
+    if (ring.size() < 3 || spacing <= 0) return;
+
+    double clearance = 0.5 * spacing;
+    PointGrid borderGrid(clearance, clearance);
+    for (int id : ring) borderGrid.find(pts[id], id);
+
+    Vector2 lo = polygon[0], hi = polygon[0];
+    for (auto& p : polygon) {
+        lo = Vector2(std::min(lo.x, p.x), std::min(lo.y, p.y));
+        hi = Vector2(std::max(hi.x, p.x), std::max(hi.y, p.y));
+    }
+
+    // ---- 2. Lattice points clipped by the polygon, one scanline per row ----
+    double h = spacing * std::sqrt(3.0) / 2.0;
+    int rows = (int)std::floor((hi.y - lo.y) / h) + 1;
+    int cols = (int)std::floor((hi.x - lo.x) / spacing) + 2;
+    std::vector<std::vector<int>> lattice(rows, std::vector<int>(cols, -1));
+    PointGrid latticeGrid(spacing, 0.0);
+    for (int j = 0; j < rows; j++) {
+        double y = lo.y + j * h;
+        double offset = (j % 2) ? 0.5 * spacing : 0.0;
+        std::vector<double> xs = rowCrossings(y, polygon);
+        if (xs.empty()) continue;
+        for (int i = 0; i < cols; i++) {
+            Vector2 p(lo.x + offset + i * spacing, y);
+            if (!insideRow(xs, p.x) || borderGrid.exist(p)) continue;
+            int id = (int)pts.size();
+            pts.push_back(p);
+            latticeGrid.find(p, id);
+            lattice[j][i] = id;
+        }
+    }
+
+    // ---- 3. Lattice edges: right neighbour and the two neighbours above ----
+    auto link = [&](int a, int b) {
+        if (a < 0 || b < 0) return;
+        edgeSet->insert({std::min(a,b), std::max(a,b)});
+    };
+    for (int j = 0; j < rows; j++) {
+        for (int i = 0; i < cols; i++) {
+            int id = lattice[j][i];
+            if (id < 0) continue;
+            if (i + 1 < cols) link(id, lattice[j][i+1]);
+            if (j + 1 < rows) {
+                // Even rows sit half a spacing left of odd rows
+                int left = (j % 2) ? i : i - 1;
+                if (left >= 0) link(id, lattice[j+1][left]);
+                if (left + 1 < cols) link(id, lattice[j+1][left+1]);
+            }
+        }
+    }
+
+    // ---- 4. Stitch the border to its nearest lattice points ----
+    std::vector<std::pair<double,int>> near;
+    bool stitched = false;
+    for (int id : ring) {
+        latticeGrid.within(pts[id], 1.6 * spacing, near);
+        for (int k = 0; k < (int)near.size() && k < 3; k++) {
+            link(id, near[k].second);
+            stitched = true;
+        }
+    }
+
+    // ---- 5. Polygon thinner than the lattice: brace the border with its centroid ----
+    if (!stitched) {
+        Vector2 c;
+        for (int id : ring) c += pts[id];
+        c /= (double)ring.size();
+        int c_idx = (int)pts.size();
+        pts.push_back(c);
+        for (int id : ring) link(id, c_idx);
+    }
+}
+
+
+// ---------------------------------------------------------------------------
+// Meshing: polygon to points and edges
 // ---------------------------------------------------------------------------
 
-SoftBody* SoftBody::createFromPolygon(
+MeshData sim::meshPolygon(
     const std::vector<Vector2>& polygon, int mesh_unit,
-    double mass, double radius,
-    double stiffness, double damping,
-    double friction, double restitution,
-    bool is_pinned
+    double radius, MESH_TYPE mesh_type, bool reorder
 )
 {
-    std::vector<Particle*> _particles;
-    std::vector<Constraint*> _constraints;
-    std::vector<Particle*> _border;
-
-    std::vector<Vector2> pts;
+    TraceScope trace("meshPolygon", "mesh");
+    MeshData mesh;
+    std::vector<Vector2>& pts = mesh.points;
     std::vector<std::vector<Vector2>> segments;
 
     double grid_space = mesh_unit*0.9;
     double border_space = radius *0.9;
     std::unordered_set<Edge, EdgeHash> edgeSet;
-    VecList idmap(border_space);
-    idmap.clear();
+    // Cells must cover the largest tolerance used while meshing
+    PointGrid idmap(std::max(grid_space, border_space), border_space);
     
     // 1) Create subdivided border points
     for (int i = 0; i < (int)polygon.size(); ++i) {
@@ -382,34 +526,142 @@ SoftBody* SoftBody::createFromPolygon(
         }
     }
 
-    // 2) Generate interior grid and edges
-    meshPolygone(idmap, pts, &edgeSet, polygon, segments, mesh_unit, grid_space, border_space);
-
-    // 3) Add centroid constraint
-    int c_idx = pts.size()-1;
-    for (auto seg: segments) {
-        for (int j = 0; j < seg.size(); ++j) {
-            Vector2 s1 = seg[j];
-            int id1 = getID(s1, idmap, pts);
+    if (mesh_type == LatticeMesh) {
+        // 2) Fill the interior with a clipped triangular lattice
+        meshLattice(idmap, pts, &edgeSet, polygon, segments, mesh_unit);
+    } else {
+        // 2) Generate interior grid and edges
+        meshPolygone(idmap, pts, &edgeSet, polygon, segments, mesh_unit, grid_space, border_space);
+
+        // 3) Add centroid constraint
+        int c_idx = pts.size()-1;
+        for (auto seg: segments) {
+            for (int j = 0; j < seg.size(); ++j) {
+                Vector2 s1 = seg[j];
+                int id1 = getID(s1, idmap, pts);
+
+                // Add edge to the boundary
+                Edge e{ std::min(id1,c_idx), std::max(id1,c_idx) };
+                edgeSet.insert(e);
+            }
+        }
+    }
 
-            // Add edge to the boundary
-            Edge e{ std::min(id1,c_idx), std::max(id1,c_idx) };
-            edgeSet.insert(e);
+    // 4) Locate the polygon corners and the whole outline, the only
+    //    particles other bodies and the colliders can reach
+    idmap.set_eps(border_space);
+    for (auto& p: polygon) {
+        mesh.border.push_back(getID(p, idmap, pts));
+    }
+    for (auto& seg : segments) {
+        for (int j = 0; j + 1 < (int)seg.size(); ++j) {
+            int id = getID(seg[j], idmap, pts);
+            if (mesh.surface.empty() || mesh.surface.back() != id) mesh.surface.push_back(id);
         }
     }
+    while (mesh.surface.size() > 1 && mesh.surface.back() == mesh.surface.front()) {
+        mesh.surface.pop_back();
+    }
+    // 5) Export the edges, dropping the ones collapsed onto a single point by getID
+    for (auto e : edgeSet) {
+        if (e.a != e.b) mesh.edges.push_back({e.a, e.b});
+    }
+    // 6) Renumber for memory locality
+    if (reorder) {
+        reorderMesh(mesh, std::max(1.0, std::min(double(mesh_unit), radius)));
+    }
+    return mesh;
+}
+
+void sim::reorderMesh(MeshData& mesh, double cell) {
+    TraceScope trace("reorderMesh", "mesh");
+    size_t n = mesh.points.size();
+    if (n == 0) return;
+
+    Vector2 lo = mesh.points[0];
+    for (auto& p : mesh.points) {
+        lo.x = std::min(lo.x, p.x);
+        lo.y = std::min(lo.y, p.y);
+    }
+
+    // Sort by Morton code, ties broken by position so the order is total
+    std::vector<uint64_t> codes(n);
+    for (size_t i = 0; i < n; i++) {
+        Vector2 q = (mesh.points[i] - lo) / cell;
+        codes[i] = mortonCode((uint32_t)std::min(q.x, 4294967295.0), (uint32_t)std::min(q.y, 4294967295.0));
+    }
+    std::vector<int> order(n);
+    for (size_t i = 0; i < n; i++) order[i] = (int)i;
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        if (codes[a] != codes[b]) return codes[a] < codes[b];
+        if (mesh.points[a].y != mesh.points[b].y) return mesh.points[a].y < mesh.points[b].y;
+        return mesh.points[a].x < mesh.points[b].x;
+    });
+
+    // order[new] = old, remap[old] = new
+    std::vector<int> remap(n);
+    std::vector<Vector2> points(n);
+    for (size_t i = 0; i < n; i++) {
+        remap[order[i]] = (int)i;
+        points[i] = mesh.points[order[i]];
+    }
+    mesh.points = std::move(points);
+
+    for (auto& e : mesh.edges) {
+        int a = remap[e.first], b = remap[e.second];
+        e = { std::min(a, b), std::max(a, b) };
+    }
+    std::sort(mesh.edges.begin(), mesh.edges.end());
+    for (auto& b : mesh.border) b = remap[b];
+    for (auto& s : mesh.surface) s = remap[s];
+}
+
+
+// ---------------------------------------------------------------------------
+// High-level function: create SoftBody from polygon
+// ---------------------------------------------------------------------------
+
+SoftBody* SoftBody::createFromPolygon(
+    const std::vector<Vector2>& polygon, int mesh_unit,
+    double mass, double radius,
+    double stiffness, double damping,
+    double friction, double restitution,
+    bool is_pinned,
+    MESH_TYPE mesh_type,
+    bool reorder
+)
+{
+    TraceScope trace("createFromPolygon", "mesh");
+    std::shared_ptr<const MeshData> mesh = MeshCache::instance().mesh(polygon, mesh_unit, radius, mesh_type, reorder);
+    SoftBody* body = createFromMesh(*mesh, mesh_unit, mass, radius, stiffness, damping, friction, restitution, is_pinned, mesh_type);
+    body->reordered = reorder;
+    return body;
+}
+
+SoftBody* SoftBody::createFromMesh(
+    const MeshData& mesh, int mesh_unit,
+    double mass, double radius,
+    double stiffness, double damping,
+    double friction, double restitution,
+    bool is_pinned,
+    MESH_TYPE mesh_type
+)
+{
+    std::vector<Particle*> _particles;
+    std::vector<Constraint*> _constraints;
+    std::vector<Particle*> _border;
 
-    // 4) Build particles for all pts
-    for (auto& p : pts) {
+    for (auto& p : mesh.points) {
         _particles.push_back(new Particle(p, mass, radius, is_pinned));
     }
-    idmap.set_eps(border_space);
-    for (auto& p: polygon) {
-        auto idx = getID(p, idmap, pts);
+    for (int idx : mesh.border) {
         _border.push_back(_particles[idx]);
     }
-    // 6) Convert edgeSet into constraints
-    for (auto e : edgeSet) {
-        _constraints.push_back(new Constraint(_particles[e.a], _particles[e.b], stiffness, damping));
+    for (auto& e : mesh.edges) {
+        _constraints.push_back(new Constraint(_particles[e.first], _particles[e.second], stiffness, damping));
     }
-    return new SoftBody(_border, _particles, _constraints, friction, restitution, mesh_unit);
+    SoftBody* body = new SoftBody(_border, _particles, _constraints, friction, restitution, mesh_unit);
+    body->mesh_type = mesh_type;
+    if (!mesh.surface.empty()) body->setOutline(mesh.surface);
+    return body;
 }
@@ -0,0 +1,81 @@
+#include "SoftBodyPrototype.h"
+#include "MeshCache.h"
+#include "Trace.h"
+
+using namespace sim;
+
+std::shared_ptr<const SoftBodyPrototype> SoftBodyPrototype::createFromPolygon(
+    const std::vector<Vector2>& polygon, int mesh_unit,
+    double mass, double radius,
+    double stiffness, double damping,
+    double friction, double restitution,
+    bool is_pinned,
+    MESH_TYPE mesh_type,
+    bool reorder
+)
+{
+    TraceScope trace("SoftBodyPrototype::createFromPolygon", "mesh");
+    std::shared_ptr<const MeshData> mesh = MeshCache::instance().mesh(polygon, mesh_unit, radius, mesh_type, reorder);
+    return createFromMesh(*mesh, mesh_unit, mass, radius, stiffness, damping, friction, restitution, is_pinned, mesh_type, reorder);
+}
+
+std::shared_ptr<const SoftBodyPrototype> SoftBodyPrototype::createFromMesh(
+    const MeshData& mesh, int mesh_unit,
+    double mass, double radius,
+    double stiffness, double damping,
+    double friction, double restitution,
+    bool is_pinned,
+    MESH_TYPE mesh_type,
+    bool reordered
+)
+{
+    std::shared_ptr<SoftBodyPrototype> proto(new SoftBodyPrototype());
+    proto->rest_positions = mesh.points;
+    proto->edges = mesh.edges;
+    proto->border = mesh.border;
+    proto->surface = mesh.surface;
+    proto->rest_lengths.reserve(mesh.edges.size());
+    for (auto& e : mesh.edges)
+        proto->rest_lengths.push_back(dist(mesh.points[e.first], mesh.points[e.second]));
+    proto->mass = mass;
+    proto->radius = radius;
+    proto->stiffness = stiffness;
+    proto->damping = damping;
+    proto->friction = friction;
+    proto->restitution = restitution;
+    proto->pinned = is_pinned;
+    proto->mesh_unit = mesh_unit;
+    proto->mesh_type = mesh_type;
+    proto->reordered = reordered;
+    return proto;
+}
+
+json SoftBodyPrototype::as_json() const {
+    json data;
+    data["friction"] = friction;
+    data["restitution"] = restitution;
+    data["mesh_unit"] = mesh_unit;
+    data["mesh_type"] = mesh_type;
+    data["reorder"] = reordered;
+    data["radius"] = radius;
+    data["mass"] = mass;
+    data["pinned"] = pinned;
+    data["stiffness"] = stiffness;
+    data["damping"] = damping;
+    data["border"] = json::array();
+    for (int b : border)
+        data["border"].push_back(rest_positions[b].as_json());
+    return data;
+}
+
+std::shared_ptr<const SoftBodyPrototype> SoftBodyPrototype::from_json(const json& data) {
+    std::vector<Vector2> polygon;
+    for (auto& b : data["border"])
+        polygon.push_back(Vector2::from_json(b));
+    return createFromPolygon(polygon, data["mesh_unit"],
+        data["mass"], data["radius"],
+        data["stiffness"], data["damping"],
+        data["friction"], data["restitution"],
+        data["pinned"], data.value("mesh_type", RingMesh),
+        data.value("reorder", false));
+}
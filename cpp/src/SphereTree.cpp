@@ -0,0 +1,87 @@
+#include "SphereTree.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace sim;
+
+// Particles per cluster
+static constexpr int LEAF_SIZE = 8;
+
+void SphereTree::build(const std::vector<Particle*>& particles) {
+    this->particles = &particles;
+    int n = (int)particles.size();
+    order.resize(n);
+    for (int i = 0; i < n; i++) order[i] = i;
+    nodes.clear();
+    if (n == 0) return;
+    nodes.reserve(2 * (n / LEAF_SIZE + 1));
+    build(0, n);
+    refit();
+}
+
+int SphereTree::build(int begin, int end) {
+    int index = (int)nodes.size();
+    nodes.push_back({});
+    if (end - begin <= LEAF_SIZE) {
+        nodes[index].first = begin;
+        nodes[index].count = end - begin;
+        return index;
+    }
+
+    // Median split of the positions along the longest axis
+    Vector2 lo = (*particles)[order[begin]]->getPosition(), hi = lo;
+    for (int i = begin + 1; i < end; i++) {
+        const Vector2& p = (*particles)[order[i]]->getPosition();
+        lo = Vector2(std::min(lo.x, p.x), std::min(lo.y, p.y));
+        hi = Vector2(std::max(hi.x, p.x), std::max(hi.y, p.y));
+    }
+    bool alongX = hi.x - lo.x >= hi.y - lo.y;
+    auto coord = [&](int i) {
+        const Vector2& p = (*particles)[i]->getPosition();
+        return alongX ? p.x : p.y;
+    };
+    int mid = (begin + end) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+                     [&](int l, int r) { return coord(l) < coord(r); });
+
+    build(begin, mid);
+    int right = build(mid, end);
+    nodes[index].first = right;
+    nodes[index].count = 0;
+    return index;
+}
+
+void SphereTree::refit() {
+    // Children follow their parent, so a reverse sweep sees them fitted first
+    for (int k = (int)nodes.size() - 1; k >= 0; k--) {
+        Node& node = nodes[k];
+        if (node.count > 0) {
+            Vector2 c;
+            for (int i = node.first; i < node.first + node.count; i++)
+                c += (*particles)[order[i]]->getPosition();
+            c /= (double)node.count;
+            double r = 0.0;
+            for (int i = node.first; i < node.first + node.count; i++) {
+                const Particle* p = (*particles)[order[i]];
+                r = std::max(r, (p->getPosition() - c).length() + p->getRadius());
+            }
+            node.center = c;
+            node.radius = r;
+            continue;
+        }
+        // Smallest sphere enclosing both children
+        const Node& l = nodes[k + 1];
+        const Node& r = nodes[node.first];
+        double d = (r.center - l.center).length();
+        if (d + r.radius <= l.radius) {
+            node.center = l.center;
+            node.radius = l.radius;
+        } else if (d + l.radius <= r.radius) {
+            node.center = r.center;
+            node.radius = r.radius;
+        } else {
+            node.radius = 0.5 * (d + l.radius + r.radius);
+            node.center = l.center + (r.center - l.center) * ((node.radius - l.radius) / d);
+        }
+    }
+}
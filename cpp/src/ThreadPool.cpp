@@ -0,0 +1,71 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include "Trace.h"
+
+using namespace sim;
+
+ThreadPool::ThreadPool(int threads) {
+    for (int i = 1; i < threads; i++)
+        workers.emplace_back([this] { work(); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& w : workers) w.join();
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+    grain = std::max<size_t>(grain, 1);
+    if (workers.empty() || count <= grain) {
+        for (size_t begin = 0; begin < count; begin += grain)
+            fn(begin, std::min(begin + grain, count));
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        job_count = count;
+        job_grain = grain;
+        next = 0;
+        busy = (int)workers.size();
+        generation++;
+    }
+    wake.notify_all();
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busy == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::runChunks() {
+    size_t begin;
+    while ((begin = next.fetch_add(job_grain)) < job_count) {
+        // One event per chunk shows on the track of the thread that ran it
+        TraceScope trace("ThreadPool::chunk", "step");
+        (*job)(begin, std::min(begin + job_grain, job_count));
+    }
+}
+
+void ThreadPool::work() {
+    TraceRecorder::instance().setThreadName("pool worker");
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        runChunks();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy--;
+        }
+        done.notify_one();
+    }
+}
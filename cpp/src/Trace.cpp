@@ -0,0 +1,159 @@
+#include "Trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+using namespace sim;
+
+TraceRecorder& TraceRecorder::instance() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+uint64_t TraceRecorder::now() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count();
+}
+
+void TraceRecorder::enable(size_t events_per_thread) {
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        if (buffers.empty()) capacity = std::max<size_t>(1, events_per_thread);
+    }
+    now(); // pin the epoch before the first event
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+// Static initialization runs on the thread loading the library, the main thread
+static const std::thread::id main_thread = std::this_thread::get_id();
+
+TraceRecorder::BufferLease& TraceRecorder::lease() {
+    thread_local BufferLease local;
+    return local;
+}
+
+TraceRecorder::BufferLease::~BufferLease() {
+    if (!buffer) return;
+    TraceRecorder& recorder = instance();
+    std::lock_guard<std::mutex> lock(recorder.registry_mutex);
+    recorder.free_buffers.push_back(buffer);
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::localBuffer() {
+    // The buffer stays valid until the thread exits, the lease then frees it for another thread
+    BufferLease& local = lease();
+    if (local.buffer) return local.buffer;
+
+    const char* name = local.name ? local.name : std::this_thread::get_id() == main_thread ? "main" : nullptr;
+    auto sameName = [&](const ThreadBuffer* b) {
+        return b->name == name || (b->name && name && std::strcmp(b->name, name) == 0);
+    };
+
+    // Only a track of the same name is continued, e.g. by the workers of a recreated pool
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto it = std::find_if(free_buffers.rbegin(), free_buffers.rend(), sameName);
+    if (it != free_buffers.rend()) {
+        local.buffer = *it;
+        free_buffers.erase(std::next(it).base());
+        return local.buffer;
+    }
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->events.resize(capacity);
+    buffer->tid = (uint32_t)buffers.size();
+    buffer->name = name;
+    local.buffer = buffer.get();
+    buffers.push_back(std::move(buffer));
+    return local.buffer;
+}
+
+void TraceRecorder::setThreadName(const char* name) {
+    BufferLease& local = lease();
+    local.name = name;
+    if (!local.buffer) return;
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    local.buffer->name = name;
+}
+
+void TraceRecorder::record(const char* name, const char* category, uint64_t start_ns, uint64_t duration_ns) {
+    ThreadBuffer* buffer = localBuffer();
+    size_t i = buffer->count.load(std::memory_order_relaxed);
+    if (i >= buffer->events.size()) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events[i] = TraceEvent{name, category, start_ns, duration_ns};
+    buffer->count.store(i + 1, std::memory_order_release);
+}
+
+void TraceRecorder::clear() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (auto& b : buffers) {
+        b->count.store(0, std::memory_order_relaxed);
+        b->dropped.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t TraceRecorder::eventCount() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    size_t n = 0;
+    for (auto& b : buffers)
+        n += b->count.load(std::memory_order_acquire);
+    return n;
+}
+
+size_t TraceRecorder::droppedCount() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    size_t n = 0;
+    for (auto& b : buffers)
+        n += b->dropped.load(std::memory_order_relaxed);
+    return n;
+}
+
+json TraceRecorder::as_json() {
+    json events = json::array();
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (auto& b : buffers) {
+        size_t n = b->count.load(std::memory_order_acquire);
+        if (n == 0) continue;
+
+        json meta;
+        meta["name"] = "thread_name";
+        meta["ph"] = "M";
+        meta["pid"] = 1;
+        meta["tid"] = b->tid;
+        meta["args"]["name"] = b->name ? std::string(b->name) : "thread " + std::to_string(b->tid);
+        events.push_back(meta);
+
+        for (size_t i = 0; i < n; i++) {
+            const TraceEvent& e = b->events[i];
+            json event;
+            event["name"] = e.name;
+            event["cat"] = e.category;
+            event["ph"] = "X";
+            event["ts"] = e.start_ns / 1000.0;     // microseconds
+            event["dur"] = e.duration_ns / 1000.0;
+            event["pid"] = 1;
+            event["tid"] = b->tid;
+            events.push_back(event);
+        }
+    }
+    json data;
+    data["traceEvents"] = events;
+    data["displayTimeUnit"] = "ms";
+    return data;
+}
+
+bool TraceRecorder::save(const std::string& file_path) {
+    std::ofstream file(file_path);
+    if (!file.is_open()) {
+        std::cerr << "Error: " << file_path << " is not valid!\n";
+        return false;
+    }
+    file << as_json();
+    return true;
+}
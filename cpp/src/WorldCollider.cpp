@@ -1,25 +1,64 @@
 #include "WorldCollider.h"
+#include <algorithm>
 
 #include "PlaneWorldCollider.h"
 #include "CircleWorldCollider.h"
+#include "SDFWorldCollider.h"
+#include "SegmentWorldCollider.h"
 
 using namespace sim;
 
+void WorldCollider::respond(Particle* p, const Vector2& position, const Vector2& n, const Vector2& vel,
+                            double friction, double restitution) const {
+    p->setPosition(position);
+
+    double effectiveFriction    = 0.5 * (worldFriction + friction);
+    double effectiveRestitution = std::min(worldRestitution, restitution);
+
+    double velAlongNormal = vel.dot(n);
+    Vector2 tangentVel = vel - velAlongNormal * n;
+
+    Vector2 correctedNormal = effectiveRestitution * velAlongNormal * n;
+    Vector2 correctedTangent = (1.0 - effectiveFriction) * tangentVel;
+
+    Vector2 correctedVel = correctedNormal - correctedTangent;
+    p->setPrevPosition(p->getPosition() + correctedVel);
+}
+
 WorldCollider* WorldCollider::from_json(json data) {
+    WorldCollider* collider;
     COLLIDER_TYPE ct = data["ColliderType"];
-    Vector2 point = Vector2::from_json(data["point"]);
-    double distance = data["distance"];
-    switch (ct)
-    {
-    case COLLIDER_TYPE::OuterCircleColliderType:
-        return new OuterCircleCollider(point, distance);
-        break;
-    case COLLIDER_TYPE::InnerCircleCollideTyper:
-        return new InnerCircleCollider(point, distance);
-        break;
-    case COLLIDER_TYPE::PlaneColliderType:
-    default:
-        return new PlaneCollider(point, distance);
-        break;
+    if (ct == COLLIDER_TYPE::SDFColliderType) {
+        collider = new SDFCollider(Vector2::from_json(data["origin"]), data["cell"],
+                                   data["width"], data["height"],
+                                   data["distances"].get<std::vector<double>>(),
+                                   data.value("friction", 0.1), data.value("restitution", 0.9));
+    } else if (ct == COLLIDER_TYPE::SegmentMeshColliderType) {
+        std::vector<double> flat = data["segments"];
+        std::vector<Segment> segments;
+        for (size_t i = 0; i + 3 < flat.size(); i += 4)
+            segments.push_back({ Vector2(flat[i], flat[i+1]), Vector2(flat[i+2], flat[i+3]) });
+        collider = new SegmentMeshCollider(std::move(segments),
+                                           data.value("friction", 0.1), data.value("restitution", 0.9));
+    } else {
+        Vector2 point = Vector2::from_json(data["point"]);
+        double distance = data["distance"];
+        double friction = data.value("friction", 0.1);
+        double restitution = data.value("restitution", 0.9);
+        switch (ct)
+        {
+        case COLLIDER_TYPE::OuterCircleColliderType:
+            collider = new OuterCircleCollider(point, distance, friction, restitution);
+            break;
+        case COLLIDER_TYPE::InnerCircleCollideTyper:
+            collider = new InnerCircleCollider(point, distance, friction, restitution);
+            break;
+        case COLLIDER_TYPE::PlaneColliderType:
+        default:
+            collider = new PlaneCollider(point, distance, friction, restitution);
+            break;
+        }
     }
+    collider->setCollisionMask(data.value("collision_mask", 0xFFFFFFFFu));
+    return collider;
 };
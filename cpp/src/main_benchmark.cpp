@@ -0,0 +1,692 @@
+// main_benchmark.cpp
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MeshCache.h"
+#include "Simulation.h"
+#include "PlaneWorldCollider.h"
+#include "CircleWorldCollider.h"
+#include "SDFWorldCollider.h"
+#include "SegmentWorldCollider.h"
+#include "SimulationWorker.h"
+
+using namespace sim;
+
+// Helper: wall time of a callable in milliseconds (best of `repeat` runs)
+static double timeMs(const std::function<void()>& fn, int repeat = 3) {
+    double best = 1e300;
+    for (int i = 0; i < repeat; i++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+// Helper: regular polygon with n vertices and unit edge length
+static std::vector<Vector2> regularPolygon(int n, Vector2 center = Vector2()) {
+    double R = 0.5 / std::sin(M_PI / n);
+    std::vector<Vector2> poly;
+    for (int i = 0; i < n; i++) {
+        double a = 2.0 * M_PI * i / n;
+        poly.push_back(center + Vector2(std::cos(a), std::sin(a)) * R);
+    }
+    return poly;
+}
+
+static void deleteBody(SoftBody* body) {
+    for (auto p: body->getParticles()) delete p;
+    for (auto c: body->getConstraints()) delete c;
+    delete body;
+}
+
+// ---------------------------------------------------------------------------
+// Meshing: cost of createFromPolygon as the polygon vertex count grows
+// ---------------------------------------------------------------------------
+static void benchMeshing() {
+    std::cout << "== createFromPolygon scaling (unit edges, mesh_unit = 10) ==\n";
+    std::cout << "mesher\tvertices\tparticles\tconstraints\ttime_ms\n";
+    for (MESH_TYPE type : {RingMesh, LatticeMesh}) {
+        for (int n : {500, 1000, 2000, 5000, 10000}) {
+            auto poly = regularPolygon(n);
+            size_t particles = 0, constraints = 0;
+            double ms = timeMs([&] {
+                SoftBody* body = SoftBody::createFromPolygon(poly, 10, 1, 1, 0.8, 0.1, 0.1, 0.9, false, type);
+                particles = body->getParticles().size();
+                constraints = body->getConstraints().size();
+                deleteBody(body);
+            });
+            std::cout << (type == RingMesh ? "ring" : "lattice") << "\t" << n << "\t\t"
+                      << particles << "\t\t" << constraints << "\t\t" << ms << "\n";
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Simulation: step cost of the same shape meshed by each strategy
+// ---------------------------------------------------------------------------
+static void benchMeshSimulation() {
+    std::cout << "== 200 steps of a 1000-vertex disc resting on a plane ==\n";
+    std::cout << "mesher\tparticles\tconstraints\ttime_ms\n";
+    for (MESH_TYPE type : {RingMesh, LatticeMesh}) {
+        size_t particles = 0, constraints = 0;
+        double ms = timeMs([&] {
+            Simulation sim;
+            sim.setGravity(Vector2(0, -10));
+            sim.addCollider(new PlaneCollider(Vector2(0, 1), -200.0));
+            SoftBody* body = SoftBody::createFromPolygon(regularPolygon(1000), 10, 1, 1, 0.8, 0.1, 0.1, 0.9, false, type);
+            particles = body->getParticles().size();
+            constraints = body->getConstraints().size();
+            sim.addBody(body);
+            for (int i = 0; i < 200; i++) sim.step(0.01);
+        }, 1);
+        std::cout << (type == RingMesh ? "ring" : "lattice") << "\t" << particles << "\t\t"
+                  << constraints << "\t\t" << ms << "\n";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Mesh cache: rebuilding an unchanged body, as a scene reset does
+// ---------------------------------------------------------------------------
+static void benchMeshCache() {
+    std::cout << "== createFromPolygon with and without the mesh cache ==\n";
+    std::cout << "vertices\tuncached_ms\tcached_ms\n";
+    MeshCache& cache = MeshCache::instance();
+    for (int n : {500, 2000, 10000}) {
+        auto poly = regularPolygon(n);
+        auto build = [&] { deleteBody(SoftBody::createFromPolygon(poly, 10)); };
+        cache.setEnabled(false);
+        double uncached = timeMs(build);
+        cache.setEnabled(true);
+        build();    // fill the cache
+        double cached = timeMs(build);
+        cache.clear();
+        cache.setEnabled(false);
+        std::cout << n << "\t\t" << uncached << "\t\t" << cached << "\n";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Instancing: 1000 copies of one shape, owned topology vs shared prototype
+// ---------------------------------------------------------------------------
+static void benchInstancing() {
+    const int copies = 1000;
+    std::cout << "== " << copies << " copies of a 200-vertex disc ==\n";
+    std::cout << "mode\t\tbuild_ms\tstep_ms\tbytes_per_body\n";
+    auto poly = regularPolygon(200);
+    auto proto = SoftBodyPrototype::createFromPolygon(poly, 10);
+
+    for (bool shared : {false, true}) {
+        Simulation sim;
+        double build = timeMs([&] {
+            sim.clear();
+            for (int i = 0; i < copies; i++) {
+                Vector2 offset(100.0 * (i % 40), 100.0 * (i / 40));
+                sim.addBody(shared ? SoftBody::instantiate(proto, offset)
+                                   : SoftBody::createFromPolygon(regularPolygon(200, offset), 10));
+            }
+        }, 1);
+        double step = timeMs([&] { sim.step(0.01); });
+
+        // Heap owned per body: particles, constraints and the pointer arrays
+        SoftBody* body = sim.getBodies()[0];
+        size_t bytes = body->getParticles().size() * (sizeof(Particle) + sizeof(Particle*))
+                     + body->getConstraints().size() * (sizeof(Constraint) + sizeof(Constraint*))
+                     + body->getBorder().size() * sizeof(Particle*);
+        std::cout << (shared ? "prototype" : "owned\t") << "\t" << build << "\t\t"
+                  << step << "\t" << bytes << "\n";
+    }
+    std::cout << "shared prototype: " << proto->getEdges().size() * (sizeof(std::pair<int,int>) + sizeof(double))
+                 + proto->getRestPositions().size() * sizeof(Vector2) << " bytes once\n";
+}
+
+// ---------------------------------------------------------------------------
+// Reordering: constraint solve cost with and without the locality pass
+// ---------------------------------------------------------------------------
+static void benchReorder() {
+    std::cout << "== 100 constraint solves of a 5000-vertex disc ==\n";
+    std::cout << "mesher\treorder\tparticles\tconstraints\ttime_ms\n";
+    for (MESH_TYPE type : {RingMesh, LatticeMesh}) {
+        for (bool reorder : {false, true}) {
+            SoftBody* body = SoftBody::createFromPolygon(regularPolygon(5000), 5, 1, 1, 0.8, 0.1, 0.1, 0.9, false, type, reorder);
+            double ms = timeMs([&] {
+                for (int i = 0; i < 100; i++) body->solveConstraint();
+            });
+            std::cout << (type == RingMesh ? "ring" : "lattice") << "\t" << (reorder ? "yes" : "no") << "\t"
+                      << body->getParticles().size() << "\t\t" << body->getConstraints().size() << "\t\t" << ms << "\n";
+            deleteBody(body);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Sorting: periodic Z-order re-sort of the particle storage
+// ---------------------------------------------------------------------------
+static void benchSort() {
+    std::cout << "== 300 steps of 64 overlapping 60-vertex discs on a plane ==\n";
+    std::cout << "interval\tsorts\tsort_ms_per_step\ttotal_ms\n";
+    for (int interval : {0, 50, 10, 1}) {
+        Simulation sim;
+        sim.setGravity(Vector2(0, -10));
+        sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+        for (int i = 0; i < 64; i++)
+            sim.addBody(SoftBody::createFromPolygon(regularPolygon(60, Vector2(15.0 * (i % 8), 20 + 15.0 * (i / 8))), 5));
+        sim.setSortInterval(interval);
+        double ms = timeMs([&] {
+            for (int i = 0; i < 300; i++) sim.step(0.01);
+        }, 1);
+        std::cout << interval << "\t\t" << sim.getStats().sorts << "\t"
+                  << sim.getStats().amortizedSortMs() << "\t\t\t" << ms << "\n";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// World colliders: many obstacles, each body only near a few of them
+// ---------------------------------------------------------------------------
+static void benchWorldColliders() {
+    std::cout << "== 200 steps of 64 discs among 4 walls and 36 round obstacles ==\n";
+    Simulation sim;
+    sim.setGravity(Vector2(0, -10));
+    sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+    sim.addCollider(new PlaneCollider(Vector2(1, 0), -10.0));
+    sim.addCollider(new PlaneCollider(Vector2(-1, 0), -250.0));
+    sim.addCollider(new InnerCircleCollider(Vector2(120, 120), 400.0));
+    for (int i = 0; i < 36; i++)
+        sim.addCollider(new OuterCircleCollider(Vector2(20.0 + 40.0 * (i % 6), 30.0 + 40.0 * (i / 6)), 4.0));
+    for (int i = 0; i < 64; i++)
+        sim.addBody(SoftBody::createFromPolygon(regularPolygon(40, Vector2(10.0 + 30.0 * (i % 8), 20.0 + 30.0 * (i / 8))), 5));
+
+    double world_ms = 0.0;
+    unsigned long long pairs = 0, skipped = 0;
+    double ms = timeMs([&] {
+        for (int i = 0; i < 200; i++) {
+            sim.step(0.01);
+            world_ms += sim.getStats().phase_ms[WorldCollisionsPhase];
+            pairs += sim.getStats().world_pairs;
+            skipped += sim.getStats().world_pairs_skipped;
+        }
+    }, 1);
+    std::cout << "total_ms\tworld_ms\tbody_collider_pairs\tskipped\n";
+    std::cout << ms << "\t\t" << world_ms << "\t\t" << pairs << "\t\t\t" << skipped << "\n";
+}
+
+// ---------------------------------------------------------------------------
+// World colliders: virtual call per particle vs batch kernels, every collider in reach
+// ---------------------------------------------------------------------------
+static void benchWorldBatch() {
+    std::cout << "== 100 world passes of a 40000-particle body against 2 planes and 8 circles ==\n";
+    std::vector<Particle*> particles;
+    for (int i = 0; i < 40000; i++)
+        particles.push_back(new Particle(Vector2(-100 + (i % 200), -100 + (i / 200)), 1.0, 0.5));
+    std::vector<WorldCollider*> colliders = {
+        new PlaneCollider(Vector2(0, 1), -99.0), new PlaneCollider(Vector2(-1, 0), -99.0),
+        new InnerCircleCollider(Vector2(0, 0), 140.0),
+    };
+    for (int i = 0; i < 7; i++)
+        colliders.push_back(new OuterCircleCollider(Vector2(-90.0 + 30.0 * i, 0), 5.0));
+
+    double scalar = timeMs([&] {
+        for (int k = 0; k < 100; k++)
+            for (auto p : particles)
+                for (auto c : colliders) c->collide(p, 0.1, 0.9);
+    });
+    ParticleBatch batch;
+    double batched = timeMs([&] {
+        for (int k = 0; k < 100; k++) {
+            batch.gather(particles);
+            for (auto c : colliders) {
+                if (auto* plane = dynamic_cast<PlaneCollider*>(c)) plane->collideBatch(batch, 0.1, 0.9);
+                else if (auto* inner = dynamic_cast<InnerCircleCollider*>(c)) inner->collideBatch(batch, 0.1, 0.9);
+                else static_cast<OuterCircleCollider*>(c)->collideBatch(batch, 0.1, 0.9);
+            }
+        }
+    });
+    std::cout << "scalar_ms\tbatch_ms\n" << scalar << "\t\t" << batched << "\n";
+    for (auto p : particles) delete p;
+    for (auto c : colliders) delete c;
+}
+
+static void benchSDF() {
+    std::cout << "== 100 world passes of a 40000-particle body against 64 colliders, primitives vs baked SDF ==\n";
+    std::vector<Particle*> particles;
+    for (int i = 0; i < 40000; i++)
+        particles.push_back(new Particle(Vector2(-100 + (i % 200), -100 + (i / 200)), 1.0, 0.5));
+    std::vector<WorldCollider*> colliders = { new PlaneCollider(Vector2(0, 1), -99.0) };
+    for (int i = 0; i < 63; i++)
+        colliders.push_back(new OuterCircleCollider(Vector2(-90.0 + 25.0 * (i % 8), -90.0 + 25.0 * (i / 8)), 3.0));
+
+    std::vector<const WorldCollider*> sources(colliders.begin(), colliders.end());
+    SDFCollider* sdf = nullptr;
+    double bake_ms = timeMs([&] {
+        delete sdf;
+        sdf = SDFCollider::bake({ Vector2(-110, -110), Vector2(110, 110) }, 0.5, {}, sources);
+    }, 1);
+
+    std::vector<Vector2> start;
+    for (auto p : particles) start.push_back(p->getPosition());
+    auto reset = [&] {
+        for (size_t i = 0; i < particles.size(); i++) {
+            particles[i]->setPosition(start[i]);
+            particles[i]->setPrevPosition(start[i]);
+        }
+    };
+
+    double primitives = timeMs([&] {
+        reset();
+        for (int k = 0; k < 100; k++)
+            for (auto p : particles)
+                for (auto c : colliders) c->collide(p, 0.1, 0.9);
+    });
+    double baked = timeMs([&] {
+        reset();
+        for (int k = 0; k < 100; k++)
+            for (auto p : particles) sdf->collide(p, 0.1, 0.9);
+    });
+    std::cout << "bake_ms\tprimitives_ms\tsdf_ms\n" << bake_ms << "\t" << primitives << "\t\t" << baked << "\n";
+    for (auto p : particles) delete p;
+    for (auto c : colliders) delete c;
+    delete sdf;
+}
+
+static void benchSegments() {
+    std::cout << "== 100 world passes of 100 bodies of 400 particles against a 10000-segment terrain ==\n";
+    std::vector<Vector2> points;
+    for (int i = 0; i <= 10000; i++)
+        points.push_back(Vector2(i, std::sin(i * 0.3) * 2.0));
+    SegmentMeshCollider* terrain = nullptr;
+    double build_ms = timeMs([&] {
+        delete terrain;
+        terrain = new SegmentMeshCollider(SegmentMeshCollider::polyline(points));
+    }, 1);
+
+    std::vector<std::vector<Particle*>> bodies(100);
+    for (int b = 0; b < 100; b++)
+        for (int i = 0; i < 400; i++)
+            bodies[b].push_back(new Particle(Vector2(b * 100 + (i % 20) * 0.5, -3 + (i / 20) * 0.5), 1.0, 0.3));
+
+    double particle_ms = timeMs([&] {
+        for (int k = 0; k < 100; k++)
+            for (auto& body : bodies)
+                for (auto p : body) terrain->collide(p, 0.1, 0.9);
+    });
+    ParticleBatch batch;
+    double body_ms = timeMs([&] {
+        for (int k = 0; k < 100; k++)
+            for (auto& body : bodies) {
+                batch.gather(body);
+                terrain->collideBatch(batch, 0.1, 0.9);
+            }
+    });
+    std::cout << "build_ms\tper_particle_ms\tper_body_ms\n" << build_ms << "\t\t" << particle_ms << "\t\t" << body_ms << "\n";
+    for (auto& body : bodies)
+        for (auto p : body) delete p;
+    delete terrain;
+}
+
+static void benchContinuous() {
+    std::cout << "== 400 particles dropped on a thin floor and small posts for 2 s, substeps vs swept collisions ==\n";
+    auto run = [](double dt, bool continuous, int& tunnelled) {
+        Simulation sim;
+        sim.setGravity(Vector2(0, -400));
+        sim.setContinuousCollisions(continuous);
+        sim.addCollider(new SegmentMeshCollider({ { Vector2(-1000, 0), Vector2(1000, 0) } }));
+        for (int i = 0; i < 10; i++)
+            sim.addCollider(new OuterCircleCollider(Vector2(-90.0 + 20.0 * i, 10.0), 0.5));
+        for (int i = 0; i < 400; i++) {
+            std::vector<Particle*> particle{ new Particle(Vector2(-120 + i * 0.6, 40 + (i % 7) * 3.0), 1.0, 0.25) };
+            sim.addBody(new SoftBody(particle));
+        }
+        int steps = (int)std::round(2.0 / dt);
+        double ms = timeMs([&] { for (int k = 0; k < steps; k++) sim.step(dt); }, 1);
+        // Well below the floor, not just integrated past it at the end of the last step
+        tunnelled = 0;
+        for (auto b : sim.getBodies())
+            tunnelled += b->getParticles()[0]->getPosition().y < -20.0;
+        return ms;
+    };
+    std::cout << "dt\tswept\tsteps\tms\ttunnelled\n";
+    for (auto [dt, continuous] : std::vector<std::pair<double, bool>>{
+             {1.0 / 30, false}, {1.0 / 60, false}, {1.0 / 120, false}, {1.0 / 240, false}, {1.0 / 480, false},
+             {1.0 / 30, true}, {1.0 / 60, true}, {1.0 / 120, true}}) {
+        int tunnelled;
+        double ms = run(dt, continuous, tunnelled);
+        std::cout << "1/" << (int)std::round(1.0 / dt) << "\t" << continuous << "\t" << (int)std::round(2.0 / dt)
+                  << "\t" << ms << "\t" << tunnelled << "\n";
+    }
+}
+
+static void benchClearance() {
+    std::cout << "== bodies falling in an open level with 40 colliders and an SDF, 600 steps, clearance bounds ==\n";
+    std::cout << "bodies\tswept\tclearance\tms\tworld_ms\tskipped\n";
+    std::vector<Vector2> hills;
+    for (int i = 0; i <= 40; i++) hills.push_back(Vector2(-200.0 + 10.0 * i, 2.0 + 2.0 * std::sin(i * 0.7)));
+    OuterCircleCollider rock(Vector2(150, 0), 20.0);
+    std::unique_ptr<SDFCollider> sdf(SDFCollider::bake({ Vector2(120, -10), Vector2(190, 40) }, 1.0, {}, { &rock }));
+    json sdf_data = sdf->as_json();
+
+    auto run = [&](double size, int count, bool swept, bool clearance) {
+        Simulation sim;
+        sim.setGravity(Vector2(0, -10));
+        sim.setContinuousCollisions(swept);
+        sim.setWorldClearance(clearance);
+        sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+        sim.addCollider(new PlaneCollider(Vector2(1, 0), -200.0));
+        sim.addCollider(new PlaneCollider(Vector2(-1, 0), -200.0));
+        for (int i = 0; i < 30; i++)
+            sim.addCollider(new OuterCircleCollider(Vector2(-180.0 + 12.0 * i, 5.0 + (i % 3) * 20.0), 3.0));
+        sim.addCollider(new SegmentMeshCollider(SegmentMeshCollider::polyline(hills)));
+        for (int i = 0; i < 6; i++)
+            sim.addCollider(new InnerCircleCollider(Vector2(0, 150), 400.0 + i));
+        sim.addCollider(WorldCollider::from_json(sdf_data));
+        // Rows of bodies spread over the level
+        double spacing = 380.0 / std::min(count, 20);
+        for (int k = 0; k < count; k++) {
+            Vector2 o(-190.0 + (k % 20) * spacing, 30.0 + (k / 20) * 40.0);
+            sim.addBody(SoftBody::createFromPolygon({ o, o + Vector2(size, 0), o + Vector2(size, size), o + Vector2(0, size) },
+                                                    2, 1.0, 0.6, 0.8, 0.1, 0.5, 0.2));
+        }
+        double world_ms = 0.0;
+        unsigned long long skipped = 0, particles = 0;
+        double ms = timeMs([&] {
+            for (int s = 0; s < 600; s++) {
+                sim.step(1.0 / 60);
+                world_ms += sim.getStats().phase_ms[WorldCollisionsPhase];
+                skipped += sim.getStats().world_particles_skipped;
+            }
+        }, 1);
+        for (auto b : sim.getBodies()) particles += b->getParticles().size();
+        std::cout << count << "\t" << swept << "\t" << clearance << "\t\t" << ms << "\t" << world_ms << "\t\t"
+                  << 100.0 * skipped / (2.0 * 600 * particles) << "%\n";
+    };
+    // Many small bodies, then a few large ones whose bounds overlap the colliders
+    for (auto [size, count] : std::vector<std::pair<double, int>>{ {6.0, 120}, {60.0, 4} })
+        for (bool swept : { false, true })
+            for (bool clearance : { false, true }) run(size, count, swept, clearance);
+}
+
+static void benchSurface() {
+    std::cout << "== 6 dense bodies stacked in a box, 100 steps, all particles vs surface collisions ==\n";
+    std::cout << "surface\tparticles\tcolliding\tfallbacks\tms\tworld_ms\tbodies_ms\n";
+    for (bool surface : { false, true }) {
+        Simulation sim;
+        sim.setGravity(Vector2(0, -10));
+        sim.setSurfaceCollisions(surface);
+        sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+        sim.addCollider(new PlaneCollider(Vector2(1, 0), -0.7));
+        sim.addCollider(new PlaneCollider(Vector2(-1, 0), -30.7));
+        for (int k = 0; k < 6; k++) {
+            Vector2 o(0, 1 + k * 32);
+            sim.addBody(SoftBody::createFromPolygon({ o, o + Vector2(30, 0), o + Vector2(30, 30), o + Vector2(0, 30) },
+                                                    1, 1.0, 0.5, 0.8, 0.1, 0.5, 0.2, false, LatticeMesh));
+        }
+        // The soft lattices fold under the weight of the stack later on
+        double world_ms = 0.0, bodies_ms = 0.0;
+        unsigned long long fallbacks = 0;
+        double ms = timeMs([&] {
+            for (int s = 0; s < 100; s++) {
+                sim.step(1.0 / 60);
+                fallbacks += sim.getStats().surface_fallbacks;
+                world_ms += sim.getStats().phase_ms[WorldCollisionsPhase];
+                bodies_ms += sim.getStats().phase_ms[BodyCollisionsPhase];
+            }
+        }, 1);
+        size_t particles = 0;
+        for (auto body : sim.getBodies()) particles += body->getParticles().size();
+        std::cout << surface << "\t" << particles << "\t\t" << sim.getStats().collision_particles << "\t\t" << fallbacks << "\t\t"
+                  << ms << "\t" << world_ms << "\t\t" << bodies_ms << "\n";
+    }
+}
+
+static void benchEdges() {
+    std::cout << "== stack of 6 bodies in a box, 2000 steps, outline sampling and edge contacts ==\n";
+    std::cout << "mode\t\t\tparticles\tms\tbodies_ms\tpenetration\n";
+    for (int mode = 0; mode < 3; mode++) {
+        Simulation sim;
+        sim.setGravity(Vector2(0, -10));
+        sim.setEdgeContacts(mode == 2);
+        sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+        sim.addCollider(new PlaneCollider(Vector2(1, 0), -0.7));
+        sim.addCollider(new PlaneCollider(Vector2(-1, 0), -12.2));
+        for (int k = 0; k < 6; k++) {
+            // Every other body shifted, outline particles do not line up
+            Vector2 o((k % 2) * 1.5, 1 + k * 12);
+            std::vector<Vector2> square = { o, o + Vector2(10, 0), o + Vector2(10, 10), o + Vector2(0, 10) };
+            // Outline sampled every particle radius, or only every mesh unit
+            MeshData mesh = meshPolygon(square, 3, mode == 0 ? 0.6 : 3.0);
+            sim.addBody(SoftBody::createFromMesh(mesh, 3, 1.0, 0.6, 0.8, 0.1, 0.5, 0.2));
+        }
+        double bodies_ms = 0.0;
+        double ms = timeMs([&] {
+            for (int s = 0; s < 2000; s++) {
+                sim.step(1.0 / 60);
+                bodies_ms += sim.getStats().phase_ms[BodyCollisionsPhase];
+            }
+        }, 1);
+
+        size_t particles = 0;
+        double penetration = 0.0;
+        auto bodies = sim.getBodies();
+        for (auto b : bodies) particles += b->getParticles().size();
+        for (size_t k = 1; k < bodies.size(); k++)
+            penetration += computeAABB(bodies[k - 1]->getParticles()).max.y - computeAABB(bodies[k]->getParticles()).min.y;
+        const char* names[] = { "dense particles\t", "coarse particles\t", "coarse edges\t\t" };
+        std::cout << names[mode] << particles << "\t\t" << ms << "\t" << bodies_ms << "\t\t"
+                  << penetration / (bodies.size() - 1) << "\n";
+    }
+}
+
+static void benchSpheres() {
+    std::cout << "== 16 nested L-shaped bodies in a box, 600 steps, body boxes vs sphere trees ==\n";
+    std::cout << "mode\t\tspheres\tms\tbodies_ms\trefit_ms\tleaf_pairs\n";
+    auto run = [](bool pipeline, bool spheres) {
+        Simulation sim;
+        sim.setGravity(Vector2(0, -10));
+        sim.setContactPipeline(pipeline);
+        sim.setSphereTrees(spheres);
+        sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+        sim.addCollider(new PlaneCollider(Vector2(1, 0), -0.7));
+        sim.addCollider(new PlaneCollider(Vector2(-1, 0), -80.7));
+        // Each L sits in the corner of the previous one: their boxes overlap, their arms barely touch
+        for (int k = 0; k < 16; k++) {
+            Vector2 o((k % 4) * 20.0 + (k / 4) * 1.6, 1 + (k / 4) * 1.6);
+            sim.addBody(SoftBody::createFromPolygon({ o, o + Vector2(18, 0), o + Vector2(18, 1.2), o + Vector2(1.2, 1.2),
+                                                      o + Vector2(1.2, 18), o + Vector2(0, 18) },
+                                                    1, 1.0, 0.3, 0.8, 0.1, 0.5, 0.2, false, LatticeMesh));
+        }
+        double bodies_ms = 0.0, refit_ms = 0.0;
+        unsigned long long leaf_pairs = 0;
+        double ms = timeMs([&] {
+            for (int s = 0; s < 600; s++) {
+                sim.step(1.0 / 60);
+                bodies_ms += sim.getStats().phase_ms[BodyCollisionsPhase];
+                refit_ms += sim.getStats().sphere_refit_ms;
+                leaf_pairs += sim.getStats().sphere_leaf_pairs;
+            }
+        }, 1);
+        std::cout << (pipeline ? "pipeline\t" : "interleaved\t") << spheres << "\t" << ms << "\t" << bodies_ms
+                  << "\t\t" << refit_ms << "\t\t" << leaf_pairs / 600 << "\n";
+    };
+    for (bool pipeline : { false, true })
+        for (bool spheres : { false, true }) run(pipeline, spheres);
+}
+
+static void benchLayers() {
+    std::cout << "== 40 bodies in a box, half of them debris, 600 steps, collision layers ==\n";
+    std::cout << "debris\t\tms\tbodies_ms\tmasked_pairs\n";
+    for (bool masked : { false, true }) {
+        Simulation sim;
+        sim.setGravity(Vector2(0, -10));
+        sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+        sim.addCollider(new PlaneCollider(Vector2(1, 0), -0.7));
+        sim.addCollider(new PlaneCollider(Vector2(-1, 0), -80.7));
+        for (int k = 0; k < 40; k++) {
+            Vector2 o((k % 8) * 10.0, 1 + (k / 8) * 11.0);
+            SoftBody* body = SoftBody::createFromPolygon({ o, o + Vector2(8, 0), o + Vector2(8, 8), o + Vector2(0, 8) },
+                                                         2, 1.0, 0.6, 0.8, 0.1, 0.5, 0.2);
+            // Debris on its own layer only meets the colliders
+            if (masked && k % 2) {
+                body->setCollisionLayer(2);
+                body->setCollisionMask(0);
+            }
+            sim.addBody(body);
+        }
+        double bodies_ms = 0.0;
+        double ms = timeMs([&] {
+            for (int s = 0; s < 600; s++) {
+                sim.step(1.0 / 60);
+                bodies_ms += sim.getStats().phase_ms[BodyCollisionsPhase];
+            }
+        }, 1);
+        std::cout << (masked ? "masked\t\t" : "colliding\t") << ms << "\t" << bodies_ms << "\t\t"
+                  << sim.getStats().masked_pairs << "\n";
+    }
+}
+
+static void benchContacts() {
+    std::cout << "== stack of 6 bodies in a box, 2000 steps, contact cache and warm starting ==\n";
+    std::cout << "mode\t\tms\tpenetration\tspeed\n";
+    for (int mode = 0; mode < 3; mode++) {
+        Simulation sim;
+        sim.setGravity(Vector2(0, -10));
+        sim.setContactCache(mode > 0);
+        sim.setWarmStart(mode == 2 ? 0.5 : 0.0);
+        sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+        sim.addCollider(new PlaneCollider(Vector2(1, 0), -0.7));
+        sim.addCollider(new PlaneCollider(Vector2(-1, 0), -10.7));
+        for (int k = 0; k < 6; k++) {
+            Vector2 o(0, 1 + k * 12);
+            sim.addBody(SoftBody::createFromPolygon({ o, o + Vector2(10, 0), o + Vector2(10, 10), o + Vector2(0, 10) },
+                                                    2, 1.0, 0.6, 0.8, 0.1, 0.5, 0.2));
+        }
+        double ms = timeMs([&] { for (int s = 0; s < 2000; s++) sim.step(1.0 / 60); }, 1);
+
+        // Sinking of each body in the one below, and mean residual speed
+        double penetration = 0.0, speed = 0.0;
+        int n = 0;
+        auto bodies = sim.getBodies();
+        for (size_t k = 1; k < bodies.size(); k++)
+            penetration += computeAABB(bodies[k - 1]->getParticles()).max.y - computeAABB(bodies[k]->getParticles()).min.y;
+        for (auto b : bodies)
+            for (auto p : b->getParticles()) {
+                speed += (p->getPosition() - p->getPrevPosition()).length() * 60;
+                n++;
+            }
+        const char* names[] = { "narrowphase\t", "cache\t\t", "cache+warm\t" };
+        std::cout << names[mode] << ms << "\t" << penetration / (bodies.size() - 1)
+                  << "\t\t" << speed / n << "\n";
+    }
+}
+
+static void benchPipeline() {
+    std::cout << "== 40 bodies in a box, 600 steps, interleaved vs pipelined body contacts ==\n";
+    std::cout << "mode\t\tthreads\tms\tcontacts\tcolors\tdetect_ms\tcolor_ms\tresolve_ms\n";
+    auto run = [](bool pipeline, int threads) {
+        Simulation sim;
+        sim.setGravity(Vector2(0, -10));
+        sim.setContactPipeline(pipeline);
+        sim.setThreadCount(threads);
+        sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+        sim.addCollider(new PlaneCollider(Vector2(1, 0), -0.7));
+        sim.addCollider(new PlaneCollider(Vector2(-1, 0), -80.7));
+        for (int k = 0; k < 40; k++) {
+            Vector2 o((k % 8) * 10.0, 1 + (k / 8) * 11.0);
+            sim.addBody(SoftBody::createFromPolygon({ o, o + Vector2(8, 0), o + Vector2(8, 8), o + Vector2(0, 8) },
+                                                    2, 1.0, 0.6, 0.8, 0.1, 0.5, 0.2));
+        }
+        double detect = 0, color = 0, resolve = 0;
+        double ms = timeMs([&] {
+            for (int s = 0; s < 600; s++) {
+                sim.step(1.0 / 60);
+                detect += sim.getStats().contact_detect_ms;
+                color += sim.getStats().contact_color_ms;
+                resolve += sim.getStats().contact_resolve_ms;
+            }
+        }, 1);
+        std::cout << (pipeline ? "pipeline\t" : "interleaved\t") << threads << "\t" << ms << "\t"
+                  << sim.getStats().contacts << "\t\t" << sim.getStats().contact_colors << "\t"
+                  << detect << "\t\t" << color << "\t\t" << resolve << "\n";
+    };
+    run(false, 1);
+    for (int threads : { 1, 2, 4 }) run(true, threads);
+}
+
+static void benchWorker() {
+    std::cout << "== 40 bodies in a box, 300 frames with 4 ms of rendering, main thread cost per frame ==\n";
+    std::cout << "mode\t\tframe_ms\tmax_ms\tsteps\tmean_lag\tdropped\n";
+    auto run = [](bool threaded) {
+        Simulation sim;
+        sim.setGravity(Vector2(0, -10));
+        sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+        sim.addCollider(new PlaneCollider(Vector2(1, 0), -0.7));
+        sim.addCollider(new PlaneCollider(Vector2(-1, 0), -80.7));
+        for (int k = 0; k < 40; k++) {
+            Vector2 o((k % 8) * 10.0, 1 + (k / 8) * 11.0);
+            sim.addBody(SoftBody::createFromPolygon({ o, o + Vector2(8, 0), o + Vector2(8, 8), o + Vector2(0, 8) },
+                                                    2, 1.0, 0.6, 0.8, 0.1, 0.5, 0.2));
+        }
+        std::unique_ptr<SimulationWorker> worker;
+        if (threaded) worker = std::make_unique<SimulationWorker>(sim);
+        double total = 0, worst = 0, lag = 0;
+        size_t border = 0;
+        for (int f = 0; f < 300; f++) {
+            // Main thread work of a frame: step or request, then read the borders
+            double ms = timeMs([&] {
+                if (worker) {
+                    worker->request(1.0 / 60);
+                    border += worker->latest().borders.size();
+                } else {
+                    sim.step(1.0 / 60);
+                    for (auto b : sim.getBodies()) border += b->getBorder().size();
+                }
+            }, 1);
+            total += ms;
+            worst = std::max(worst, ms);
+            if (worker) lag += worker->getLag();
+            std::this_thread::sleep_for(std::chrono::milliseconds(4));
+        }
+        if (worker) worker->wait();
+        std::cout << (threaded ? "worker\t\t" : "main thread\t") << total / 300 << "\t\t" << worst << "\t"
+                  << sim.getStats().steps << "\t" << lag / 300 << "\t\t" << (worker ? worker->getDropped() : 0) << "\n";
+    };
+    run(false);
+    run(true);
+}
+
+int main(int argc, char** argv) {
+    // Run every benchmark, or only the ones named on the command line
+    std::vector<std::pair<std::string, std::function<void()>>> benches = {
+        {"mesh", benchMeshing},
+        {"mesh_sim", benchMeshSimulation},
+        {"mesh_cache", benchMeshCache},
+        {"instancing", benchInstancing},
+        {"reorder", benchReorder},
+        {"sort", benchSort},
+        {"world", benchWorldColliders},
+        {"world_batch", benchWorldBatch},
+        {"sdf", benchSDF},
+        {"segments", benchSegments},
+        {"continuous", benchContinuous},
+        {"clearance", benchClearance},
+        {"surface", benchSurface},
+        {"edges", benchEdges},
+        {"spheres", benchSpheres},
+        {"layers", benchLayers},
+        {"contacts", benchContacts},
+        {"pipeline", benchPipeline},
+        {"worker", benchWorker},
+    };
+    for (auto& [name, fn] : benches) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; i++) selected |= name == argv[i];
+        if (selected) fn();
+    }
+    return 0;
+}
@@ -10,6 +10,8 @@
 #include "GDConstraint.h"
 
 namespace godot {
+    class GDSimulation_2;
+
     /**
      * @brief A Node2D representing a collider in the soft body simulation
      * 
@@ -23,6 +25,8 @@ namespace godot {
     protected:
         // Internal simulation object (allocated on build)
         sim::WorldCollider* world_collider = nullptr;   /// Pointer to the simulation collider
+        sim::WorldCollider* sim_collider = nullptr;     /// Collider handed to the simulation, not owned
+        GDSimulation_2* owner = nullptr;                /// Simulation node running sim_collider
 
         /// @brief Types of colliders supported
         enum COLLIDER_TYPE{
@@ -38,6 +42,7 @@ namespace godot {
 
         double friction = 0.5;      /// Friction coefficient [smooth 0 < 1 rough]
         double restitution = 0.5;   /// Restitution (bounciness) coefficient [sticky 0 < 1 reflect]
+        uint32_t collision_mask = 0xFFFFFFFF;  /// Layers of the bodies the collider acts on
         
         static void _bind_methods();
 
@@ -84,12 +89,18 @@ namespace godot {
         void set_restitution(double r) { restitution = r; }
         double get_restitution() const { return restitution; }
 
+        /// Also applied to the running simulation, between two steps
+        void set_collision_mask(const uint32_t m);
+        uint32_t get_collision_mask() const { return collision_mask; }
+
         // Access to the sim object
         sim::WorldCollider* get_sim_collider() const { return world_collider; }
-        sim::WorldCollider* take_sim_collider() {
-            sim::WorldCollider* wc = world_collider;
+        /// Hand the collider over to the simulation run by a GDSimulation_2
+        sim::WorldCollider* take_sim_collider(GDSimulation_2* simulation) {
+            sim_collider = world_collider;
+            owner = simulation;
             world_collider = nullptr;
-            return wc;
+            return sim_collider;
         }
     };
 }
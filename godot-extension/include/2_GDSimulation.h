@@ -2,14 +2,17 @@
 #pragma once
 #include <godot_cpp/classes/engine.hpp>
 #include <godot_cpp/classes/node2d.hpp>
+#include <godot_cpp/variant/string_name.hpp>
 #include <godot_cpp/core/binder_common.hpp>
 
+#include <memory>
 #include <vector>
-#include <map>
 
 #include "2_GDSoftBody.h"
 #include "2_GDCollider.h"
+#include "GDDebugDraw.h"
 #include "Simulation.h"
+#include "SimulationWorker.h"
 #include "SoftBody.h"
 
 namespace godot {
@@ -24,15 +27,43 @@ namespace godot {
     
     private:
         sim::Simulation simulation;                     /// Internal simulation object
-        std::map<sim::SoftBody*,GDSoftBody_2*> bodies;  /// Mapping of simulation bodies to Godot nodes
+        std::vector<GDSoftBody_2*> bodies;              /// Godot node of each simulation body, by body index
         std::vector<GDCollider*> colliders;              /// List of colliders in the simulation
+        DebugDraw debug_draw;                           /// Batched constraint and particle drawing
 
         // Editor-facing parameters
         Vector2 gravity = Vector2(0,10);               /// Gravity vector
         bool _verbose = false;                         /// Verbose debug drawing
+        bool mesh_cache = true;                        /// Reuse meshes of unchanged polygons across resets
+        String mesh_cache_dir = "";                    /// On-disk mesh cache directory, empty for memory only
+        int sort_interval = 0;                         /// Steps between two particle storage sorts, 0 disables them
+        bool continuous_collisions = false;            /// Sweep particles against the colliders, for large time steps
+        bool world_clearance = false;                  /// Skip the world tests of particles far from the colliders
+        bool surface_collisions = true;                /// Only collide the outline particles of the bodies
+        bool sphere_trees = false;                     /// Cull particle pairs with a sphere hierarchy per body
+        bool edge_contacts = false;                    /// Collide particles against the outline edges of other bodies
+        bool contact_cache = false;                    /// Keep contacts between bodies across steps
+        bool contact_pipeline = false;                 /// Detect, color then resolve body contacts
+        int threads = 1;                               /// Threads of the contact pipeline
+        bool background_thread = false;                /// Step the simulation on a worker thread
+        int max_lag = 2;                               /// Steps the worker may fall behind before requests are dropped
+
+        std::unique_ptr<sim::SimulationWorker> worker; /// Background stepping, when enabled
+        std::vector<StringName> monitors;              /// Custom Performance monitors registered by the node
 
         // Helper
         void step_simulation(double delta) { simulation.step(delta); }
+        /**
+         * @brief Draw a snapshot published by the worker thread
+         */
+        void draw_snapshot(const sim::SimulationSnapshot& snapshot);
+        /**
+         * @brief Register the step statistics as custom monitors of the Godot debugger
+         *
+         * Monitors are listed under "softbody_<node name>" in the Monitors tab.
+         */
+        void add_monitors();
+        void remove_monitors();
         /**
          * @brief Draw the simulation state for debugging purposes
          * This function visualizes the soft bodies and their particles
@@ -52,7 +83,16 @@ namespace godot {
 
     public:
         GDSimulation_2() {}
-        ~GDSimulation_2() { simulation.clear(); }
+        ~GDSimulation_2() {
+            worker.reset();
+            simulation.clear();
+        }
+
+        /// The simulation, once the worker finished its queued steps
+        sim::Simulation& edit() {
+            if (worker) worker->wait();
+            return simulation;
+        }
 
         // core function
         /** 
@@ -69,6 +109,51 @@ namespace godot {
         void set_debug(const bool d) { _verbose = d; }
         bool get_debug() const { return _verbose; }
 
+        void set_mesh_cache(const bool c) { mesh_cache = c; }
+        bool get_mesh_cache() const { return mesh_cache; }
+
+        void set_mesh_cache_dir(const String& d) { mesh_cache_dir = d; }
+        String get_mesh_cache_dir() const { return mesh_cache_dir; }
+
+        void set_sort_interval(const int n) { sort_interval = n; edit().setSortInterval(n); }
+        int get_sort_interval() const { return sort_interval; }
+
+        void set_continuous_collisions(const bool e) { continuous_collisions = e; edit().setContinuousCollisions(e); }
+        bool get_continuous_collisions() const { return continuous_collisions; }
+
+        void set_world_clearance(const bool e) { world_clearance = e; edit().setWorldClearance(e); }
+        bool get_world_clearance() const { return world_clearance; }
+
+        void set_surface_collisions(const bool e) { surface_collisions = e; edit().setSurfaceCollisions(e); }
+        bool get_surface_collisions() const { return surface_collisions; }
+
+        void set_sphere_trees(const bool e) { sphere_trees = e; edit().setSphereTrees(e); }
+        bool get_sphere_trees() const { return sphere_trees; }
+
+        void set_edge_contacts(const bool e) { edge_contacts = e; edit().setEdgeContacts(e); }
+        bool get_edge_contacts() const { return edge_contacts; }
+
+        void set_contact_cache(const bool e) { contact_cache = e; edit().setContactCache(e); }
+        bool get_contact_cache() const { return contact_cache; }
+
+        void set_contact_pipeline(const bool e) { contact_pipeline = e; edit().setContactPipeline(e); }
+        bool get_contact_pipeline() const { return contact_pipeline; }
+
+        void set_threads(const int n) { threads = n; edit().setThreadCount(n); }
+        int get_threads() const { return threads; }
+
+        void set_background_thread(const bool e);
+        bool get_background_thread() const { return background_thread; }
+        void set_max_lag(const int n) { max_lag = n; if (worker) worker->setMaxLag(n); }
+        int get_max_lag() const { return max_lag; }
+
+        /// Steps queued on the worker thread, 0 without it
+        int get_simulation_lag() const { return worker ? (int)worker->getLag() : 0; }
+        /// Step requests dropped by the worker thread since the last reset
+        int get_dropped_steps() const { return worker ? (int)worker->getDropped() : 0; }
+        /// Value of a custom monitor, called by the Performance singleton
+        double get_monitor(int id);
+
         // Godot function
         void _ready() override {
             if (Engine::get_singleton()->is_editor_hint()) {
@@ -76,6 +161,11 @@ namespace godot {
                 return;
             }
             build();
+            add_monitors();
+        }
+
+        void _exit_tree() override {
+            remove_monitors();
         }
 
         void _process(double delta) override {
@@ -84,7 +174,8 @@ namespace godot {
                 queue_redraw();
                 return;
             }
-            step_simulation(delta);
+            if (worker) worker->request(delta);
+            else step_simulation(delta);
             queue_redraw();
         }
 
@@ -10,6 +10,8 @@
 #include "GDConstraint.h"
 
 namespace godot {
+    class GDSimulation_2;
+
     /**
      * @brief A Polygon2D representing a soft body in the simulation
      * 
@@ -23,10 +25,17 @@ namespace godot {
     protected:
         // Internal simulation object (allocated on build)
         sim::SoftBody* soft_body = nullptr; /// Pointer to the simulation soft body
+        sim::SoftBody* sim_body = nullptr;  /// Body handed to the simulation, not owned
+        GDSimulation_2* owner = nullptr;    /// Simulation node running sim_body
 
         // Backup save for reset
         PackedVector2Array backed_ploygon;  /// Backup of the original polygon points
 
+        // Border sync
+        PackedVector2Array polygon_buffers[2];  /// Polygons written on alternate frames
+        int current_polygon = 0;                /// Buffer last handed to set_polygon()
+        Vector2* next_polygon(int64_t count);   /// Switch buffers and size the new one
+
         // Editor-facing parameters
         int unit = 5;                       /// Distance between particles in the mesh
         double mass = 1.0;                  /// Mass of each particle
@@ -35,6 +44,10 @@ namespace godot {
         double restitution = 0.5;           /// Restitution (bounciness) coefficient [sticky 0 < 1 reflect]
         double stiffness = 0.8;             /// Stiffness of the constraints [flexible 0 < 1 rigid]
         double damping = 0.1;               /// Damping factor of the constraints [oscilling 0 < 1 freezing]
+        int mesh_type = sim::RingMesh;      /// Interior meshing strategy (sim::MESH_TYPE)
+        bool reorder = false;               /// Renumber particles and constraints for memory locality
+        uint32_t collision_layer = 1;       /// Layers the body is in
+        uint32_t collision_mask = 1;        /// Layers of the bodies it collides with
 
         static void _bind_methods();
 
@@ -55,9 +68,18 @@ namespace godot {
          * @brief Update the polygon2D shape based on new border particles
          * 
          * This function modifies the polygon points to match the positions
-         * of the simulation current border particles.
+         * of the simulation current border particles. The points are written
+         * in place into one of two persistent buffers, so that the buffer still
+         * referenced by the node is never copied.
+         */
+        void update(const std::vector<sim::Particle*>& new_border);
+
+        /**
+         * @brief Update the polygon2D shape from border positions copied out of the simulation
+         * @param points Border positions, in simulation coordinates
+         * @param count Number of positions
          */
-        void update(std::vector<sim::Particle*> new_border);
+        void update(const sim::Vector2* points, size_t count);
 
         /** 
          * @brief Reset the soft body to its initial state
@@ -86,12 +108,25 @@ namespace godot {
         void set_damping(const double d) { damping = d; }
         double get_damping() const { return damping; }
 
+        void set_mesh_type(const int t) { mesh_type = t; }
+        int get_mesh_type() const { return mesh_type; }
+        void set_reorder(const bool r) { reorder = r; }
+        bool get_reorder() const { return reorder; }
+
+        /// Also applied to the running simulation, between two steps
+        void set_collision_layer(const uint32_t l);
+        uint32_t get_collision_layer() const { return collision_layer; }
+        void set_collision_mask(const uint32_t m);
+        uint32_t get_collision_mask() const { return collision_mask; }
+
         // Access to the sim object
         sim::SoftBody* get_sim_softbody() const { return soft_body; }
-        sim::SoftBody* take_sim_softbody() {
-            sim::SoftBody* sb = soft_body;
+        /// Hand the body over to the simulation run by a GDSimulation_2
+        sim::SoftBody* take_sim_softbody(GDSimulation_2* simulation) {
+            sim_body = soft_body;
+            owner = simulation;
             soft_body = nullptr;
-            return sb;
+            return sim_body;
         }
     };
 }
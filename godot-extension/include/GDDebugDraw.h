@@ -0,0 +1,70 @@
+//GDDebugDraw.h
+#pragma once
+#include <godot_cpp/classes/canvas_item.hpp>
+#include <godot_cpp/variant/color.hpp>
+#include <godot_cpp/variant/packed_float32_array.hpp>
+#include <godot_cpp/variant/packed_vector2_array.hpp>
+#include <godot_cpp/variant/rid.hpp>
+
+namespace godot {
+    /**
+     * @brief Batched debug drawing of lines and circles
+     *
+     * All the lines of a frame go to a single draw_multiline() call and all
+     * the circles are instances of a single MultiMesh, so the number of canvas
+     * commands does not grow with the number of constraints or particles.
+     * begin() sizes the buffers, which are then written in place and reused
+     * from one frame to the next.
+     */
+    class DebugDraw {
+    public:
+        DebugDraw() {}
+        ~DebugDraw();
+        DebugDraw(const DebugDraw&) = delete;
+        DebugDraw& operator=(const DebugDraw&) = delete;
+
+        /**
+         * @brief Start a frame
+         * @param line_count Number of lines that will be set
+         * @param circle_count Number of circles that will be set
+         */
+        void begin(int64_t line_count, int64_t circle_count);
+
+        /// Set the line i, with i below the line count given to begin()
+        void setLine(int64_t i, const Vector2 &a, const Vector2 &b) {
+            lines_ptr[2 * i] = a;
+            lines_ptr[2 * i + 1] = b;
+        }
+
+        /// Set the circle i, with i below the circle count given to begin()
+        void setCircle(int64_t i, const Vector2 &center, real_t radius, const Color &color) {
+            // 2D instance layout: a 2x4 row-major transform followed by the color
+            float *f = instances_ptr + i * FLOATS_PER_INSTANCE;
+            f[0] = radius; f[1] = 0.0f;   f[2] = 0.0f; f[3] = center.x;
+            f[4] = 0.0f;   f[5] = radius; f[6] = 0.0f; f[7] = center.y;
+            f[8] = color.r; f[9] = color.g; f[10] = color.b; f[11] = color.a;
+        }
+
+        /**
+         * @brief Submit the frame, must be called from the _draw() of the item
+         * @param item Canvas item to draw into
+         * @param line_color Color of every line
+         * @param line_width Width of the lines, -1 for thin primitive lines
+         */
+        void draw(CanvasItem *item, const Color &line_color, real_t line_width);
+
+    private:
+        static constexpr int FLOATS_PER_INSTANCE = 12;
+
+        void create_mesh();
+
+        PackedVector2Array lines;           /// Line end points, two per line
+        PackedFloat32Array instances;       /// MultiMesh buffer, one transform and color per circle
+        Vector2 *lines_ptr = nullptr;       /// Write pointers, valid from begin() to draw()
+        float *instances_ptr = nullptr;
+        int64_t circle_count = 0;
+        int64_t allocated = -1;             /// Instance count of the MultiMesh data
+        RID mesh;                           /// Unit disc
+        RID multimesh;
+    };
+}
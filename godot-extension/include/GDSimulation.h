@@ -10,6 +10,7 @@
 #include "Simulation.h"
 #include "SoftBody.h"
 
+#include "GDDebugDraw.h"
 #include "GDSoftBody.h"
 
 namespace godot {
@@ -30,6 +31,7 @@ namespace godot {
     private:
         void step_simulation(double delta) { simulation.step(delta); }
         void draw_simulation();
+        DebugDraw debug_draw;       /// Batched constraint and particle drawing
 
     protected:
         sim::Simulation simulation; /// Internal simulation object
@@ -1,4 +1,5 @@
 #include "2_GDCollider.h"
+#include "2_GDSimulation.h"
 
 using namespace godot;
 
@@ -14,6 +15,8 @@ void GDCollider::_bind_methods() {
     ClassDB::bind_method(D_METHOD("get_friction"), &GDCollider::get_friction);
     ClassDB::bind_method(D_METHOD("set_restitution", "restitution"), &GDCollider::set_restitution);
     ClassDB::bind_method(D_METHOD("get_restitution"), &GDCollider::get_restitution);
+    ClassDB::bind_method(D_METHOD("set_collision_mask", "mask"), &GDCollider::set_collision_mask);
+    ClassDB::bind_method(D_METHOD("get_collision_mask"), &GDCollider::get_collision_mask);
 
     ADD_PROPERTY(PropertyInfo(Variant::VECTOR2, "center"), "set_point", "get_point");
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "distance"), "set_distance", "get_distance");
@@ -25,6 +28,7 @@ void GDCollider::_bind_methods() {
 
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "friction"), "set_friction", "get_friction");
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "restitution"), "set_restitution", "get_restitution");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "collision_mask", PROPERTY_HINT_LAYERS_2D_PHYSICS), "set_collision_mask", "get_collision_mask");
 }
 
 GDCollider::~GDCollider() {
@@ -48,9 +52,23 @@ void GDCollider::build() {
         world_collider = new sim::PlaneCollider( convert::from_godot(point), distance, friction, restitution);
         break;
     }
+    world_collider->setCollisionMask(collision_mask);
+}
+
+void GDCollider::set_collision_mask(const uint32_t m) {
+    collision_mask = m;
+    if (world_collider) world_collider->setCollisionMask(m);
+    if (sim_collider) {
+        // Waits for the steps queued on the worker thread
+        owner->edit();
+        sim_collider->setCollisionMask(m);
+    }
 }
 
 void GDCollider::reset() {
+    // The simulation deletes the collider it was handed
+    sim_collider = nullptr;
+    owner = nullptr;
     if (world_collider) {
         delete world_collider;
         world_collider = nullptr;
@@ -4,31 +4,152 @@
 #include "2_GDCollider.h"
 #include "GDVector2.h"
 
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/performance.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
+
 #include <PlaneWorldCollider.h>
 #include <CircleWorldCollider.h>
+#include <MeshCache.h>
 
 using namespace godot;
 
+// Custom monitors, after the per-phase step times
+enum MONITOR {
+    MONITOR_STEP = sim::PHASE_COUNT,
+    MONITOR_BODIES,
+    MONITOR_PARTICLES,
+    MONITOR_CONSTRAINTS,
+    MONITOR_BODY_CONTACTS,
+    MONITOR_RESTING_BODIES,
+    MONITOR_WORKER_UTILIZATION,
+    MONITOR_WORKER_LAG,
+    MONITOR_COUNT
+};
+
+static String monitor_name(int id) {
+    switch (id) {
+    case MONITOR_STEP:               return "step_ms";
+    case MONITOR_BODIES:             return "bodies";
+    case MONITOR_PARTICLES:          return "particles";
+    case MONITOR_CONSTRAINTS:        return "constraints";
+    case MONITOR_BODY_CONTACTS:      return "body_contacts";
+    case MONITOR_RESTING_BODIES:     return "resting_bodies";
+    case MONITOR_WORKER_UTILIZATION: return "worker_utilization_percent";
+    case MONITOR_WORKER_LAG:         return "worker_lag_steps";
+    default:                         return String(sim::phaseName((sim::STEP_PHASE)id)) + "_ms";
+    }
+}
+
 void GDSimulation_2::draw_simulation() {
-    for (auto body : simulation.getBodies()) {
-        bodies[body]->update(body->getBorder());
-        if (_verbose){
-            for (auto c: body->getConstraints()) {
-                Vector2 p1 = convert::to_godot(c->getPart1());
-                Vector2 p2 = convert::to_godot(c->getPart2());
-                draw_line(p1,p2,Color(1,1,1), 1.0);
-            }
-            for (auto p : body->getParticles()) {
-                Vector2 pos = convert::to_godot(p->getPosition()) ;
-                float radius = p->getRadius();
-                draw_circle(pos, radius, Color(1,0,0));
-            }
-            for (auto p : body->getBorder()) {
-                Vector2 pos = convert::to_godot(p->getPosition()) ;
-                float radius = p->getRadius();
-                draw_circle(pos, radius, Color(0,1,0));
-            }
+    if (worker) {
+        worker->setDetail(_verbose);
+        draw_snapshot(worker->latest());
+        return;
+    }
+    auto& sim_bodies = simulation.getBodies();
+    for (size_t i = 0; i < sim_bodies.size(); i++)
+        bodies[i]->update(sim_bodies[i]->getBorder());
+    if (!_verbose) return;
+
+    // Size the batches, then fill them straight from the particles
+    int64_t line_count = 0, circle_count = 0;
+    for (auto body : sim_bodies) {
+        line_count += body->getConstraints().size();
+        if (auto proto = body->getPrototype()) line_count += proto->getEdges().size();
+        circle_count += body->getParticles().size() + body->getBorder().size();
+    }
+    debug_draw.begin(line_count, circle_count);
+
+    int64_t l = 0, c = 0;
+    for (auto body : sim_bodies) {
+        for (auto con : body->getConstraints())
+            debug_draw.setLine(l++, convert::to_godot(con->getPart1()), convert::to_godot(con->getPart2()));
+        auto& particles = body->getParticles();
+        if (auto proto = body->getPrototype()) {
+            for (auto& e : proto->getEdges())
+                debug_draw.setLine(l++, convert::to_godot(particles[e.first]->getPosition()),
+                                        convert::to_godot(particles[e.second]->getPosition()));
         }
+        for (auto p : particles)
+            debug_draw.setCircle(c++, convert::to_godot(p->getPosition()), p->getRadius(), Color(1,0,0));
+    }
+    // Border particles last, on top of the others
+    for (auto body : sim_bodies)
+        for (auto p : body->getBorder())
+            debug_draw.setCircle(c++, convert::to_godot(p->getPosition()), p->getRadius(), Color(0,1,0));
+    debug_draw.draw(this, Color(1,1,1), -1.0);
+}
+
+void GDSimulation_2::draw_snapshot(const sim::SimulationSnapshot& snapshot) {
+    // Bodies built after the snapshot was taken keep their polygon until the next one
+    size_t count = std::min(bodies.size(), snapshot.border_offsets.size() - 1);
+    for (size_t i = 0; i < count; i++) {
+        size_t begin = snapshot.border_offsets[i];
+        bodies[i]->update(snapshot.borders.data() + begin, snapshot.border_offsets[i + 1] - begin);
+    }
+    // Detail appears one step after the debug view is turned on
+    if (!_verbose || snapshot.particle_offsets.empty()) return;
+
+    int64_t line_count = snapshot.lines.size() / 2;
+    int64_t circle_count = snapshot.particles.size() + snapshot.borders.size();
+    debug_draw.begin(line_count, circle_count);
+    for (int64_t l = 0; l < line_count; l++)
+        debug_draw.setLine(l, convert::to_godot(snapshot.lines[2 * l]), convert::to_godot(snapshot.lines[2 * l + 1]));
+    int64_t c = 0;
+    for (size_t i = 0; i < snapshot.particles.size(); i++)
+        debug_draw.setCircle(c++, convert::to_godot(snapshot.particles[i]), snapshot.radii[i], Color(1,0,0));
+    for (size_t i = 0; i < snapshot.borders.size(); i++)
+        debug_draw.setCircle(c++, convert::to_godot(snapshot.borders[i]), snapshot.border_radii[i], Color(0,1,0));
+    debug_draw.draw(this, Color(1,1,1), -1.0);
+}
+
+void GDSimulation_2::set_background_thread(const bool e) {
+    background_thread = e;
+    if (!e) {
+        worker.reset();
+    } else if (!worker && !simulation.getBodies().empty()) {
+        worker = std::make_unique<sim::SimulationWorker>(simulation);
+        worker->setMaxLag(max_lag);
+    }
+}
+
+void GDSimulation_2::add_monitors() {
+    remove_monitors();
+    Performance* performance = Performance::get_singleton();
+    String category = String("softbody_") + String(get_name()) + "/";
+    for (int id = 0; id < MONITOR_COUNT; id++) {
+        StringName name = category + monitor_name(id);
+        // Another simulation with the same name keeps its monitors
+        if (performance->has_custom_monitor(name)) continue;
+        Array arguments;
+        arguments.push_back(id);
+        performance->add_custom_monitor(name, Callable(this, "get_monitor"), arguments);
+        monitors.push_back(name);
+    }
+}
+
+void GDSimulation_2::remove_monitors() {
+    Performance* performance = Performance::get_singleton();
+    for (auto& name : monitors)
+        if (performance->has_custom_monitor(name)) performance->remove_custom_monitor(name);
+    monitors.clear();
+}
+
+double GDSimulation_2::get_monitor(int id) {
+    // With the worker, the statistics travel in the snapshots
+    const sim::StepStats& stats = worker ? worker->latest().stats : simulation.getStats();
+    if (id >= 0 && id < sim::PHASE_COUNT) return stats.phase_ms[id];
+    switch (id) {
+    case MONITOR_STEP:               return stats.step_ms;
+    case MONITOR_BODIES:             return (double)stats.bodies;
+    case MONITOR_PARTICLES:          return (double)stats.particles;
+    case MONITOR_CONSTRAINTS:        return (double)stats.constraints;
+    case MONITOR_BODY_CONTACTS:      return (double)stats.body_contacts;
+    case MONITOR_RESTING_BODIES:     return (double)stats.resting_bodies;
+    case MONITOR_WORKER_UTILIZATION: return worker ? 100.0 * worker->takeUtilization() : 0.0;
+    case MONITOR_WORKER_LAG:         return (double)get_simulation_lag();
+    default:                         return 0.0;
     }
 }
 
@@ -40,15 +161,66 @@ void godot::GDSimulation_2::_bind_methods() {
     ClassDB::bind_method(D_METHOD("get_gravity"), &GDSimulation_2::get_gravity);
     ClassDB::bind_method(D_METHOD("set_debug", "bool"), &GDSimulation_2::set_debug);
     ClassDB::bind_method(D_METHOD("get_debug"), &GDSimulation_2::get_debug);
+    ClassDB::bind_method(D_METHOD("set_mesh_cache", "enabled"), &GDSimulation_2::set_mesh_cache);
+    ClassDB::bind_method(D_METHOD("get_mesh_cache"), &GDSimulation_2::get_mesh_cache);
+    ClassDB::bind_method(D_METHOD("set_mesh_cache_dir", "path"), &GDSimulation_2::set_mesh_cache_dir);
+    ClassDB::bind_method(D_METHOD("get_mesh_cache_dir"), &GDSimulation_2::get_mesh_cache_dir);
+    ClassDB::bind_method(D_METHOD("set_sort_interval", "steps"), &GDSimulation_2::set_sort_interval);
+    ClassDB::bind_method(D_METHOD("get_sort_interval"), &GDSimulation_2::get_sort_interval);
+    ClassDB::bind_method(D_METHOD("set_continuous_collisions", "enabled"), &GDSimulation_2::set_continuous_collisions);
+    ClassDB::bind_method(D_METHOD("get_continuous_collisions"), &GDSimulation_2::get_continuous_collisions);
+    ClassDB::bind_method(D_METHOD("set_world_clearance", "enabled"), &GDSimulation_2::set_world_clearance);
+    ClassDB::bind_method(D_METHOD("get_world_clearance"), &GDSimulation_2::get_world_clearance);
+    ClassDB::bind_method(D_METHOD("set_surface_collisions", "enabled"), &GDSimulation_2::set_surface_collisions);
+    ClassDB::bind_method(D_METHOD("get_surface_collisions"), &GDSimulation_2::get_surface_collisions);
+    ClassDB::bind_method(D_METHOD("set_sphere_trees", "enabled"), &GDSimulation_2::set_sphere_trees);
+    ClassDB::bind_method(D_METHOD("get_sphere_trees"), &GDSimulation_2::get_sphere_trees);
+    ClassDB::bind_method(D_METHOD("set_edge_contacts", "enabled"), &GDSimulation_2::set_edge_contacts);
+    ClassDB::bind_method(D_METHOD("get_edge_contacts"), &GDSimulation_2::get_edge_contacts);
+    ClassDB::bind_method(D_METHOD("set_contact_cache", "enabled"), &GDSimulation_2::set_contact_cache);
+    ClassDB::bind_method(D_METHOD("get_contact_cache"), &GDSimulation_2::get_contact_cache);
+    ClassDB::bind_method(D_METHOD("set_contact_pipeline", "enabled"), &GDSimulation_2::set_contact_pipeline);
+    ClassDB::bind_method(D_METHOD("get_contact_pipeline"), &GDSimulation_2::get_contact_pipeline);
+    ClassDB::bind_method(D_METHOD("set_threads", "count"), &GDSimulation_2::set_threads);
+    ClassDB::bind_method(D_METHOD("get_threads"), &GDSimulation_2::get_threads);
+    ClassDB::bind_method(D_METHOD("set_background_thread", "enabled"), &GDSimulation_2::set_background_thread);
+    ClassDB::bind_method(D_METHOD("get_background_thread"), &GDSimulation_2::get_background_thread);
+    ClassDB::bind_method(D_METHOD("set_max_lag", "steps"), &GDSimulation_2::set_max_lag);
+    ClassDB::bind_method(D_METHOD("get_max_lag"), &GDSimulation_2::get_max_lag);
+    ClassDB::bind_method(D_METHOD("get_simulation_lag"), &GDSimulation_2::get_simulation_lag);
+    ClassDB::bind_method(D_METHOD("get_dropped_steps"), &GDSimulation_2::get_dropped_steps);
+    ClassDB::bind_method(D_METHOD("get_monitor", "id"), &GDSimulation_2::get_monitor);
 
     ADD_PROPERTY(PropertyInfo(Variant::VECTOR2, "gravity"), "set_gravity", "get_gravity");
     ADD_PROPERTY(PropertyInfo(Variant::BOOL, "draw_debug"), "set_debug", "get_debug");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "mesh_cache"), "set_mesh_cache", "get_mesh_cache");
+    ADD_PROPERTY(PropertyInfo(Variant::STRING, "mesh_cache_dir"), "set_mesh_cache_dir", "get_mesh_cache_dir");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "sort_interval"), "set_sort_interval", "get_sort_interval");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "continuous_collisions"), "set_continuous_collisions", "get_continuous_collisions");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "world_clearance"), "set_world_clearance", "get_world_clearance");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "surface_collisions"), "set_surface_collisions", "get_surface_collisions");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "sphere_trees"), "set_sphere_trees", "get_sphere_trees");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "edge_contacts"), "set_edge_contacts", "get_edge_contacts");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "contact_cache"), "set_contact_cache", "get_contact_cache");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "contact_pipeline"), "set_contact_pipeline", "get_contact_pipeline");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "threads"), "set_threads", "get_threads");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "background_thread"), "set_background_thread", "get_background_thread");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "max_lag"), "set_max_lag", "get_max_lag");
 }
 
 void godot::GDSimulation_2::build() {
+    // The worker must not step while the scene is rebuilt
+    worker.reset();
     simulation.clear();
     simulation.setGravity(convert::from_godot(gravity));
 
+    // Meshes of unchanged polygons are reused, on disk across runs if a directory is set
+    sim::MeshCache& cache = sim::MeshCache::instance();
+    cache.setEnabled(mesh_cache);
+    String dir = mesh_cache_dir.is_empty() ? String() : ProjectSettings::get_singleton()->globalize_path(mesh_cache_dir);
+    if (!dir.is_empty()) DirAccess::make_dir_recursive_absolute(dir);
+    cache.setDirectory(dir.utf8().get_data());
+
     bodies.clear();
     TypedArray<Node> childs = get_children();
     for (int i = 0; i < childs.size(); i++) {
@@ -60,8 +232,8 @@ void godot::GDSimulation_2::build() {
             sb->reset();
             sb->build();
             if (sb->get_sim_softbody()){
-                bodies.insert({sb->get_sim_softbody(), sb});
-                simulation.addBody(sb->take_sim_softbody());
+                bodies.push_back(sb);
+                simulation.addBody(sb->take_sim_softbody(this));
             }
         }
         GDCollider* wc = Object::cast_to<GDCollider>(child);
@@ -69,9 +241,14 @@ void godot::GDSimulation_2::build() {
             wc->reset();
             wc->build();
             if (wc->get_sim_collider()){
-                simulation.addCollider(wc->take_sim_collider());
+                simulation.addCollider(wc->take_sim_collider(this));
                 colliders.push_back(wc);
             }
         }
     }
+
+    if (background_thread) {
+        worker = std::make_unique<sim::SimulationWorker>(simulation);
+        worker->setMaxLag(max_lag);
+    }
 }
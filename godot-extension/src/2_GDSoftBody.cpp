@@ -1,4 +1,5 @@
 #include "2_GDSoftBody.h"
+#include "2_GDSimulation.h"
 
 using namespace godot;
 
@@ -21,7 +22,23 @@ void GDSoftBody_2::_bind_methods() {
     ClassDB::bind_method(D_METHOD("set_damping","damping"), &GDSoftBody_2::set_damping);
     ClassDB::bind_method(D_METHOD("get_damping"), &GDSoftBody_2::get_damping);
 
+    ClassDB::bind_method(D_METHOD("set_mesh_type","mesh_type"), &GDSoftBody_2::set_mesh_type);
+    ClassDB::bind_method(D_METHOD("get_mesh_type"), &GDSoftBody_2::get_mesh_type);
+    ClassDB::bind_method(D_METHOD("set_reorder","reorder"), &GDSoftBody_2::set_reorder);
+    ClassDB::bind_method(D_METHOD("get_reorder"), &GDSoftBody_2::get_reorder);
+
+    ClassDB::bind_method(D_METHOD("set_collision_layer","layer"), &GDSoftBody_2::set_collision_layer);
+    ClassDB::bind_method(D_METHOD("get_collision_layer"), &GDSoftBody_2::get_collision_layer);
+    ClassDB::bind_method(D_METHOD("set_collision_mask","mask"), &GDSoftBody_2::set_collision_mask);
+    ClassDB::bind_method(D_METHOD("get_collision_mask"), &GDSoftBody_2::get_collision_mask);
+
     ADD_PROPERTY(PropertyInfo(Variant::INT, "unit"), "set_unit", "get_unit");
+    ADD_PROPERTY(
+        PropertyInfo(Variant::INT, "mesh_type",
+        PROPERTY_HINT_ENUM, "RING,LATTICE"),
+        "set_mesh_type", "get_mesh_type"
+    );
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "reorder"), "set_reorder", "get_reorder");
 
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "friction"), "set_friction", "get_friction");
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "restitution"), "set_restitution", "get_restitution");
@@ -31,6 +48,9 @@ void GDSoftBody_2::_bind_methods() {
 
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "particule_mass"), "set_mass", "get_mass");
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "particles_radius"), "set_radius", "get_radius");
+
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "collision_layer", PROPERTY_HINT_LAYERS_2D_PHYSICS), "set_collision_layer", "get_collision_layer");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "collision_mask", PROPERTY_HINT_LAYERS_2D_PHYSICS), "set_collision_mask", "get_collision_mask");
 }
 
 GDSoftBody_2::~GDSoftBody_2() {
@@ -72,24 +92,68 @@ void GDSoftBody_2::build() {
     }
 
     if (border.size() >= 1) {
-        soft_body = sim::SoftBody::createFromPolygon(border, unit, mass, particles_radius, stiffness, damping, friction, restitution);
+        soft_body = sim::SoftBody::createFromPolygon(border, unit, mass, particles_radius, stiffness, damping, friction, restitution,
+            false, (sim::MESH_TYPE)mesh_type, reorder);
+        soft_body->setCollisionLayer(collision_layer);
+        soft_body->setCollisionMask(collision_mask);
     } else {
         soft_body = nullptr;
     }
 }
 
-void GDSoftBody_2::update(std::vector<sim::Particle*> new_border) {
-    PackedVector2Array b;
-    Vector2 global_position = get_global_position();
-    
-    b.resize(new_border.size());
-    for (int i = 0; i < new_border.size(); i++) {
-        b[i] = convert::to_godot(new_border[i]->getPosition()) - global_position;
+Vector2* GDSoftBody_2::next_polygon(int64_t count) {
+    // The polygon handed to Godot last frame is still shared with the node,
+    // writing to the other buffer avoids a copy-on-write reallocation
+    current_polygon ^= 1;
+    PackedVector2Array& b = polygon_buffers[current_polygon];
+    if (b.size() != count) b.resize(count);
+    return b.ptrw();
+}
+
+void GDSoftBody_2::update(const std::vector<sim::Particle*>& new_border) {
+    int64_t n = (int64_t)new_border.size();
+    Vector2* out = next_polygon(n);
+    const Vector2 origin = get_global_position();
+    for (int64_t i = 0; i < n; i++) {
+        const sim::Vector2& p = new_border[i]->getPosition();
+        // Same as convert::to_godot(p) - global_position
+        out[i] = Vector2((real_t)p.x - origin.x, (real_t)-p.y - origin.y);
+    }
+    set_polygon(polygon_buffers[current_polygon]);
+}
+
+void GDSoftBody_2::update(const sim::Vector2* points, size_t count) {
+    Vector2* out = next_polygon((int64_t)count);
+    const Vector2 origin = get_global_position();
+    for (size_t i = 0; i < count; i++)
+        out[i] = Vector2((real_t)points[i].x - origin.x, (real_t)-points[i].y - origin.y);
+    set_polygon(polygon_buffers[current_polygon]);
+}
+
+void GDSoftBody_2::set_collision_layer(const uint32_t l) {
+    collision_layer = l;
+    if (soft_body) soft_body->setCollisionLayer(l);
+    if (sim_body) {
+        // Waits for the steps queued on the worker thread
+        owner->edit();
+        sim_body->setCollisionLayer(l);
+    }
+}
+
+void GDSoftBody_2::set_collision_mask(const uint32_t m) {
+    collision_mask = m;
+    if (soft_body) soft_body->setCollisionMask(m);
+    if (sim_body) {
+        // Waits for the steps queued on the worker thread
+        owner->edit();
+        sim_body->setCollisionMask(m);
     }
-    set_polygon(b);
 }
 
 void GDSoftBody_2::reset() {
+    // The simulation deletes the body it was handed
+    sim_body = nullptr;
+    owner = nullptr;
     if (soft_body) {
         delete soft_body;
         soft_body = nullptr;
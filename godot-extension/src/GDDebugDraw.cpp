@@ -0,0 +1,65 @@
+//GDDebugDraw.cpp
+#include "GDDebugDraw.h"
+
+#include <godot_cpp/classes/rendering_server.hpp>
+#include <godot_cpp/core/math.hpp>
+#include <godot_cpp/variant/array.hpp>
+
+using namespace godot;
+
+// Triangles of the disc mesh
+static constexpr int DISC_SEGMENTS = 16;
+
+DebugDraw::~DebugDraw() {
+    RenderingServer *rs = RenderingServer::get_singleton();
+    if (!rs) return;
+    if (multimesh.is_valid()) rs->free_rid(multimesh);
+    if (mesh.is_valid()) rs->free_rid(mesh);
+}
+
+void DebugDraw::begin(int64_t line_count, int64_t circle_count) {
+    // Resizing to the same size keeps the storage
+    lines.resize(2 * line_count);
+    instances.resize(circle_count * FLOATS_PER_INSTANCE);
+    lines_ptr = lines.ptrw();
+    instances_ptr = instances.ptrw();
+    this->circle_count = circle_count;
+}
+
+void DebugDraw::create_mesh() {
+    RenderingServer *rs = RenderingServer::get_singleton();
+    PackedVector2Array vertices;
+    vertices.resize(3 * DISC_SEGMENTS);
+    for (int i = 0; i < DISC_SEGMENTS; i++) {
+        real_t a0 = Math_TAU * i / DISC_SEGMENTS;
+        real_t a1 = Math_TAU * (i + 1) / DISC_SEGMENTS;
+        vertices[3 * i] = Vector2();
+        vertices[3 * i + 1] = Vector2(Math::cos(a0), Math::sin(a0));
+        vertices[3 * i + 2] = Vector2(Math::cos(a1), Math::sin(a1));
+    }
+    Array arrays;
+    arrays.resize(RenderingServer::ARRAY_MAX);
+    arrays[RenderingServer::ARRAY_VERTEX] = vertices;
+
+    mesh = rs->mesh_create();
+    rs->mesh_add_surface_from_arrays(mesh, RenderingServer::PRIMITIVE_TRIANGLES, arrays);
+    multimesh = rs->multimesh_create();
+    rs->multimesh_set_mesh(multimesh, mesh);
+}
+
+void DebugDraw::draw(CanvasItem *item, const Color &line_color, real_t line_width) {
+    if (!lines.is_empty())
+        item->draw_multiline(lines, line_color, line_width);
+    lines_ptr = nullptr;
+    instances_ptr = nullptr;
+    if (circle_count == 0) return;
+
+    RenderingServer *rs = RenderingServer::get_singleton();
+    if (!multimesh.is_valid()) create_mesh();
+    if (allocated != circle_count) {
+        rs->multimesh_allocate_data(multimesh, circle_count, RenderingServer::MULTIMESH_TRANSFORM_2D, true);
+        allocated = circle_count;
+    }
+    rs->multimesh_set_buffer(multimesh, instances);
+    rs->canvas_item_add_multimesh(item->get_canvas_item(), multimesh);
+}
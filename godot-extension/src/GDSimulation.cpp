@@ -17,18 +17,30 @@ void GDSimulation::_bind_methods() {
 }
 
 void GDSimulation::draw_simulation() {
-    for (auto body : simulation.getBodies()) {
-        for (auto c: body->getConstraints()) {
-            Vector2 p1 = convert::to_godot(c->getPart1()) * SCALE_DRAW;
-            Vector2 p2 = convert::to_godot(c->getPart2()) * SCALE_DRAW;
-            draw_line(p1,p2,Color(1,1,1), 3.0);
-        }
-        for (auto p : body->getParticles()) {
-            Vector2 pos = convert::to_godot(p->getPosition()) * SCALE_DRAW;
-            float radius = p->getRadius() * SCALE_DRAW;
-            draw_circle(pos, radius, Color(1,0,0));
+    auto& sim_bodies = simulation.getBodies();
+    int64_t line_count = 0, circle_count = 0;
+    for (auto body : sim_bodies) {
+        line_count += body->getConstraints().size();
+        if (auto proto = body->getPrototype()) line_count += proto->getEdges().size();
+        circle_count += body->getParticles().size();
+    }
+    debug_draw.begin(line_count, circle_count);
+
+    int64_t l = 0, c = 0;
+    for (auto body : sim_bodies) {
+        for (auto con: body->getConstraints())
+            debug_draw.setLine(l++, to_godot(con->getPart1()) * SCALE_DRAW, to_godot(con->getPart2()) * SCALE_DRAW);
+        auto& particles = body->getParticles();
+        if (auto proto = body->getPrototype()) {
+            for (auto& e: proto->getEdges())
+                debug_draw.setLine(l++, to_godot(particles[e.first]->getPosition()) * SCALE_DRAW,
+                                        to_godot(particles[e.second]->getPosition()) * SCALE_DRAW);
         }
+        for (auto p : particles)
+            debug_draw.setCircle(c++, to_godot(p->getPosition()) * SCALE_DRAW, p->getRadius() * SCALE_DRAW, Color(1,0,0));
     }
+    debug_draw.draw(this, Color(1,1,1), 3.0);
+
     for (auto* col: simulation.getColliders()) {
         if (auto* plane = dynamic_cast<sim::PlaneCollider*>(col)) {
             Vector2 n = to_godot(plane->getNormal());
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include "ContactCache.h"
+
+using sim::ContactCache;
+using sim::ContactManifold;
+using sim::Particle;
+using sim::SoftBody;
+using sim::Vector2;
+
+// Row of particles of radius 0.5 along x at height y
+static SoftBody* makeRow(double y, int n) {
+    std::vector<Particle*> particles;
+    for (int i = 0; i < n; i++)
+        particles.push_back(new Particle(Vector2(i, y), 1.0, 0.5));
+    return new SoftBody(particles);
+}
+
+static void deleteBody(SoftBody* body) {
+    for (auto p : body->getParticles()) delete p;
+    delete body;
+}
+
+TEST(ContactCacheTest, RebuildFindsPairsWithinTheSkin) {
+    SoftBody* a = makeRow(0.0, 4);
+    SoftBody* b = makeRow(1.2, 4);
+    ContactManifold m;
+    EXPECT_FALSE(m.isValid(a->getParticles(), b->getParticles(), 0.5));
+
+    m.rebuild(a->getParticles(), b->getParticles(), 0.5);
+    // Only vertical neighbours are closer than 1 + 0.5
+    ASSERT_EQ(m.pairs.size(), 4u);
+    for (auto& pair : m.pairs) EXPECT_EQ(pair.a, pair.b);
+    EXPECT_TRUE(m.isValid(a->getParticles(), b->getParticles(), 0.5));
+
+    deleteBody(a);
+    deleteBody(b);
+}
+
+TEST(ContactCacheTest, MovingMoreThanHalfTheSkinInvalidates) {
+    SoftBody* a = makeRow(0.0, 4);
+    SoftBody* b = makeRow(1.2, 4);
+    ContactManifold m;
+    m.rebuild(a->getParticles(), b->getParticles(), 0.5);
+
+    b->getParticles()[2]->setPosition(Vector2(2, 1.0));
+    EXPECT_TRUE(m.isValid(a->getParticles(), b->getParticles(), 0.5));
+    b->getParticles()[2]->setPosition(Vector2(2, 0.9));
+    EXPECT_FALSE(m.isValid(a->getParticles(), b->getParticles(), 0.5));
+
+    deleteBody(a);
+    deleteBody(b);
+}
+
+TEST(ContactCacheTest, RebuildKeepsTheStateOfRemainingPairs) {
+    SoftBody* a = makeRow(0.0, 4);
+    SoftBody* b = makeRow(1.2, 4);
+    ContactManifold m;
+    m.rebuild(a->getParticles(), b->getParticles(), 0.5);
+    m.pairs[1].correction = 0.25;
+    m.pairs[1].age = 7;
+
+    // Separate the last column, the others keep their state
+    b->getParticles()[3]->setPosition(Vector2(3, 5));
+    m.rebuild(a->getParticles(), b->getParticles(), 0.5);
+    ASSERT_EQ(m.pairs.size(), 3u);
+    EXPECT_EQ(m.pairs[1].a, 1);
+    EXPECT_DOUBLE_EQ(m.pairs[1].correction, 0.25);
+    EXPECT_EQ(m.pairs[1].age, 7);
+    EXPECT_EQ(m.pairs[0].age, 0);
+
+    deleteBody(a);
+    deleteBody(b);
+}
+
+TEST(ContactCacheTest, UnusedManifoldsAreDropped) {
+    SoftBody* a = makeRow(0.0, 2);
+    SoftBody* b = makeRow(1.2, 2);
+    SoftBody* c = makeRow(2.4, 2);
+    ContactCache cache;
+
+    cache.manifold(a, b);
+    cache.manifold(b, c);
+    cache.endStep();
+    EXPECT_EQ(cache.size(), 2u);
+
+    cache.manifold(a, b);
+    cache.endStep();
+    EXPECT_EQ(cache.size(), 1u);
+
+    deleteBody(a);
+    deleteBody(b);
+    deleteBody(c);
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <set>
+
+#include "EdgeTree.h"
+
+using sim::AABB;
+using sim::EdgeTree;
+using sim::Particle;
+using sim::Vector2;
+
+// Closed ring of n particles on a circle
+static std::vector<std::unique_ptr<Particle>> ring(int n, double radius) {
+    std::vector<std::unique_ptr<Particle>> out;
+    for (int i = 0; i < n; i++) {
+        double a = 2.0 * M_PI * i / n;
+        out.push_back(std::make_unique<Particle>(Vector2(std::cos(a), std::sin(a)) * radius, 1.0, 0.1));
+    }
+    return out;
+}
+
+static std::vector<Particle*> pointers(const std::vector<std::unique_ptr<Particle>>& particles) {
+    std::vector<Particle*> out;
+    for (auto& p : particles) out.push_back(p.get());
+    return out;
+}
+
+static std::set<int> overlaps(const EdgeTree& tree, const AABB& box) {
+    std::set<int> out;
+    tree.forEachOverlap(box, [&](int e) { out.insert(e); });
+    return out;
+}
+
+TEST(EdgeTreeTest, FindsTheEdgesUnderABox) {
+    auto particles = ring(64, 10.0);
+    auto outline = pointers(particles);
+    EdgeTree tree;
+    tree.build(outline);
+    EXPECT_EQ(tree.getEdgeCount(), 64u);
+    EXPECT_GT(tree.getNodeCount(), 1u);
+
+    // Same result as testing every edge
+    AABB box = { Vector2(8, -2), Vector2(11, 2) };
+    std::set<int> expected;
+    for (int e = 0; e < 64; e++) {
+        Vector2 a = outline[e]->getPosition(), b = outline[(e + 1) % 64]->getPosition();
+        AABB edge = { Vector2(std::min(a.x, b.x) - 0.1, std::min(a.y, b.y) - 0.1),
+                      Vector2(std::max(a.x, b.x) + 0.1, std::max(a.y, b.y) + 0.1) };
+        if (sim::aabbOverlap(edge, box)) expected.insert(e);
+    }
+    EXPECT_EQ(overlaps(tree, box), expected);
+    // Includes the edge closing the ring
+    EXPECT_TRUE(expected.count(63));
+    EXPECT_TRUE(overlaps(tree, { Vector2(-1, -1), Vector2(1, 1) }).empty());
+}
+
+TEST(EdgeTreeTest, RefitFollowsTheParticles) {
+    auto particles = ring(32, 10.0);
+    auto outline = pointers(particles);
+    EdgeTree tree;
+    tree.build(outline);
+    AABB far = { Vector2(99, -1), Vector2(101, 1) };
+    EXPECT_TRUE(overlaps(tree, far).empty());
+
+    particles[0]->setPosition(Vector2(100, 0));
+    tree.refit(outline);
+    EXPECT_EQ(overlaps(tree, far), (std::set<int>{ 0, 31 }));
+    EXPECT_GE(tree.getBounds().max.x, 100.1 - 1e-12);
+}
+
+TEST(EdgeTreeTest, ShortOutlines) {
+    auto particles = ring(2, 1.0);
+    EdgeTree tree;
+    tree.build(pointers(particles));
+    EXPECT_EQ(tree.getEdgeCount(), 1u);
+
+    tree.build({ particles[0].get() });
+    EXPECT_TRUE(tree.empty());
+    EXPECT_TRUE(overlaps(tree, { Vector2(-5, -5), Vector2(5, 5) }).empty());
+}
+
+TEST(EdgeTreeTest, MeasuresTheWinding) {
+    auto particles = ring(16, 5.0);
+    auto outline = pointers(particles);
+    EdgeTree tree;
+    tree.build(outline);
+    EXPECT_EQ(tree.getWinding(), 1.0);
+
+    std::reverse(outline.begin(), outline.end());
+    tree.refit(outline);
+    EXPECT_EQ(tree.getWinding(), -1.0);
+}
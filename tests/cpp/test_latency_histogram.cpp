@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include "LatencyHistogram.h"
+
+using sim::LatencyHistogram;
+
+// --------------------------------------------------
+// Recording
+// --------------------------------------------------
+
+TEST(LatencyHistogramTest, EmptyHistogramReportsZero) {
+    LatencyHistogram h;
+
+    EXPECT_EQ(h.getCount(), 0u);
+    EXPECT_EQ(h.percentile(50), 0u);
+    EXPECT_EQ(h.getMax(), 0u);
+    EXPECT_EQ(h.getMin(), 0u);
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+    LatencyHistogram h;
+    for (uint64_t v = 1; v <= 100; v++) h.record(v);
+
+    EXPECT_EQ(h.getCount(), 100u);
+    EXPECT_EQ(h.getMin(), 1u);
+    EXPECT_EQ(h.getMax(), 100u);
+    EXPECT_EQ(h.percentile(50), 50u);
+    EXPECT_EQ(h.percentile(99), 99u);
+    EXPECT_DOUBLE_EQ(h.getMean(), 50.5);
+}
+
+TEST(LatencyHistogramTest, LargeValuesKeepRelativePrecision) {
+    LatencyHistogram h;
+    for (uint64_t v = 1; v <= 10000; v++) h.record(v * 1000);
+
+    auto within = [](uint64_t value, uint64_t expected) {
+        return std::abs(double(value) - double(expected)) <= expected / 64.0;
+    };
+    EXPECT_TRUE(within(h.percentile(50), 5000000));
+    EXPECT_TRUE(within(h.percentile(99), 9900000));
+    EXPECT_TRUE(within(h.percentile(99.9), 9990000));
+    EXPECT_EQ(h.percentile(100), 10000000u);
+}
+
+TEST(LatencyHistogramTest, TailSpikeShowsInHighPercentiles) {
+    LatencyHistogram h;
+    for (int i = 0; i < 999; i++) h.record(1000);
+    h.record(1000000);
+
+    EXPECT_LE(h.percentile(99), 1016u);
+    EXPECT_EQ(h.getMax(), 1000000u);
+    EXPECT_EQ(h.percentile(100), 1000000u);
+}
+
+TEST(LatencyHistogramTest, ResetClearsSamples) {
+    LatencyHistogram h;
+    h.record(42);
+    h.reset();
+
+    EXPECT_EQ(h.getCount(), 0u);
+    EXPECT_EQ(h.percentile(50), 0u);
+}
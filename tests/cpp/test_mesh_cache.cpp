@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#include "MeshCache.h"
+#include "SoftBody.h"
+
+using sim::MeshCache;
+using sim::MeshData;
+using sim::SoftBody;
+using sim::Vector2;
+
+static std::vector<Vector2> square(double side) {
+    return { Vector2(0, 0), Vector2(side, 0), Vector2(side, side), Vector2(0, side) };
+}
+
+static void deleteBody(SoftBody* body) {
+    for (auto p : body->getParticles()) delete p;
+    for (auto c : body->getConstraints()) delete c;
+    delete body;
+}
+
+// Every test starts from an empty, memory only cache and leaves it disabled
+class MeshCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        MeshCache::instance().clear();
+        MeshCache::instance().setDirectory("");
+        MeshCache::instance().setEnabled(true);
+    }
+    void TearDown() override {
+        MeshCache::instance().clear();
+        MeshCache::instance().setDirectory("");
+        MeshCache::instance().setEnabled(false);
+    }
+};
+
+TEST_F(MeshCacheTest, KeyDependsOnPolygonAndParameters) {
+    auto poly = square(50);
+    uint64_t k = MeshCache::key(poly, 10, 1, sim::RingMesh);
+
+    EXPECT_EQ(k, MeshCache::key(square(50), 10, 1, sim::RingMesh));
+    EXPECT_NE(k, MeshCache::key(square(51), 10, 1, sim::RingMesh));
+    EXPECT_NE(k, MeshCache::key(poly, 11, 1, sim::RingMesh));
+    EXPECT_NE(k, MeshCache::key(poly, 10, 2, sim::RingMesh));
+    EXPECT_NE(k, MeshCache::key(poly, 10, 1, sim::LatticeMesh));
+}
+
+TEST_F(MeshCacheTest, SecondCreationIsAHitWithTheSameMesh) {
+    MeshCache& cache = MeshCache::instance();
+    SoftBody* a = SoftBody::createFromPolygon(square(50), 10, 2, 1);
+    EXPECT_EQ(cache.getMisses(), 1u);
+    EXPECT_EQ(cache.getHits(), 0u);
+
+    // Physical parameters do not take part in the key
+    SoftBody* b = SoftBody::createFromPolygon(square(50), 10, 5, 1, 0.3);
+    EXPECT_EQ(cache.getHits(), 1u);
+    EXPECT_EQ(cache.size(), 1u);
+
+    ASSERT_EQ(a->getParticles().size(), b->getParticles().size());
+    ASSERT_EQ(a->getConstraints().size(), b->getConstraints().size());
+    for (size_t i = 0; i < a->getParticles().size(); i++)
+        EXPECT_EQ(a->getParticles()[i]->getPosition(), b->getParticles()[i]->getPosition());
+    EXPECT_DOUBLE_EQ(b->getParticles()[0]->getMass(), 5);
+    EXPECT_DOUBLE_EQ(b->getConstraints()[0]->getStiffness(), 0.3);
+
+    // Bodies never share particles
+    EXPECT_NE(a->getParticles()[0], b->getParticles()[0]);
+    deleteBody(a);
+    deleteBody(b);
+}
+
+TEST_F(MeshCacheTest, CachedBodyMatchesUncachedBody) {
+    auto poly = square(60);
+    SoftBody* cached = SoftBody::createFromPolygon(poly, 10);
+    deleteBody(cached);
+    cached = SoftBody::createFromPolygon(poly, 10);
+    ASSERT_EQ(MeshCache::instance().getHits(), 1u);
+
+    MeshCache::instance().setEnabled(false);
+    SoftBody* fresh = SoftBody::createFromPolygon(poly, 10);
+
+    ASSERT_EQ(cached->getParticles().size(), fresh->getParticles().size());
+    ASSERT_EQ(cached->getConstraints().size(), fresh->getConstraints().size());
+    ASSERT_EQ(cached->getBorder().size(), fresh->getBorder().size());
+    for (size_t i = 0; i < fresh->getParticles().size(); i++)
+        EXPECT_EQ(cached->getParticles()[i]->getPosition(), fresh->getParticles()[i]->getPosition());
+    for (size_t i = 0; i < fresh->getBorder().size(); i++)
+        EXPECT_EQ(cached->getBorder()[i]->getPosition(), fresh->getBorder()[i]->getPosition());
+    deleteBody(cached);
+    deleteBody(fresh);
+}
+
+TEST_F(MeshCacheTest, DiskStoreSurvivesClear) {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "softbody_mesh_cache_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    MeshCache& cache = MeshCache::instance();
+    cache.setDirectory(dir.string());
+    auto poly = square(40);
+    deleteBody(SoftBody::createFromPolygon(poly, 10, 1, 1, 0.8, 0.1, 0.1, 0.9, false, sim::LatticeMesh));
+    EXPECT_EQ(std::distance(fs::directory_iterator(dir), fs::directory_iterator()), 1);
+
+    // Memory is dropped, the mesh comes back from disk
+    cache.clear();
+    auto mesh = cache.find(poly, 10, 1, sim::LatticeMesh);
+    ASSERT_NE(mesh, nullptr);
+    EXPECT_EQ(cache.getHits(), 1u);
+
+    MeshData fresh = sim::meshPolygon(poly, 10, 1, sim::LatticeMesh);
+    ASSERT_EQ(mesh->points.size(), fresh.points.size());
+    for (size_t i = 0; i < fresh.points.size(); i++)
+        EXPECT_EQ(mesh->points[i], fresh.points[i]);
+    EXPECT_EQ(mesh->edges, fresh.edges);
+    EXPECT_EQ(mesh->border, fresh.border);
+
+    // Other parameters are a miss even if they were to share the file
+    EXPECT_EQ(cache.find(poly, 10, 1, sim::RingMesh), nullptr);
+    fs::remove_all(dir);
+}
+
+TEST_F(MeshCacheTest, DamagedFileIsAMiss) {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "softbody_mesh_cache_damaged";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    MeshCache& cache = MeshCache::instance();
+    cache.setDirectory(dir.string());
+    auto poly = square(40);
+    cache.mesh(poly, 10, 1, sim::LatticeMesh);
+    ASSERT_EQ(std::distance(fs::directory_iterator(dir), fs::directory_iterator()), 1);
+
+    // Valid CBOR, but a number instead of an object
+    fs::path file = fs::directory_iterator(dir)->path();
+    {
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+        out.put('\x01');
+    }
+    cache.clear();
+    std::shared_ptr<const MeshData> mesh;
+    EXPECT_NO_THROW(mesh = cache.mesh(poly, 10, 1, sim::LatticeMesh));
+    EXPECT_EQ(cache.getHits(), 0u);
+    EXPECT_EQ(cache.getMisses(), 1u);
+    ASSERT_NE(mesh, nullptr);
+    EXPECT_EQ(mesh->points.size(), sim::meshPolygon(poly, 10, 1, sim::LatticeMesh).points.size());
+    fs::remove_all(dir);
+}
+
+TEST_F(MeshCacheTest, DisabledCacheStoresNothing) {
+    MeshCache::instance().setEnabled(false);
+    deleteBody(SoftBody::createFromPolygon(square(50), 10));
+    EXPECT_EQ(MeshCache::instance().size(), 0u);
+    EXPECT_EQ(MeshCache::instance().getMisses(), 0u);
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include "PerfCounters.h"
+#include "Simulation.h"
+
+using sim::PerfCounters;
+using sim::Simulation;
+using sim::SoftBody;
+using sim::Particle;
+using sim::Vector2;
+
+// --------------------------------------------------
+// PerfCounters
+// --------------------------------------------------
+
+TEST(PerfCountersTest, ClosedCountersReadZero) {
+    PerfCounters counters;
+    uint64_t values[sim::COUNTER_COUNT];
+    counters.read(values);
+
+    EXPECT_FALSE(counters.isOpen());
+    for (auto v : values) EXPECT_EQ(v, 0u);
+}
+
+TEST(PerfCountersTest, OpenIsGracefulWhenUnavailable) {
+    PerfCounters counters;
+    bool opened = counters.open();
+
+    EXPECT_EQ(opened, counters.isOpen());
+    if (!opened) {
+        // perf_event_open not permitted here: nothing is available and reads stay zero
+        uint64_t values[sim::COUNTER_COUNT];
+        for (auto& v : values) v = 1;
+        counters.read(values);
+        for (int i = 0; i < sim::COUNTER_COUNT; i++) {
+            EXPECT_FALSE(counters.isAvailable((sim::PERF_COUNTER)i));
+            EXPECT_EQ(values[i], 0u);
+        }
+        return;
+    }
+
+    uint64_t before[sim::COUNTER_COUNT];
+    uint64_t after[sim::COUNTER_COUNT];
+    counters.read(before);
+    volatile double x = 0;
+    for (int i = 0; i < 100000; i++) x = x + i;
+    counters.read(after);
+
+    for (int i = 0; i < sim::COUNTER_COUNT; i++) {
+        if (counters.isAvailable((sim::PERF_COUNTER)i)) {
+            EXPECT_GE(after[i], before[i]);
+        }
+    }
+    counters.close();
+    EXPECT_FALSE(counters.isOpen());
+}
+
+// --------------------------------------------------
+// Simulation integration
+// --------------------------------------------------
+
+TEST(PerfCountersTest, SimulationReportsCountersPerPhase) {
+    PerfCounters probe;
+    bool available = probe.open();
+    probe.close();
+
+    Simulation sim;
+    sim.addBody(new SoftBody({ new Particle(Vector2(0, 0)) }));
+    sim.setGravity(Vector2(0, -10));
+    sim.setPerfCounters(true);
+
+    EXPECT_NO_THROW(sim.step(0.01));
+
+    const auto& stats = sim.getStats();
+    if (!available) {
+        // The simulation steps on, with every counter flagged unavailable and zero
+        for (int i = 0; i < sim::COUNTER_COUNT; i++) {
+            EXPECT_FALSE(stats.counters_available[i]);
+            for (int p = 0; p < sim::PHASE_COUNT; p++) EXPECT_EQ(stats.phase_counters[p][i], 0u);
+        }
+        sim.step(0.01);
+        EXPECT_EQ(sim.getStats().steps, 2u);
+        EXPECT_LT(sim.getBodies()[0]->getParticles()[0]->getPosition().y, 0.0);
+        return;
+    }
+    if (stats.counters_available[sim::CyclesCounter]) {
+        uint64_t cycles = 0;
+        for (int p = 0; p < sim::PHASE_COUNT; p++)
+            cycles += stats.phase_counters[p][sim::CyclesCounter];
+        EXPECT_GT(cycles, 0u);
+    }
+
+    sim.setPerfCounters(false);
+    sim.step(0.01);
+    EXPECT_FALSE(sim.getStats().counters_available[sim::CyclesCounter]);
+}
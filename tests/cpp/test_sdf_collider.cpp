@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+
+#include "PlaneWorldCollider.h"
+#include "CircleWorldCollider.h"
+#include "SDFWorldCollider.h"
+
+using sim::AABB;
+using sim::Particle;
+using sim::Vector2;
+using sim::PlaneCollider;
+using sim::OuterCircleCollider;
+using sim::SDFCollider;
+using sim::WorldCollider;
+
+static const AABB BOUNDS = { Vector2(-10, -10), Vector2(10, 10) };
+
+TEST(SDFColliderTest, BakedPlaneMatchesPlaneCollider) {
+    PlaneCollider plane(Vector2(0, 1), -2.0, 0.3, 0.7);
+    std::unique_ptr<SDFCollider> sdf(SDFCollider::bake(BOUNDS, 0.5, {}, { &plane }, 0.3, 0.7));
+
+    Particle a(Vector2(0.3, -1.6), 1.0, 1.0);
+    Particle b(Vector2(0.3, -1.6), 1.0, 1.0);
+    a.setPrevPosition(Vector2(0.1, -1.0));
+    b.setPrevPosition(Vector2(0.1, -1.0));
+
+    EXPECT_TRUE(plane.collide(&a, 0.5, 0.5));
+    EXPECT_TRUE(sdf->collide(&b, 0.5, 0.5));
+
+    // A linear field is interpolated exactly
+    EXPECT_NEAR(a.getPosition().x, b.getPosition().x, 1e-9);
+    EXPECT_NEAR(a.getPosition().y, b.getPosition().y, 1e-9);
+    EXPECT_NEAR(a.getPrevPosition().x, b.getPrevPosition().x, 1e-9);
+    EXPECT_NEAR(a.getPrevPosition().y, b.getPrevPosition().y, 1e-9);
+}
+
+TEST(SDFColliderTest, BakedPolygonPushesParticlesOut) {
+    std::vector<Vector2> square = { Vector2(-3, -3), Vector2(3, -3), Vector2(3, 3), Vector2(-3, 3) };
+    std::unique_ptr<SDFCollider> sdf(SDFCollider::bake(BOUNDS, 0.25, { square }));
+
+    EXPECT_LT(sdf->signedDistance(Vector2(0, 0)), 0.0);
+    EXPECT_NEAR(sdf->signedDistance(Vector2(0, 5)), 2.0, 1e-9);
+
+    Particle p(Vector2(0.1, 2.5), 1.0, 0.5);
+    EXPECT_TRUE(sdf->collide(&p, 0.5, 0.5));
+    EXPECT_NEAR(p.getPosition().y, 3.5, 1e-6);
+    EXPECT_NEAR(p.getPosition().x, 0.1, 1e-6);
+
+    Particle free(Vector2(0, 6), 1.0, 0.5);
+    EXPECT_FALSE(sdf->collide(&free, 0.5, 0.5));
+    EXPECT_EQ(free.getPosition(), Vector2(0, 6));
+}
+
+TEST(SDFColliderTest, PrimitivesAndPolygonsAreMerged) {
+    OuterCircleCollider circle(Vector2(5, 5), 2.0);
+    std::vector<Vector2> triangle = { Vector2(-6, -6), Vector2(-2, -6), Vector2(-4, -2) };
+    std::unique_ptr<SDFCollider> sdf(SDFCollider::bake(BOUNDS, 0.25, { triangle }, { &circle }));
+
+    EXPECT_LT(sdf->signedDistance(Vector2(5, 5)), 0.0);
+    EXPECT_LT(sdf->signedDistance(Vector2(-4, -5)), 0.0);
+    EXPECT_GT(sdf->signedDistance(Vector2(0, 0)), 0.0);
+}
+
+TEST(SDFColliderTest, ParticlesOutsideTheGridAreIgnored) {
+    PlaneCollider plane(Vector2(0, 1), 0.0);
+    std::unique_ptr<SDFCollider> sdf(SDFCollider::bake(BOUNDS, 1.0, {}, { &plane }));
+
+    Particle p(Vector2(20, -5), 1.0, 1.0);
+    EXPECT_FALSE(sdf->collide(&p, 0.5, 0.5));
+    EXPECT_FALSE(sdf->mayCollide({ Vector2(19, -6), Vector2(21, -4) }));
+}
+
+TEST(SDFColliderTest, MayCollideSkipsBoxesFarFromTheGeometry) {
+    PlaneCollider plane(Vector2(0, 1), 0.0);
+    std::unique_ptr<SDFCollider> sdf(SDFCollider::bake(BOUNDS, 1.0, {}, { &plane }));
+
+    EXPECT_FALSE(sdf->mayCollide({ Vector2(-1, 4), Vector2(1, 6) }));
+    EXPECT_TRUE(sdf->mayCollide({ Vector2(-1, -0.5), Vector2(1, 1.5) }));
+}
+
+TEST(SDFColliderTest, MayCollideFollowsTheSlopeOfTheGrid) {
+    // Not a distance field: the values change by 20 per cell
+    SDFCollider sdf(Vector2(0, 0), 1.0, 2, 2, { -10, 10, -10, 10 });
+    Particle a(Vector2(0.45, 0.5), 1.0, 0.1);
+    Particle b(Vector2(0.95, 0.5), 1.0, 0.1);
+    AABB box = sim::computeAABB({ &a, &b });
+
+    EXPECT_LT(sdf.clearance(a.getPosition()), a.getRadius());
+    EXPECT_TRUE(sdf.mayCollide(box));
+    EXPECT_TRUE(sdf.collide(&a, 0.5, 0.5));
+}
+
+TEST(SDFColliderTest, JsonRoundTripKeepsTheField) {
+    std::vector<Vector2> square = { Vector2(-3, -3), Vector2(3, -3), Vector2(3, 3), Vector2(-3, 3) };
+    std::unique_ptr<SDFCollider> sdf(SDFCollider::bake(BOUNDS, 0.5, { square }, {}, 0.2, 0.4));
+
+    std::unique_ptr<WorldCollider> loaded(WorldCollider::from_json(sdf->as_json()));
+    auto* copy = dynamic_cast<SDFCollider*>(loaded.get());
+    ASSERT_NE(copy, nullptr);
+    EXPECT_EQ(copy->getWidth(), sdf->getWidth());
+    EXPECT_EQ(copy->getHeight(), sdf->getHeight());
+    EXPECT_EQ(copy->getDistances(), sdf->getDistances());
+
+    Vector2 ga, gb;
+    EXPECT_DOUBLE_EQ(copy->sample(Vector2(1.3, 3.7), ga), sdf->sample(Vector2(1.3, 3.7), gb));
+    EXPECT_EQ(ga, gb);
+}
+
+TEST(SDFColliderTest, ClearanceIsALowerBoundOfTheField) {
+    OuterCircleCollider rock(Vector2(0, 0), 3.0);
+    std::unique_ptr<SDFCollider> sdf(SDFCollider::bake(BOUNDS, 1.0, {}, { &rock }));
+
+    for (int i = 0; i < 40; i++) {
+        Vector2 a(-9 + i * 0.45, -7 + (i % 5) * 3.1);
+        Vector2 b(a.y * 0.8, -a.x * 0.6);
+        // The bound moves at most as fast as the point
+        EXPECT_LE(std::abs(sdf->clearance(a) - sdf->clearance(b)), (a - b).length() + 1e-12);
+        double s = sdf->signedDistance(a);
+        if (s > 0.0) {
+            EXPECT_LE(sdf->clearance(a), s);
+        }
+    }
+}
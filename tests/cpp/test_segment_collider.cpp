@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <set>
+
+#include "SegmentWorldCollider.h"
+
+using sim::AABB;
+using sim::Particle;
+using sim::ParticleBatch;
+using sim::Segment;
+using sim::SegmentMeshCollider;
+using sim::Vector2;
+using sim::WorldCollider;
+
+// Wavy terrain of n segments along x
+static std::vector<Segment> terrain(int n) {
+    std::vector<Vector2> points;
+    for (int i = 0; i <= n; i++)
+        points.push_back(Vector2(i, std::sin(i * 0.3) * 2.0));
+    return SegmentMeshCollider::polyline(points);
+}
+
+TEST(SegmentMeshColliderTest, PushesParticleOffTheSegment) {
+    SegmentMeshCollider ground({ { Vector2(-5, 0), Vector2(5, 0) } });
+    Particle p(Vector2(1, 0.4), 1.0, 1.0);
+    p.setPrevPosition(Vector2(1, 1.0));
+
+    EXPECT_TRUE(ground.collide(&p, 0.5, 0.5));
+    EXPECT_NEAR(p.getPosition().y, 1.0, 1e-9);
+    EXPECT_NEAR(p.getPosition().x, 1.0, 1e-9);
+
+    // Segments are two-sided
+    Particle below(Vector2(1, -0.4), 1.0, 1.0);
+    EXPECT_TRUE(ground.collide(&below, 0.5, 0.5));
+    EXPECT_NEAR(below.getPosition().y, -1.0, 1e-9);
+
+    // And finite
+    Particle beyond(Vector2(7, 0), 1.0, 1.0);
+    EXPECT_FALSE(ground.collide(&beyond, 0.5, 0.5));
+}
+
+TEST(SegmentMeshColliderTest, QueryMatchesBruteForce) {
+    std::vector<Segment> segments = terrain(1000);
+    SegmentMeshCollider mesh(segments);
+    EXPECT_GT(mesh.getNodeCount(), 1u);
+
+    AABB box = { Vector2(400.5, -1), Vector2(405.2, 0.5) };
+    std::vector<int> found;
+    mesh.query(box, found);
+
+    std::set<int> expected;
+    for (int i = 0; i < (int)segments.size(); i++) {
+        AABB b = { Vector2(std::min(segments[i].a.x, segments[i].b.x), std::min(segments[i].a.y, segments[i].b.y)),
+                   Vector2(std::max(segments[i].a.x, segments[i].b.x), std::max(segments[i].a.y, segments[i].b.y)) };
+        if (sim::aabbOverlap(b, box)) expected.insert(i);
+    }
+    EXPECT_EQ(std::set<int>(found.begin(), found.end()), expected);
+    EXPECT_EQ(found.size(), expected.size());
+    EXPECT_LE(found.size(), 6u);
+}
+
+TEST(SegmentMeshColliderTest, BatchMatchesCollide) {
+    SegmentMeshCollider mesh(terrain(200), 0.3, 0.6);
+
+    // Few then many candidate segments
+    for (int width : { 4, 150 }) {
+        std::vector<Particle*> a, b;
+        for (int i = 0; i < 400; i++) {
+            Vector2 pos(10 + (i % 40) * width / 40.0, -3 + (i / 40) * 0.6);
+            a.push_back(new Particle(pos, 1.0, 0.5, i % 17 == 0));
+            b.push_back(new Particle(pos, 1.0, 0.5, i % 17 == 0));
+            a.back()->setPrevPosition(pos + Vector2(0.1, 0.2));
+            b.back()->setPrevPosition(pos + Vector2(0.1, 0.2));
+        }
+        for (auto p : a) mesh.collide(p, 0.5, 0.5);
+        ParticleBatch batch;
+        batch.gather(b);
+        mesh.collideBatch(batch, 0.5, 0.5);
+
+        for (size_t i = 0; i < a.size(); i++) {
+            EXPECT_EQ(a[i]->getPosition(), b[i]->getPosition()) << "width " << width << " particle " << i;
+            EXPECT_EQ(a[i]->getPrevPosition(), b[i]->getPrevPosition());
+            EXPECT_EQ(batch.x[i], b[i]->getPosition().x);
+        }
+        for (auto p : a) delete p;
+        for (auto p : b) delete p;
+    }
+}
+
+TEST(SegmentMeshColliderTest, JsonAndCborRoundTrip) {
+    SegmentMeshCollider mesh(terrain(50), 0.2, 0.4);
+
+    std::unique_ptr<WorldCollider> fromJson(WorldCollider::from_json(mesh.as_json()));
+    auto* copy = dynamic_cast<SegmentMeshCollider*>(fromJson.get());
+    ASSERT_NE(copy, nullptr);
+    ASSERT_EQ(copy->getSegments().size(), mesh.getSegments().size());
+    EXPECT_EQ(copy->getSegments()[7].b, mesh.getSegments()[7].b);
+
+    std::unique_ptr<SegmentMeshCollider> fromCbor(SegmentMeshCollider::from_cbor(mesh.to_cbor()));
+    ASSERT_EQ(fromCbor->getSegments().size(), mesh.getSegments().size());
+    EXPECT_EQ(fromCbor->as_json(), mesh.as_json());
+
+    EXPECT_THROW(SegmentMeshCollider::from_cbor({ 0x01, 0x02 }), std::invalid_argument);
+}
+
+TEST(SegmentMeshColliderTest, SweptCatchesFastParticles) {
+    SegmentMeshCollider ground({ { Vector2(-5, 0), Vector2(5, 0) } });
+
+    // Through the middle of the segment
+    Particle p(Vector2(1, -5), 1.0, 0.5);
+    p.setPrevPosition(Vector2(1, 5));
+    Particle q = p;
+    EXPECT_FALSE(ground.collide(&q, 0.5, 0.5));
+    EXPECT_TRUE(ground.collideSwept(&p, 0.5, 0.5));
+    EXPECT_NEAR(p.getPosition().x, 1.0, 1e-9);
+    EXPECT_NEAR(p.getPosition().y, 0.5, 1e-9);
+
+    // Grazing an end point
+    Particle e(Vector2(5.2, -5), 1.0, 0.5);
+    e.setPrevPosition(Vector2(5.2, 5));
+    EXPECT_TRUE(ground.collideSwept(&e, 0.5, 0.5));
+    EXPECT_NEAR((e.getPosition() - Vector2(5, 0)).length(), 0.5, 1e-9);
+    EXPECT_GT(e.getPosition().y, 0.0);
+
+    // Passing beside it
+    Particle m(Vector2(6, -5), 1.0, 0.5);
+    m.setPrevPosition(Vector2(6, 5));
+    EXPECT_FALSE(ground.collideSwept(&m, 0.5, 0.5));
+}
+
+TEST(SegmentMeshColliderTest, ClearanceIsTheDistanceToTheClosestSegment) {
+    std::vector<Segment> segments = terrain(200);
+    SegmentMeshCollider ground(segments);
+
+    for (int i = 0; i < 100; i++) {
+        Vector2 p(-10 + i * 2.3, -6 + (i % 7) * 2.0);
+        double best = std::numeric_limits<double>::infinity();
+        for (auto& s : segments) {
+            Vector2 ab = s.b - s.a;
+            double t = std::clamp((p - s.a).dot(ab) / ab.dot(ab), 0.0, 1.0);
+            best = std::min(best, (p - (s.a + ab * t)).length());
+        }
+        EXPECT_NEAR(ground.clearance(p), best, 1e-12);
+    }
+    EXPECT_TRUE(std::isinf(SegmentMeshCollider({}).clearance(Vector2(0, 0))));
+}
@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
 
+#include <fstream>
+#include <functional>
+#include <set>
+
 #include "Simulation.h"
+#include "Save.h"
 #include "PlaneWorldCollider.h"
 
 using sim::Simulation;
@@ -168,3 +173,621 @@ TEST(SimulationTest, EmptySimulationDoesNotCrash) {
     Simulation sim;
     EXPECT_NO_THROW(sim.step(1.0));
 }
+
+// --------------------------------------------------
+// Statistics
+// --------------------------------------------------
+
+TEST(SimulationTest, StepFillsStats) {
+    Simulation sim;
+    sim.addBody(makeSimpleBody(Vector2(0, 0)));
+
+    sim.step(0.01);
+    sim.step(0.01);
+
+    const auto& stats = sim.getStats();
+    EXPECT_EQ(stats.steps, 2);
+    EXPECT_GE(stats.step_ms, 0.0);
+    double sum = 0.0;
+    for (double t : stats.phase_ms) {
+        EXPECT_GE(t, 0.0);
+        sum += t;
+    }
+    EXPECT_LE(sum, stats.step_ms + 1e-6);
+}
+
+TEST(SimulationTest, StepHistogramRecordsEveryStep) {
+    Simulation sim;
+    sim.addBody(makeSimpleBody(Vector2(0, 0)));
+
+    for (int i = 0; i < 10; i++) sim.step(0.01);
+
+    EXPECT_EQ(sim.getStepHistogram().getCount(), 10u);
+    EXPECT_GE(sim.getStepHistogram().percentile(99.9), sim.getStepHistogram().percentile(50));
+}
+
+// --------------------------------------------------
+// Spike capture
+// --------------------------------------------------
+
+TEST(SimulationTest, SpikeSnapshotReplaysTheStep) {
+    std::string path = testing::TempDir() + "spike_snapshot.json";
+    std::remove(path.c_str());
+
+    Simulation sim;
+    sim.setGravity(Vector2(0, -10));
+    sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0, 0.3, 0.6));
+    sim.addBody(SoftBody::createFromPolygon({ Vector2(0, 1), Vector2(10, 1), Vector2(10, 11), Vector2(0, 11) }, 5));
+    Particle* p1 = new Particle(Vector2(20, 5));
+    Particle* p2 = new Particle(Vector2(24, 5));
+    sim.addBody(new SoftBody({p1, p2}, {new Constraint(p1, p2, 1.0, 0.0)}));
+
+    for (int i = 0; i < 5; i++) sim.step(0.01);
+
+    // Any step is a spike with this threshold
+    sim.setSpikeCapture(1e-9, path);
+    sim.step(0.01);
+    EXPECT_EQ(sim.getStats().spikes, 1u);
+
+    std::ifstream file(path);
+    ASSERT_TRUE(file.is_open());
+    json data;
+    file >> data;
+    EXPECT_DOUBLE_EQ(data["dt"].get<double>(), 0.01);
+
+    Simulation replay;
+    replay.from_json(data);
+    ASSERT_EQ(replay.getBodies().size(), sim.getBodies().size());
+    replay.step(data["dt"]);
+
+    for (size_t b = 0; b < sim.getBodies().size(); b++) {
+        auto expected = sim.getBodies()[b]->getParticles();
+        auto actual = replay.getBodies()[b]->getParticles();
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t i = 0; i < actual.size(); i++)
+            EXPECT_EQ(actual[i]->getPosition(), expected[i]->getPosition());
+    }
+}
+
+TEST(SimulationTest, SaveAndLoadRoundTrip) {
+    std::string path = testing::TempDir() + "simulation.json";
+
+    Simulation sim;
+    sim.setGravity(Vector2(0, -10));
+    sim.addCollider(new PlaneCollider(Vector2(0, 1), 2.0));
+    sim.addBody(SoftBody::createFromPolygon({ Vector2(0, 5), Vector2(100, 5), Vector2(50, 105) }, 5));
+    sim::saveSimulation(&sim, path);
+
+    Simulation loaded;
+    sim::loadSimulation(&loaded, path);
+
+    EXPECT_EQ(loaded.getGravity(), Vector2(0, -10));
+    ASSERT_EQ(loaded.getBodies().size(), 1);
+    ASSERT_EQ(loaded.getColliders().size(), 1);
+    EXPECT_EQ(loaded.getBodies()[0]->getParticles().size(), sim.getBodies()[0]->getParticles().size());
+}
+
+// --------------------------------------------------
+// Particle storage sorting
+// --------------------------------------------------
+
+static std::vector<Vector2> squareAt(Vector2 origin, double side) {
+    return { origin, origin + Vector2(side, 0), origin + Vector2(side, side), origin + Vector2(0, side) };
+}
+
+TEST(SimulationTest, StepStatsCountTheScene) {
+    Simulation sim;
+    sim.setGravity(Vector2(0, -10));
+    sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+    sim.addBody(SoftBody::createFromPolygon(squareAt(Vector2(0, 1), 10), 2, 1.0, 0.6, 0.8, 0.1, 0.5, 0.2));
+    sim.addBody(SoftBody::createFromPolygon(squareAt(Vector2(0, 12), 10), 2, 1.0, 0.6, 0.8, 0.1, 0.5, 0.2));
+    size_t particles = 0, constraints = 0;
+    for (auto b : sim.getBodies()) {
+        particles += b->getParticles().size();
+        constraints += b->getConstraints().size();
+    }
+
+    // Falling bodies do not rest
+    sim.step(0.01);
+    sim.step(0.01);
+    const auto& stats = sim.getStats();
+    EXPECT_EQ(stats.bodies, 2u);
+    EXPECT_EQ(stats.particles, particles);
+    EXPECT_EQ(stats.constraints, constraints);
+    EXPECT_EQ(stats.resting_bodies, 0u);
+
+    // Once stacked, the bodies touch and settle
+    for (int i = 0; i < 1500; i++) sim.step(0.01);
+    EXPECT_GT(stats.body_contacts, 0u);
+    EXPECT_EQ(stats.resting_bodies, 2u);
+}
+
+TEST(SimulationTest, SortParticlesKeepsBodiesValid) {
+    Simulation sim;
+    sim.addBody(SoftBody::createFromPolygon(squareAt(Vector2(0, 0), 40), 10));
+    sim.addBody(SoftBody::createFromPolygon(squareAt(Vector2(20, 20), 40), 10));
+
+    std::vector<std::vector<Vector2>> before;
+    for (auto b : sim.getBodies()) {
+        before.push_back({});
+        for (auto p : b->getParticles()) before.back().push_back(p->getPosition());
+    }
+
+    sim.sortParticles();
+    // A body added after a sort is merged by the next one
+    sim.addBody(SoftBody::createFromPolygon(squareAt(Vector2(-30, 0), 20), 10));
+    sim.sortParticles();
+    EXPECT_EQ(sim.getStats().sorts, 2u);
+
+    size_t total = 0;
+    const Particle* lo = nullptr;
+    const Particle* hi = nullptr;
+    for (size_t i = 0; i < sim.getBodies().size(); i++) {
+        SoftBody* b = sim.getBodies()[i];
+        auto particles = b->getParticles();
+        std::set<Particle*> own(particles.begin(), particles.end());
+        if (i < before.size()) {
+            ASSERT_EQ(particles.size(), before[i].size());
+            for (size_t j = 0; j < particles.size(); j++)
+                EXPECT_EQ(particles[j]->getPosition(), before[i][j]);
+        }
+        for (auto c : b->getConstraints()) {
+            EXPECT_TRUE(own.count(c->getParticle1()));
+            EXPECT_TRUE(own.count(c->getParticle2()));
+        }
+        for (auto p : b->getBorder()) EXPECT_TRUE(own.count(p));
+        for (auto p : particles) {
+            if (!lo || std::less<const Particle*>()(p, lo)) lo = p;
+            if (!hi || std::less<const Particle*>()(hi, p)) hi = p;
+        }
+        total += particles.size();
+    }
+    // Every particle now lives in a single array
+    EXPECT_EQ(size_t(hi - lo) + 1, total);
+}
+
+TEST(SimulationTest, PeriodicSortDoesNotChangeTheResult) {
+    Simulation plain, sorted;
+    for (auto* s : { &plain, &sorted }) {
+        s->setGravity(Vector2(0, -10));
+        s->addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+        s->addBody(SoftBody::createFromPolygon(squareAt(Vector2(0, 5), 30), 10));
+        s->addBody(SoftBody::createFromPolygon(squareAt(Vector2(10, 40), 30), 10));
+    }
+    sorted.setSortInterval(3);
+
+    for (int i = 0; i < 30; i++) {
+        plain.step(0.01);
+        sorted.step(0.01);
+    }
+    EXPECT_EQ(sorted.getStats().sorts, 10u);
+    EXPECT_GE(sorted.getStats().amortizedSortMs(), 0.0);
+    for (size_t b = 0; b < plain.getBodies().size(); b++) {
+        auto a = plain.getBodies()[b]->getParticles();
+        auto c = sorted.getBodies()[b]->getParticles();
+        ASSERT_EQ(a.size(), c.size());
+        for (size_t i = 0; i < a.size(); i++) {
+            EXPECT_DOUBLE_EQ(a[i]->getPosition().x, c[i]->getPosition().x);
+            EXPECT_DOUBLE_EQ(a[i]->getPosition().y, c[i]->getPosition().y);
+        }
+    }
+}
+
+TEST(SimulationTest, WorldCollidersOutOfReachAreSkipped) {
+    Simulation sim;
+    sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0));     // floor, under the body
+    sim.addCollider(new PlaneCollider(Vector2(0, -1), -100.0)); // ceiling, far above
+    sim.addBody(makeSimpleBody(Vector2(0, 0.5)));
+
+    sim.step(0.01);
+
+    // Two world passes, two colliders: only the floor is tested
+    EXPECT_EQ(sim.getStats().world_pairs, 4u);
+    EXPECT_EQ(sim.getStats().world_pairs_skipped, 2u);
+    EXPECT_GE(sim.getBodies()[0]->getParticles()[0]->getPosition().y, 1.0 - 1e-9);
+}
+
+// A user extension: must keep going through the virtual collide()
+class CountingPlane : public PlaneCollider {
+public:
+    using PlaneCollider::PlaneCollider;
+    bool collide(Particle* p, double friction, double restitution) override {
+        calls++;
+        return PlaneCollider::collide(p, friction, restitution);
+    }
+    int calls = 0;
+};
+
+TEST(SimulationTest, DerivedCollidersUseTheVirtualPath) {
+    Simulation sim;
+    CountingPlane* plane = new CountingPlane(Vector2(0, 1), 0.0);
+    sim.addCollider(plane);
+    sim.addCollider(new sim::OuterCircleCollider(Vector2(0, -5), 5.0));
+    sim.addBody(makeSimpleBody(Vector2(0, 0.5)));
+
+    sim.step(0.01);
+
+    EXPECT_EQ(plane->calls, 2);     // one particle, two world passes
+    EXPECT_GE(sim.getBodies()[0]->getParticles()[0]->getPosition().y, 1.0 - 1e-9);
+}
+
+TEST(SimulationTest, SegmentMeshHoldsABody) {
+    Simulation sim;
+    sim.setGravity(Vector2(0, -9.81));
+    sim.addCollider(new sim::SegmentMeshCollider(sim::SegmentMeshCollider::polyline(
+        { Vector2(-20, 0), Vector2(0, -2), Vector2(20, 0) })));
+    sim.addBody(SoftBody::createFromPolygon(squareAt(Vector2(-2, 2), 4), 1, 1.0, 0.5));
+
+    for (int i = 0; i < 300; i++) sim.step(0.01);
+
+    for (auto p : sim.getBodies()[0]->getParticles())
+        EXPECT_GT(p->getPosition().y, -2.0);
+}
+
+TEST(SimulationTest, ContinuousCollisionsStopTunnelling) {
+    for (bool continuous : { false, true }) {
+        Simulation sim;
+        sim.setContinuousCollisions(continuous);
+        sim.addCollider(new sim::SegmentMeshCollider({ { Vector2(-10, 0), Vector2(10, 0) } }));
+        SoftBody* body = makeSimpleBody(Vector2(0, 3), 0.5);
+        body->getParticles()[0]->setPrevPosition(Vector2(0, 7)); // 4 units per step
+        sim.addBody(body);
+
+        for (int i = 0; i < 3; i++) sim.step(0.01);
+
+        double y = sim.getBodies()[0]->getParticles()[0]->getPosition().y;
+        if (continuous) EXPECT_GT(y, 0.0);
+        else EXPECT_LT(y, 0.0);
+    }
+}
+
+// Six soft squares stacked in a box
+static void buildStack(Simulation& sim) {
+    sim.setGravity(Vector2(0, -10));
+    sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+    sim.addCollider(new PlaneCollider(Vector2(1, 0), -0.7));
+    sim.addCollider(new PlaneCollider(Vector2(-1, 0), -10.7));
+    for (int k = 0; k < 6; k++)
+        sim.addBody(SoftBody::createFromPolygon(squareAt(Vector2(0, 1 + k * 12), 10), 2, 1.0, 0.6, 0.8, 0.1, 0.5, 0.2));
+}
+
+static double stackSinking(Simulation& sim) {
+    auto bodies = sim.getBodies();
+    double sinking = 0.0;
+    for (size_t k = 1; k < bodies.size(); k++)
+        sinking += sim::computeAABB(bodies[k - 1]->getParticles()).max.y - sim::computeAABB(bodies[k]->getParticles()).min.y;
+    return sinking / (bodies.size() - 1);
+}
+
+TEST(SimulationTest, ContactCacheWithoutWarmStartMatchesTheNarrowphase) {
+    Simulation a, b;
+    buildStack(a);
+    buildStack(b);
+    b.setContactCache(true);
+    b.setWarmStart(0.0);
+
+    for (int i = 0; i < 600; i++) {
+        a.step(1.0 / 60);
+        b.step(1.0 / 60);
+    }
+    EXPECT_GT(b.getStats().manifolds_reused, 0u);
+    for (size_t i = 0; i < a.getBodies().size(); i++) {
+        auto& pa = a.getBodies()[i]->getParticles();
+        auto& pb = b.getBodies()[i]->getParticles();
+        for (size_t k = 0; k < pa.size(); k++)
+            EXPECT_EQ(pa[k]->getPosition(), pb[k]->getPosition());
+    }
+}
+
+TEST(SimulationTest, WarmStartReducesStackSinking) {
+    Simulation cold, warm;
+    buildStack(cold);
+    buildStack(warm);
+    warm.setContactCache(true);
+    warm.setWarmStart(0.5);
+
+    for (int i = 0; i < 1200; i++) {
+        cold.step(1.0 / 60);
+        warm.step(1.0 / 60);
+    }
+    EXPECT_LT(stackSinking(warm), 0.75 * stackSinking(cold));
+}
+
+TEST(SimulationTest, ContactCacheSurvivesSorting) {
+    Simulation a, b;
+    buildStack(a);
+    buildStack(b);
+    a.setContactCache(true);
+    b.setContactCache(true);
+    b.setSortInterval(7);
+
+    for (int i = 0; i < 300; i++) {
+        a.step(1.0 / 60);
+        b.step(1.0 / 60);
+    }
+    for (size_t i = 0; i < a.getBodies().size(); i++) {
+        auto& pa = a.getBodies()[i]->getParticles();
+        auto& pb = b.getBodies()[i]->getParticles();
+        for (size_t k = 0; k < pa.size(); k++)
+            EXPECT_EQ(pa[k]->getPosition(), pb[k]->getPosition());
+    }
+}
+
+TEST(SimulationTest, ContactPipelineSeparatesBodies) {
+    Simulation sim;
+    sim.setContactPipeline(true);
+    sim.addBody(makeSimpleBody(Vector2(0, 0)));
+    sim.addBody(makeSimpleBody(Vector2(1.5, 0)));
+
+    sim.step(0.01);
+
+    double dist = (sim.getBodies()[0]->getParticles()[0]->getPosition()
+                 - sim.getBodies()[1]->getParticles()[0]->getPosition()).length();
+    EXPECT_GE(dist, 2.0 - 1e-9);
+    EXPECT_EQ(sim.getStats().contacts, 1u);
+    EXPECT_EQ(sim.getStats().contact_colors, 1u);
+    EXPECT_EQ(sim.getStats().body_contacts, 1u);
+}
+
+TEST(SimulationTest, ContactPipelineDoesNotDependOnThreads) {
+    for (bool cached : { false, true }) {
+        Simulation serial, parallel;
+        buildStack(serial);
+        buildStack(parallel);
+        for (Simulation* sim : { &serial, &parallel }) {
+            sim->setContactPipeline(true);
+            sim->setContactCache(cached);
+        }
+        parallel.setThreadCount(4);
+        EXPECT_EQ(parallel.getThreadCount(), 4);
+
+        for (int i = 0; i < 400; i++) {
+            serial.step(1.0 / 60);
+            parallel.step(1.0 / 60);
+        }
+        EXPECT_GT(parallel.getStats().contacts, 0u);
+        EXPECT_EQ(parallel.getStats().contacts, serial.getStats().contacts);
+        EXPECT_EQ(parallel.getStats().body_contacts, serial.getStats().body_contacts);
+        // Only resolved contacts count, not the skin pairs of the cached manifolds
+        if (cached) {
+            EXPECT_LT(parallel.getStats().body_contacts, parallel.getStats().contacts);
+        }
+        for (size_t i = 0; i < serial.getBodies().size(); i++) {
+            auto& ps = serial.getBodies()[i]->getParticles();
+            auto& pp = parallel.getBodies()[i]->getParticles();
+            for (size_t k = 0; k < ps.size(); k++)
+                EXPECT_EQ(ps[k]->getPosition(), pp[k]->getPosition());
+        }
+        // Stacked bodies keep their order
+        EXPECT_LT(stackSinking(parallel), 1.2);
+    }
+}
+
+TEST(SimulationTest, WorldClearanceKeepsTheResult) {
+    for (bool continuous : { false, true }) {
+        Simulation full, skipping;
+        for (Simulation* sim : { &full, &skipping }) {
+            sim->setGravity(Vector2(0, -10));
+            sim->setContinuousCollisions(continuous);
+            sim->addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+            sim->addCollider(new sim::OuterCircleCollider(Vector2(30, 5), 3.0));
+            sim->addCollider(new sim::SegmentMeshCollider({ { Vector2(-20, 12), Vector2(0, 8) } }));
+            for (int k = 0; k < 4; k++)
+                sim->addBody(SoftBody::createFromPolygon(squareAt(Vector2(-15 + k * 12, 20 + k * 6), 8), 2, 1.0, 0.6));
+        }
+        skipping.setWorldClearance(true);
+
+        unsigned long long skipped = 0;
+        for (int i = 0; i < 300; i++) {
+            full.step(1.0 / 60);
+            skipping.step(1.0 / 60);
+            skipped += skipping.getStats().world_particles_skipped;
+        }
+        EXPECT_GT(skipped, 0u);
+        EXPECT_EQ(full.getStats().world_particles_skipped, 0u);
+        for (size_t i = 0; i < full.getBodies().size(); i++) {
+            auto& pf = full.getBodies()[i]->getParticles();
+            auto& ps = skipping.getBodies()[i]->getParticles();
+            for (size_t k = 0; k < pf.size(); k++)
+                EXPECT_EQ(pf[k]->getPosition(), ps[k]->getPosition());
+        }
+    }
+}
+
+TEST(SimulationTest, WorldClearanceSeesNewColliders) {
+    Simulation sim;
+    sim.setWorldClearance(true);
+    sim.addBody(makeSimpleBody(Vector2(0, 0.5)));
+    sim.step(0.01);
+    EXPECT_EQ(sim.getStats().world_particles_skipped, 1u); // Clear once the first pass found no collider
+
+    // Added after the particle got its bound, must still push it out
+    sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+    sim.step(0.01);
+    EXPECT_GE(sim.getBodies()[0]->getParticles()[0]->getPosition().y, 1.0 - 1e-9);
+}
+
+TEST(SimulationTest, SurfaceCollisionsOnlyTestTheOutline) {
+    unsigned long long tested[2];
+    double sinking[2];
+    for (bool surface : { false, true }) {
+        Simulation sim;
+        sim.setSurfaceCollisions(surface);
+        EXPECT_EQ(sim.getSurfaceCollisions(), surface);
+        buildStack(sim);
+        for (int i = 0; i < 300; i++) sim.step(1.0 / 60);
+        tested[surface] = sim.getStats().collision_particles;
+        sinking[surface] = stackSinking(sim);
+        EXPECT_EQ(sim.getStats().surface_fallbacks, 0u);
+    }
+    EXPECT_LT(tested[true], tested[false]);
+    EXPECT_LT(sinking[true], 1.2);
+    EXPECT_NEAR(sinking[true], sinking[false], 0.5);
+}
+
+TEST(SimulationTest, FoldedBodyCollidesEveryParticle) {
+    Simulation sim;
+    sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+    // Without stiffness, constraints do not pull the particle back before the collisions
+    SoftBody* body = SoftBody::createFromPolygon(squareAt(Vector2(0, 2), 10), 2, 1.0, 0.6, 0.0, 0.0);
+    sim.addBody(body);
+
+    // An interior particle pushed through the floor below the surface
+    std::set<Particle*> surface(body->getSurface().begin(), body->getSurface().end());
+    Particle* inner = nullptr;
+    for (auto p : body->getParticles())
+        if (!surface.count(p)) inner = p;
+    ASSERT_NE(inner, nullptr);
+    inner->setPosition(Vector2(5, -1));
+    inner->setPrevPosition(Vector2(5, -1));
+
+    sim.step(0.001);
+    EXPECT_EQ(sim.getStats().surface_fallbacks, 1u);
+    EXPECT_EQ(sim.getStats().collision_particles, body->getParticles().size());
+    EXPECT_GE(inner->getPosition().y, 0.6 - 1e-9);
+}
+
+// Convex polygon sampled at its corners only, the outline is made of long edges
+static SoftBody* coarsePolygon(const std::vector<Vector2>& corners) {
+    sim::MeshData mesh;
+    mesh.points = corners;
+    int n = corners.size();
+    for (int i = 0; i < n; i++) {
+        mesh.border.push_back(i);
+        mesh.surface.push_back(i);
+        for (int j = i + 1; j < n; j++) mesh.edges.push_back({ i, j });
+    }
+    return SoftBody::createFromMesh(mesh, 10, 1.0, 0.5);
+}
+
+static SoftBody* coarseSquare(Vector2 origin) {
+    return coarsePolygon({ origin, origin + Vector2(10, 0), origin + Vector2(10, 10), origin + Vector2(0, 10) });
+}
+
+TEST(SimulationTest, EdgeContactsCatchParticlesBetweenOutlineParticles) {
+    double gap[2];
+    for (bool edges : { false, true }) {
+        Simulation sim;
+        sim.setEdgeContacts(edges);
+        EXPECT_EQ(sim.getEdgeContacts(), edges);
+        SoftBody* base = coarseSquare(Vector2(0, 0));
+        EXPECT_TRUE(base->hasOutline());
+        // A wedge pressing its tip in the middle of the top edge, far from the outline particles
+        SoftBody* top = coarsePolygon({ Vector2(5, 9.5), Vector2(8, 14), Vector2(2, 14) });
+        sim.addBody(base);
+        sim.addBody(top);
+        sim.step(0.001);
+        gap[edges] = top->getParticles()[0]->getPosition().y - base->getParticles()[3]->getPosition().y;
+        EXPECT_EQ(sim.getStats().edge_contacts > 0, edges);
+    }
+    EXPECT_NEAR(gap[false], -0.5, 1e-9);
+    EXPECT_GE(gap[true], 1.0 - 1e-6);
+}
+
+TEST(SimulationTest, EdgeContactsKeepParticleContactsOfBodiesWithoutOutline) {
+    Simulation sim;
+    sim.setEdgeContacts(true);
+    SoftBody* b1 = makeSimpleBody(Vector2(0, 0));
+    SoftBody* b2 = makeSimpleBody(Vector2(1, 0));
+    EXPECT_FALSE(b1->hasOutline());
+    sim.addBody(b1);
+    sim.addBody(b2);
+    sim.step(0.001);
+    EXPECT_GE(b2->getParticles()[0]->getPosition().x - b1->getParticles()[0]->getPosition().x, 2.0 - 1e-9);
+    EXPECT_EQ(sim.getStats().edge_contacts, 0u);
+}
+
+TEST(SimulationTest, EdgeContactsHoldAStackOfCoarseBodies) {
+    Simulation sim;
+    sim.setEdgeContacts(true);
+    sim.setGravity(Vector2(0, -9.81));
+    sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+    // Each box offset by half a side, its lower corners land mid-edge on the one below
+    std::vector<SoftBody*> stack;
+    for (int i = 0; i < 3; i++) {
+        stack.push_back(coarseSquare(Vector2(5.0 * i, 0.5 + 11.0 * i)));
+        sim.addBody(stack.back());
+    }
+    for (int i = 0; i < 300; i++) sim.step(1.0 / 60);
+    for (int i = 1; i < 3; i++) {
+        double lower_top = stack[i - 1]->getParticles()[3]->getPosition().y;
+        double corner = stack[i]->getParticles()[0]->getPosition().y;
+        EXPECT_GT(corner, lower_top);
+    }
+}
+
+TEST(SimulationTest, SphereTreesKeepTheStackStanding) {
+    for (bool pipeline : { false, true }) {
+        Simulation plain, spheres;
+        buildStack(plain);
+        buildStack(spheres);
+        plain.setContactPipeline(pipeline);
+        spheres.setContactPipeline(pipeline);
+        spheres.setSphereTrees(true);
+        EXPECT_TRUE(spheres.getSphereTrees());
+        for (int i = 0; i < 300; i++) {
+            plain.step(1.0 / 60);
+            spheres.step(1.0 / 60);
+        }
+        EXPECT_GT(spheres.getStats().sphere_leaf_pairs, 0u);
+        EXPECT_GT(spheres.getStats().sphere_refit_ms, 0.0);
+        EXPECT_EQ(plain.getStats().sphere_leaf_pairs, 0u);
+        EXPECT_LT(stackSinking(spheres), 1.2);
+        EXPECT_NEAR(stackSinking(spheres), stackSinking(plain), 0.5);
+    }
+}
+
+TEST(SimulationTest, MaskedBodiesPassThroughEachOther) {
+    Simulation sim;
+    SoftBody* b1 = makeSimpleBody(Vector2(0, 0));
+    SoftBody* b2 = makeSimpleBody(Vector2(1, 0));
+    b2->setCollisionLayer(2);
+    b2->setCollisionMask(2);
+    sim.addBody(b1);
+    sim.addBody(b2);
+    for (bool pipeline : { false, true }) {
+        sim.setContactPipeline(pipeline);
+        sim.step(0.001);
+        EXPECT_EQ(b2->getParticles()[0]->getPosition(), Vector2(1, 0));
+        EXPECT_EQ(sim.getStats().masked_pairs, 1u);
+    }
+}
+
+TEST(SimulationTest, MaskedColliderLetsTheBodyThrough) {
+    for (bool clearance : { false, true }) {
+        Simulation sim;
+        sim.setWorldClearance(clearance);
+        PlaneCollider* floor = new PlaneCollider(Vector2(0, 1), 0.0);
+        floor->setCollisionMask(2);
+        sim.addCollider(floor);
+        sim.addCollider(new PlaneCollider(Vector2(0, 1), -5.0));
+        SoftBody* body = makeSimpleBody(Vector2(0, 0.5));
+        sim.addBody(body);
+        sim.step(0.001);
+        EXPECT_EQ(body->getParticles()[0]->getPosition(), Vector2(0, 0.5));
+        EXPECT_EQ(sim.getStats().masked_pairs, 2u); // Once per world pass
+
+        // Unmasked again, the clearance bound still covers it
+        floor->setCollisionMask(1);
+        sim.step(0.001);
+        EXPECT_GE(body->getParticles()[0]->getPosition().y, 1.0 - 1e-9);
+    }
+}
+
+TEST(SimulationTest, CollisionLayersSurviveSaving) {
+    Simulation sim;
+    auto proto = sim::SoftBodyPrototype::createFromPolygon(squareAt(Vector2(0, 0), 10), 5);
+    SoftBody* instance = SoftBody::instantiate(proto, Vector2(20, 0));
+    instance->setCollisionLayer(8);
+    instance->setCollisionMask(3);
+    sim.addBody(instance);
+    PlaneCollider* floor = new PlaneCollider(Vector2(0, 1), 0.0);
+    floor->setCollisionMask(8);
+    sim.addCollider(floor);
+
+    Simulation loaded;
+    loaded.from_json(sim.as_json());
+    EXPECT_EQ(loaded.getBodies()[0]->getCollisionLayer(), 8u);
+    EXPECT_EQ(loaded.getBodies()[0]->getCollisionMask(), 3u);
+    EXPECT_EQ(loaded.getColliders()[0]->getCollisionMask(), 8u);
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "PlaneWorldCollider.h"
+#include "SimulationWorker.h"
+
+using sim::PlaneCollider;
+using sim::Simulation;
+using sim::SimulationSnapshot;
+using sim::SimulationWorker;
+using sim::SoftBody;
+using sim::Vector2;
+
+static void buildScene(Simulation& sim) {
+    sim.setGravity(Vector2(0, -10));
+    sim.addCollider(new PlaneCollider(Vector2(0, 1), 0.0));
+    for (int k = 0; k < 3; k++) {
+        Vector2 o(0, 1 + k * 12);
+        sim.addBody(SoftBody::createFromPolygon({ o, o + Vector2(10, 0), o + Vector2(10, 10), o + Vector2(0, 10) }, 2));
+    }
+}
+
+static std::vector<Vector2> borders(Simulation& sim) {
+    std::vector<Vector2> out;
+    for (auto body : sim.getBodies())
+        for (auto p : body->getBorder()) out.push_back(p->getPosition());
+    return out;
+}
+
+static void expectSameBorders(const SimulationSnapshot& snapshot, const std::vector<Vector2>& expected) {
+    ASSERT_EQ(snapshot.borders.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_EQ(snapshot.borders[i].x, expected[i].x);
+        EXPECT_EQ(snapshot.borders[i].y, expected[i].y);
+    }
+}
+
+TEST(SimulationWorkerTest, StepsLikeTheCallingThread) {
+    Simulation serial, threaded;
+    buildScene(serial);
+    buildScene(threaded);
+
+    SimulationWorker worker(threaded);
+    expectSameBorders(worker.latest(), borders(serial));
+    EXPECT_EQ(worker.latest().step, 0u);
+
+    for (int i = 0; i < 50; i++) {
+        serial.step(0.01);
+        ASSERT_TRUE(worker.request(0.01));
+        worker.wait();
+    }
+    EXPECT_EQ(worker.getCompleted(), 50u);
+    EXPECT_EQ(worker.getLag(), 0u);
+    const SimulationSnapshot& snapshot = worker.latest();
+    EXPECT_EQ(snapshot.step, 50u);
+    EXPECT_EQ(snapshot.stats.steps, serial.getStats().steps);
+    ASSERT_EQ(snapshot.border_offsets.size(), 4u);
+    EXPECT_EQ(snapshot.border_offsets.back(), snapshot.borders.size());
+    expectSameBorders(snapshot, borders(serial));
+}
+
+TEST(SimulationWorkerTest, LagIsBounded) {
+    Simulation sim;
+    buildScene(sim);
+    SimulationWorker worker(sim);
+    worker.setMaxLag(2);
+
+    int accepted = 0;
+    for (int i = 0; i < 100; i++) {
+        if (worker.request(0.01)) accepted++;
+        EXPECT_LE(worker.getLag(), 2u);
+    }
+    EXPECT_EQ(accepted + (int)worker.getDropped(), 100);
+    worker.wait();
+    EXPECT_EQ(worker.getLag(), 0u);
+    EXPECT_EQ(worker.getCompleted(), (uint64_t)accepted);
+    EXPECT_EQ(worker.latest().step, (uint64_t)accepted);
+}
+
+TEST(SimulationWorkerTest, ReaderSeesCompleteSnapshots) {
+    Simulation sim;
+    buildScene(sim);
+    size_t border_count = borders(sim).size();
+    SimulationWorker worker(sim);
+    worker.setMaxLag(4);
+
+    // Read continuously while the worker publishes
+    std::atomic<bool> done{false};
+    std::thread producer([&] {
+        for (int i = 0; i < 200; i++) {
+            while (!worker.request(0.01)) std::this_thread::yield();
+        }
+        worker.wait();
+        done = true;
+    });
+    uint64_t last = 0;
+    while (!done) {
+        const SimulationSnapshot& snapshot = worker.latest();
+        EXPECT_GE(snapshot.step, last);
+        last = snapshot.step;
+        ASSERT_EQ(snapshot.borders.size(), border_count);
+        ASSERT_EQ(snapshot.border_offsets.size(), 4u);
+    }
+    producer.join();
+    EXPECT_EQ(worker.latest().step, 200u);
+}
+
+TEST(SimulationWorkerTest, DetailCapturesParticlesAndConstraints) {
+    Simulation sim;
+    buildScene(sim);
+    SimulationWorker worker(sim);
+    EXPECT_TRUE(worker.latest().particles.empty());
+
+    worker.setDetail(true);
+    worker.request(0.01);
+    worker.wait();
+    const SimulationSnapshot& snapshot = worker.latest();
+    size_t particles = 0, lines = 0;
+    for (auto body : sim.getBodies()) {
+        particles += body->getParticles().size();
+        lines += body->getConstraints().size();
+    }
+    EXPECT_EQ(snapshot.particles.size(), particles);
+    EXPECT_EQ(snapshot.radii.size(), particles);
+    EXPECT_EQ(snapshot.particle_offsets.back(), particles);
+    EXPECT_EQ(snapshot.lines.size(), 2 * lines);
+    EXPECT_EQ(snapshot.border_radii.size(), snapshot.borders.size());
+}
+
+TEST(SimulationWorkerTest, MeasuresItsUtilization) {
+    Simulation sim;
+    buildScene(sim);
+    SimulationWorker worker(sim);
+    worker.takeUtilization();
+
+    for (int i = 0; i < 20; i++) {
+        worker.request(0.01);
+        worker.wait();
+    }
+    double busy = worker.takeUtilization();
+    EXPECT_GT(busy, 0.0);
+    EXPECT_LE(busy, 1.0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(worker.takeUtilization(), 0.0);
+}
@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <set>
+
 #include "SoftBody.h"
 
 using sim::SoftBody;
@@ -167,3 +171,292 @@ TEST(SoftBodyFactoryTest, AllBorderParticlesMatchPolygon) {
     for (auto c: body->getConstraints()) delete c;
     delete body;
 }
+
+TEST(SoftBodyFactoryTest, SmallPolygonDoesNotCrash) {
+    std::vector<Vector2> triangle = { Vector2(0, 5), Vector2(10, 5), Vector2(5, 15) };
+
+    SoftBody* body = SoftBody::createFromPolygon(triangle, 5);
+
+    ASSERT_NE(body, nullptr);
+    EXPECT_EQ(body->getBorder().size(), triangle.size());
+
+    for (auto p: body->getParticles()) delete p;
+    for (auto c: body->getConstraints()) delete c;
+    delete body;
+}
+
+TEST(SoftBodyFactoryTest, LargePolygonHasNoDuplicateParticles) {
+    // 2000 vertices with unit edges
+    const int n = 2000;
+    double R = 0.5 / std::sin(M_PI / n);
+    std::vector<Vector2> circle;
+    for (int i = 0; i < n; i++)
+        circle.push_back(Vector2(std::cos(2 * M_PI * i / n), std::sin(2 * M_PI * i / n)) * R);
+
+    SoftBody* body = SoftBody::createFromPolygon(circle, 10, 1.0, 1.0);
+    auto particles = body->getParticles();
+
+    EXPECT_GE(particles.size(), (size_t)n);
+    int duplicates = 0;
+    for (size_t i = 0; i < particles.size(); i++)
+        for (size_t j = i + 1; j < particles.size(); j++)
+            if ((particles[i]->getPosition() - particles[j]->getPosition()).length() < 0.5) duplicates++;
+    EXPECT_EQ(duplicates, 0);
+
+    for (auto p: particles) delete p;
+    for (auto c: body->getConstraints()) delete c;
+    delete body;
+}
+
+// --------------------------------------------------
+// Lattice mesher
+// --------------------------------------------------
+
+TEST(SoftBodyFactoryTest, LatticeFillsSquareRegularly) {
+    std::vector<Vector2> square = { Vector2(0, 0), Vector2(100, 0), Vector2(100, 100), Vector2(0, 100) };
+
+    SoftBody* body = SoftBody::createFromPolygon(square, 10, 1.0, 1.0, 0.8, 0.1, 0.1, 0.9, false, sim::LatticeMesh);
+
+    // 400 border samples plus a lattice of roughly area / (spacing^2 * sqrt(3)/2) points
+    size_t interior = body->getParticles().size() - 400;
+    EXPECT_GT(interior, 80u);
+    EXPECT_LT(interior, 116u);
+    EXPECT_EQ(body->getMeshType(), sim::LatticeMesh);
+    EXPECT_EQ(body->getBorder().size(), square.size());
+
+    std::set<Particle*> linked;
+    for (auto c : body->getConstraints()) {
+        linked.insert(c->getParticle1());
+        linked.insert(c->getParticle2());
+    }
+    EXPECT_EQ(linked.size(), body->getParticles().size());
+
+    for (auto p: body->getParticles()) delete p;
+    for (auto c: body->getConstraints()) delete c;
+    delete body;
+}
+
+TEST(SoftBodyFactoryTest, LatticeRespectsConcavePolygon) {
+    // L shape: the square [50,100]x[50,100] is outside
+    std::vector<Vector2> shape = {
+        Vector2(0, 0), Vector2(100, 0), Vector2(100, 50),
+        Vector2(50, 50), Vector2(50, 100), Vector2(0, 100)
+    };
+
+    SoftBody* body = SoftBody::createFromPolygon(shape, 10, 1.0, 1.0, 0.8, 0.1, 0.1, 0.9, false, sim::LatticeMesh);
+
+    for (auto p : body->getParticles()) {
+        Vector2 pos = p->getPosition();
+        EXPECT_FALSE(pos.x > 50.5 && pos.y > 50.5) << pos;
+    }
+
+    for (auto p: body->getParticles()) delete p;
+    for (auto c: body->getConstraints()) delete c;
+    delete body;
+}
+
+TEST(PointInPolygonTest, ConcavePolygon) {
+    std::vector<Vector2> shape = {
+        Vector2(0, 0), Vector2(100, 0), Vector2(100, 50),
+        Vector2(50, 50), Vector2(50, 100), Vector2(0, 100)
+    };
+    EXPECT_TRUE(sim::pointInPolygon(Vector2(25, 75), shape));
+    EXPECT_TRUE(sim::pointInPolygon(Vector2(75, 25), shape));
+    EXPECT_FALSE(sim::pointInPolygon(Vector2(75, 75), shape)); // In the notch, inside the bounds
+    EXPECT_FALSE(sim::pointInPolygon(Vector2(-1, 50), shape));
+    EXPECT_FALSE(sim::pointInPolygon(Vector2(25, 75), std::vector<Vector2>{ Vector2(0, 0), Vector2(100, 100) }));
+
+    // Same answer on particles, through their position
+    std::vector<Particle> corners(shape.begin(), shape.end());
+    std::vector<const Particle*> ring;
+    for (auto& c : corners) ring.push_back(&c);
+    auto position = [](const Particle* p) -> const Vector2& { return p->getPosition(); };
+    EXPECT_TRUE(sim::pointInPolygon(Vector2(25, 75), ring, position));
+    EXPECT_FALSE(sim::pointInPolygon(Vector2(75, 75), ring, position));
+}
+
+TEST(SoftBodyFactoryTest, LatticeHandlesPolygonThinnerThanSpacing) {
+    std::vector<Vector2> sliver = { Vector2(0, 0), Vector2(40, 0), Vector2(40, 3), Vector2(0, 3) };
+
+    SoftBody* body = SoftBody::createFromPolygon(sliver, 10, 1.0, 1.0, 0.8, 0.1, 0.1, 0.9, false, sim::LatticeMesh);
+
+    EXPECT_FALSE(body->getConstraints().empty());
+
+    for (auto p: body->getParticles()) delete p;
+    for (auto c: body->getConstraints()) delete c;
+    delete body;
+}
+
+TEST(SoftBodyFactoryTest, ReorderIsAPermutationIndependentOfInputOrder) {
+    std::vector<Vector2> shape = { Vector2(0, 0), Vector2(80, 0), Vector2(80, 60), Vector2(0, 60) };
+    sim::MeshData mesh = sim::meshPolygon(shape, 10, 1.0);
+
+    // Shuffle the points and edges, then reorder both meshes
+    sim::MeshData shuffled = mesh;
+    int n = (int)mesh.points.size();
+    std::vector<int> perm(n);
+    for (int i = 0; i < n; i++) perm[i] = n - 1 - i;
+    for (int i = 0; i < n; i++) shuffled.points[perm[i]] = mesh.points[i];
+    for (auto& e : shuffled.edges) e = { perm[e.first], perm[e.second] };
+    std::reverse(shuffled.edges.begin(), shuffled.edges.end());
+    for (auto& b : shuffled.border) b = perm[b];
+    for (auto& s : shuffled.surface) s = perm[s];
+
+    sim::reorderMesh(mesh, 10);
+    sim::reorderMesh(shuffled, 10);
+
+    ASSERT_EQ(mesh.points.size(), shuffled.points.size());
+    for (size_t i = 0; i < mesh.points.size(); i++)
+        EXPECT_EQ(mesh.points[i], shuffled.points[i]);
+    EXPECT_EQ(mesh.edges, shuffled.edges);
+    EXPECT_EQ(mesh.border, shuffled.border);
+    EXPECT_EQ(mesh.surface, shuffled.surface);
+    EXPECT_TRUE(std::is_sorted(mesh.edges.begin(), mesh.edges.end()));
+    for (auto& e : mesh.edges) EXPECT_LT(e.first, e.second);
+}
+
+TEST(SoftBodyFactoryTest, ReorderKeepsTheShape) {
+    std::vector<Vector2> shape = { Vector2(0, 0), Vector2(80, 0), Vector2(80, 60), Vector2(0, 60) };
+    SoftBody* plain = SoftBody::createFromPolygon(shape, 10);
+    SoftBody* sorted = SoftBody::createFromPolygon(shape, 10, 1.0, 1.0, 0.8, 0.1, 0.1, 0.9, false, sim::RingMesh, true);
+
+    ASSERT_EQ(plain->getParticles().size(), sorted->getParticles().size());
+    ASSERT_EQ(plain->getConstraints().size(), sorted->getConstraints().size());
+    EXPECT_TRUE(sorted->isReordered());
+    for (size_t i = 0; i < shape.size(); i++)
+        EXPECT_EQ(sorted->getBorder()[i]->getPosition(), plain->getBorder()[i]->getPosition());
+
+    // Same multiset of rest lengths
+    std::multiset<long long> a, b;
+    for (auto c : plain->getConstraints()) a.insert(std::llround(c->getRestLength() * 1e6));
+    for (auto c : sorted->getConstraints()) b.insert(std::llround(c->getRestLength() * 1e6));
+    EXPECT_EQ(a, b);
+
+    // Saving keeps the particle order
+    SoftBody* loaded = SoftBody::from_json(sorted->as_json());
+    for (size_t i = 0; i < sorted->getParticles().size(); i++)
+        EXPECT_EQ(loaded->getParticles()[i]->getPosition(), sorted->getParticles()[i]->getPosition());
+
+    for (auto* body : { plain, sorted, loaded }) {
+        for (auto p: body->getParticles()) delete p;
+        for (auto c: body->getConstraints()) delete c;
+        delete body;
+    }
+}
+
+TEST(SoftBodyFactoryTest, SurfaceIsTheOrderedOutline) {
+    std::vector<Vector2> shape = { Vector2(0, 0), Vector2(40, 0), Vector2(40, 30), Vector2(0, 30) };
+    for (auto type : { sim::RingMesh, sim::LatticeMesh }) {
+        SoftBody* body = SoftBody::createFromPolygon(shape, 4, 1.0, 1.0, 0.8, 0.1, 0.1, 0.9, false, type);
+        const auto& surface = body->getSurface();
+
+        // One particle per radius along the perimeter
+        EXPECT_EQ(surface.size(), 140u);
+        EXPECT_LT(surface.size(), body->getParticles().size());
+        std::set<Particle*> unique(surface.begin(), surface.end());
+        EXPECT_EQ(unique.size(), surface.size());
+        for (auto corner : body->getBorder()) EXPECT_TRUE(unique.count(corner));
+
+        // Consecutive particles are neighbours on the outline, the ring closes
+        for (size_t i = 0; i < surface.size(); i++) {
+            Vector2 a = surface[i]->getPosition();
+            Vector2 b = surface[(i + 1) % surface.size()]->getPosition();
+            EXPECT_NEAR((a - b).length(), 1.0, 1e-9);
+            EXPECT_TRUE(a.x == 0 || a.x == 40 || a.y == 0 || a.y == 30);
+        }
+        EXPECT_TRUE(body->surfaceEncloses());
+
+        for (auto p : body->getParticles()) delete p;
+        for (auto c : body->getConstraints()) delete c;
+        delete body;
+    }
+}
+
+TEST(SoftBodyTest, SurfaceOfAHandBuiltBodyIsEveryParticle) {
+    std::vector<Particle*> particles = { new Particle(Vector2(0, 0)), new Particle(Vector2(3, 0)) };
+    SoftBody body(particles);
+    EXPECT_EQ(body.getSurface(), particles);
+    EXPECT_TRUE(body.surfaceEncloses());
+    for (auto p : particles) delete p;
+}
+
+TEST(SoftBodyTest, FoldedBodyNoLongerEnclosesItsParticles) {
+    std::vector<Vector2> shape = { Vector2(0, 0), Vector2(20, 0), Vector2(20, 20), Vector2(0, 20) };
+    SoftBody* body = SoftBody::createFromPolygon(shape, 4, 1.0, 1.0);
+    std::set<Particle*> surface(body->getSurface().begin(), body->getSurface().end());
+    for (auto p : body->getParticles()) {
+        if (surface.count(p)) continue;
+        p->setPosition(Vector2(10, -5)); // Pushed out through the bottom edge
+        break;
+    }
+    EXPECT_FALSE(body->surfaceEncloses());
+
+    for (auto p : body->getParticles()) delete p;
+    for (auto c : body->getConstraints()) delete c;
+    delete body;
+}
+
+TEST(SoftBodyTest, FoldIntoTheNotchOfAConcaveBodyIsDetected) {
+    // L shape: the notch [10,20]x[10,20] is within the bounds of the surface
+    std::vector<Vector2> shape = {
+        Vector2(0, 0), Vector2(20, 0), Vector2(20, 10),
+        Vector2(10, 10), Vector2(10, 20), Vector2(0, 20)
+    };
+    SoftBody* body = SoftBody::createFromPolygon(shape, 2, 1.0, 1.0);
+    ASSERT_TRUE(body->hasOutline());
+    EXPECT_TRUE(body->surfaceEncloses());
+
+    std::set<Particle*> surface(body->getSurface().begin(), body->getSurface().end());
+    for (auto p : body->getParticles()) {
+        if (surface.count(p)) continue;
+        p->setPosition(Vector2(15, 15)); // Folded over the inner corner
+        break;
+    }
+    EXPECT_FALSE(body->surfaceEncloses());
+
+    for (auto p : body->getParticles()) delete p;
+    for (auto c : body->getConstraints()) delete c;
+    delete body;
+}
+
+TEST(SoftBodyTest, CollisionLayersFilterPairsBothWays) {
+    SoftBody a({ new Particle(Vector2(0, 0)) });
+    SoftBody b({ new Particle(Vector2(0, 0)) });
+    EXPECT_EQ(a.getCollisionLayer(), 1u);
+    EXPECT_EQ(a.getCollisionMask(), 1u);
+    EXPECT_TRUE(a.collidesWith(&b));
+
+    // Debris on its own layer, colliding with nothing
+    b.setCollisionLayer(2);
+    b.setCollisionMask(0);
+    EXPECT_FALSE(a.collidesWith(&b));
+    EXPECT_FALSE(b.collidesWith(&a));
+
+    // Each one has to be in the other's mask
+    b.setCollisionMask(1);
+    EXPECT_FALSE(a.collidesWith(&b));
+    a.setCollisionMask(1 | 2);
+    EXPECT_TRUE(a.collidesWith(&b));
+    EXPECT_TRUE(b.collidesWith(&a));
+
+    for (auto p : a.getParticles()) delete p;
+    for (auto p : b.getParticles()) delete p;
+}
+
+TEST(SoftBodyTest, CollisionLayersAreSerialized) {
+    SoftBody* meshed = SoftBody::createFromPolygon({ Vector2(0, 0), Vector2(10, 0), Vector2(10, 10), Vector2(0, 10) });
+    SoftBody* hand = new SoftBody({ new Particle(Vector2(0, 0)) });
+    for (SoftBody* body : { meshed, hand }) {
+        body->setCollisionLayer(4);
+        body->setCollisionMask(5);
+        SoftBody* loaded = SoftBody::from_json(body->as_json());
+        EXPECT_EQ(loaded->getCollisionLayer(), 4u);
+        EXPECT_EQ(loaded->getCollisionMask(), 5u);
+        for (auto p : loaded->getParticles()) delete p;
+        for (auto c : loaded->getConstraints()) delete c;
+        delete loaded;
+        for (auto p : body->getParticles()) delete p;
+        for (auto c : body->getConstraints()) delete c;
+        delete body;
+    }
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "Simulation.h"
+#include "SoftBody.h"
+#include "SoftBodyPrototype.h"
+
+using sim::Simulation;
+using sim::SoftBody;
+using sim::SoftBodyPrototype;
+using sim::Vector2;
+
+static std::vector<Vector2> square(double side) {
+    return { Vector2(0, 0), Vector2(side, 0), Vector2(side, side), Vector2(0, side) };
+}
+
+TEST(SoftBodyPrototypeTest, MatchesTheMeshOfCreateFromPolygon) {
+    auto proto = SoftBodyPrototype::createFromPolygon(square(50), 10, 2, 1, 0.5, 0.2);
+    SoftBody* body = SoftBody::createFromPolygon(square(50), 10, 2, 1, 0.5, 0.2);
+
+    ASSERT_EQ(proto->getRestPositions().size(), body->getParticles().size());
+    ASSERT_EQ(proto->getEdges().size(), body->getConstraints().size());
+    ASSERT_EQ(proto->getRestLengths().size(), proto->getEdges().size());
+    for (size_t i = 0; i < proto->getEdges().size(); i++)
+        EXPECT_DOUBLE_EQ(proto->getRestLengths()[i], body->getConstraints()[i]->getRestLength());
+    EXPECT_EQ(proto->getBorder().size(), 4u);
+    EXPECT_EQ(proto->getSurface().size(), body->getSurface().size());
+
+    for (auto p : body->getParticles()) delete p;
+    for (auto c : body->getConstraints()) delete c;
+    delete body;
+}
+
+TEST(SoftBodyPrototypeTest, InstancePlacesParticlesWithItsTransform) {
+    auto proto = SoftBodyPrototype::createFromPolygon(square(50), 10, 2);
+    Simulation sim;
+    SoftBody* body = SoftBody::instantiate(proto, Vector2(100, 20), M_PI / 2);
+    sim.addBody(body);
+
+    EXPECT_EQ(body->getPrototype(), proto);
+    EXPECT_TRUE(body->getConstraints().empty());
+    ASSERT_EQ(body->getParticles().size(), proto->getRestPositions().size());
+    for (size_t i = 0; i < proto->getRestPositions().size(); i++) {
+        Vector2 rest = proto->getRestPositions()[i];
+        EXPECT_EQ(body->getParticles()[i]->getPosition(), Vector2(100 - rest.y, 20 + rest.x));
+        EXPECT_DOUBLE_EQ(body->getParticles()[i]->getMass(), 2);
+    }
+    // The border follows the prototype corners
+    EXPECT_EQ(body->getBorder()[1]->getPosition(), Vector2(100, 70));
+}
+
+TEST(SoftBodyPrototypeTest, InstanceStepsLikeAnOwnedBody) {
+    auto poly = square(50);
+    auto proto = SoftBodyPrototype::createFromPolygon(poly, 10);
+
+    Simulation owned, instanced;
+    owned.setGravity(Vector2(0, -10));
+    instanced.setGravity(Vector2(0, -10));
+    owned.addBody(SoftBody::createFromPolygon(poly, 10));
+    instanced.addBody(SoftBody::instantiate(proto));
+
+    // Squash both bodies the same way, then let the constraints restore them
+    for (auto* s : { &owned, &instanced })
+        for (auto p : s->getBodies()[0]->getParticles())
+            p->setPosition(Vector2(p->getPosition().x * 1.2, p->getPosition().y * 0.8));
+    for (int i = 0; i < 20; i++) {
+        owned.step(0.01);
+        instanced.step(0.01);
+    }
+
+    auto a = owned.getBodies()[0]->getParticles();
+    auto b = instanced.getBodies()[0]->getParticles();
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); i++) {
+        EXPECT_NEAR(a[i]->getPosition().x, b[i]->getPosition().x, 1e-9);
+        EXPECT_NEAR(a[i]->getPosition().y, b[i]->getPosition().y, 1e-9);
+    }
+}
+
+TEST(SoftBodyPrototypeTest, SaveSharesThePrototypeBetweenInstances) {
+    auto proto = SoftBodyPrototype::createFromPolygon(square(30), 10);
+    Simulation sim;
+    for (int i = 0; i < 3; i++)
+        sim.addBody(SoftBody::instantiate(proto, Vector2(40.0 * i, 0)));
+    sim.addBody(SoftBody::createFromPolygon(square(30), 10));
+
+    json data = sim.as_json();
+    ASSERT_EQ(data["prototypes"].size(), 1u);
+    EXPECT_EQ(data["bodies"][2]["prototype"], 0);
+
+    Simulation loaded;
+    loaded.from_json(data);
+    ASSERT_EQ(loaded.getBodies().size(), 4u);
+    EXPECT_EQ(loaded.getBodies()[0]->getPrototype(), loaded.getBodies()[2]->getPrototype());
+    EXPECT_EQ(loaded.getBodies()[3]->getPrototype(), nullptr);
+    EXPECT_EQ(loaded.getBodies()[2]->getBorder()[0]->getPosition(), Vector2(80, 0));
+
+    // A body saved on its own carries its prototype inline
+    SoftBody* single = SoftBody::from_json(sim.getBodies()[1]->as_json());
+    EXPECT_EQ(single->getParticles().size(), proto->getRestPositions().size());
+    EXPECT_EQ(single->getTranslation(), Vector2(40, 0));
+    for (auto p : single->getParticles()) delete p;
+    delete single;
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <set>
+#include <utility>
+
+#include "SphereTree.h"
+
+using sim::Particle;
+using sim::SphereTree;
+using sim::Vector2;
+
+// L-shaped cloud of particles at unit spacing, its bounding box is mostly empty
+static std::vector<std::unique_ptr<Particle>> lShape(Vector2 origin, int arm) {
+    std::vector<std::unique_ptr<Particle>> out;
+    for (int i = 0; i < arm; i++)
+        out.push_back(std::make_unique<Particle>(origin + Vector2(i, 0), 1.0, 0.5));
+    for (int i = 1; i < arm; i++)
+        out.push_back(std::make_unique<Particle>(origin + Vector2(0, i), 1.0, 0.5));
+    return out;
+}
+
+static std::vector<Particle*> pointers(const std::vector<std::unique_ptr<Particle>>& particles) {
+    std::vector<Particle*> out;
+    for (auto& p : particles) out.push_back(p.get());
+    return out;
+}
+
+static bool touching(const Particle* a, const Particle* b) {
+    double r = a->getRadius() + b->getRadius();
+    return (a->getPosition() - b->getPosition()).lengthSquared() < r * r;
+}
+
+static void expectEncloses(const SphereTree& tree, const std::vector<Particle*>& particles) {
+    for (auto p : particles)
+        EXPECT_LE((p->getPosition() - tree.getCenter()).length() + p->getRadius(), tree.getRadius() + 1e-9);
+}
+
+TEST(SphereTreeTest, RootEnclosesEveryParticle) {
+    auto particles = lShape(Vector2(0, 0), 40);
+    auto list = pointers(particles);
+    SphereTree tree;
+    tree.build(list);
+    EXPECT_EQ(tree.getParticles(), &list);
+    EXPECT_GT(tree.getNodeCount(), 1u);
+    expectEncloses(tree, list);
+
+    particles[10]->setPosition(Vector2(100, 50));
+    tree.refit();
+    expectEncloses(tree, list);
+}
+
+TEST(SphereTreeTest, PairsCoverEveryTouchingPair) {
+    auto pa = lShape(Vector2(0, 0), 30);
+    auto pb = lShape(Vector2(0.7, 0.6), 30);
+    auto la = pointers(pa), lb = pointers(pb);
+    SphereTree a, b;
+    a.build(la);
+    b.build(lb);
+
+    std::set<std::pair<int,int>> visited;
+    SphereTree::forEachPair(a, b, [&](int i, int j) { visited.insert({ i, j }); });
+    size_t touching_pairs = 0;
+    for (int i = 0; i < (int)la.size(); i++)
+        for (int j = 0; j < (int)lb.size(); j++)
+            if (touching(la[i], lb[j])) {
+                touching_pairs++;
+                EXPECT_TRUE(visited.count({ i, j }));
+            }
+    EXPECT_GT(touching_pairs, 0u);
+    EXPECT_LT(visited.size(), la.size() * lb.size() / 4);
+}
+
+TEST(SphereTreeTest, SkipsOverlappingBoxesOfApartBodies) {
+    // The second L sits in the empty corner of the first: the boxes overlap, no particle touches
+    auto pa = lShape(Vector2(0, 0), 30);
+    auto pb = lShape(Vector2(10, 10), 10);
+    auto la = pointers(pa), lb = pointers(pb);
+    SphereTree a, b;
+    a.build(la);
+    b.build(lb);
+
+    size_t visits = 0;
+    size_t leaf_pairs = SphereTree::forEachPair(a, b, [&](int, int) { visits++; });
+    EXPECT_LT(leaf_pairs, 8u);
+    EXPECT_EQ(visits, 0u);
+
+    SphereTree empty;
+    std::vector<Particle*> none;
+    empty.build(none);
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(SphereTree::forEachPair(a, empty, [&](int, int) { visits++; }), 0u);
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <vector>
+
+#include "ThreadPool.h"
+
+using sim::ThreadPool;
+
+TEST(ThreadPoolTest, EveryItemRunsOnce) {
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.size(), 4);
+
+    std::vector<std::atomic<int>> hits(10007);
+    pool.parallelFor(hits.size(), 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) hits[i]++;
+    });
+    for (auto& h : hits) EXPECT_EQ(h.load(), 1);
+}
+
+TEST(ThreadPoolTest, ChunksDoNotDependOnThePoolSize) {
+    for (int threads : { 1, 2, 5 }) {
+        ThreadPool pool(threads);
+        std::vector<std::pair<size_t, size_t>> chunks(8);
+        pool.parallelFor(30, 4, [&](size_t begin, size_t end) { chunks[begin / 4] = { begin, end }; });
+        for (size_t c = 0; c < chunks.size(); c++) {
+            EXPECT_EQ(chunks[c].first, c * 4);
+            EXPECT_EQ(chunks[c].second, std::min<size_t>(c * 4 + 4, 30));
+        }
+    }
+}
+
+TEST(ThreadPoolTest, RunsManyJobsInARow) {
+    ThreadPool pool(3);
+    std::atomic<long> sum{0};
+    for (int job = 0; job < 500; job++) {
+        pool.parallelFor(64, 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) sum += (long)i;
+        });
+    }
+    EXPECT_EQ(sum.load(), 500L * (63 * 64 / 2));
+}
+
+TEST(ThreadPoolTest, EmptyRangeDoesNothing) {
+    ThreadPool pool(2);
+    bool called = false;
+    pool.parallelFor(0, 8, [&](size_t, size_t) { called = true; });
+    EXPECT_FALSE(called);
+}
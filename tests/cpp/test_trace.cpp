@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+#include <thread>
+
+#include "Trace.h"
+#include "Simulation.h"
+
+using sim::TraceRecorder;
+using sim::TraceScope;
+using sim::Simulation;
+using sim::SoftBody;
+using sim::Particle;
+using sim::Vector2;
+
+// --------------------------------------------------
+// Helpers
+// --------------------------------------------------
+
+static std::set<std::string> eventNames(const json& trace) {
+    std::set<std::string> names;
+    for (auto& e : trace["traceEvents"])
+        if (e["ph"] == "X") names.insert(e["name"].get<std::string>());
+    return names;
+}
+
+// --------------------------------------------------
+// Recording
+// --------------------------------------------------
+
+TEST(TraceRecorderTest, DisabledRecorderRecordsNothing) {
+    TraceRecorder& rec = TraceRecorder::instance();
+    rec.disable();
+    rec.clear();
+
+    { TraceScope scope("ignored", "test"); }
+
+    EXPECT_EQ(rec.eventCount(), 0);
+}
+
+TEST(TraceRecorderTest, ScopeProducesCompleteEvent) {
+    TraceRecorder& rec = TraceRecorder::instance();
+    rec.clear();
+    rec.enable();
+
+    { TraceScope scope("work", "test"); }
+    rec.disable();
+
+    json trace = rec.as_json();
+    ASSERT_EQ(rec.eventCount(), 1);
+    bool found = false;
+    for (auto& e : trace["traceEvents"]) {
+        if (e["ph"] != "X") continue;
+        EXPECT_EQ(e["name"], "work");
+        EXPECT_EQ(e["cat"], "test");
+        EXPECT_GE(e["dur"].get<double>(), 0.0);
+        found = true;
+    }
+    EXPECT_TRUE(found);
+}
+
+TEST(TraceRecorderTest, ThreadsUseSeparateTracks) {
+    TraceRecorder& rec = TraceRecorder::instance();
+    rec.clear();
+    rec.enable();
+
+    { TraceScope scope("main", "test"); }
+    std::thread worker([] { TraceScope scope("worker", "test"); });
+    worker.join();
+    rec.disable();
+
+    json trace = rec.as_json();
+    std::set<int> tids;
+    for (auto& e : trace["traceEvents"])
+        if (e["ph"] == "X") tids.insert(e["tid"].get<int>());
+    EXPECT_EQ(tids.size(), 2);
+}
+
+static std::string trackName(const json& trace, int tid) {
+    for (auto& e : trace["traceEvents"])
+        if (e["ph"] == "M" && e["tid"] == tid) return e["args"]["name"].get<std::string>();
+    return "";
+}
+
+TEST(TraceRecorderTest, TracksAreNamedByThread) {
+    TraceRecorder& rec = TraceRecorder::instance();
+    rec.clear();
+    rec.enable();
+
+    // Recording first does not make a thread the main one
+    std::thread first([] { TraceScope scope("first", "test"); });
+    first.join();
+    std::thread named([] {
+        TraceRecorder::instance().setThreadName("named");
+        TraceScope scope("named", "test");
+    });
+    named.join();
+    { TraceScope scope("main", "test"); }
+    rec.disable();
+
+    json trace = rec.as_json();
+    for (auto& e : trace["traceEvents"]) {
+        if (e["ph"] != "X") continue;
+        std::string track = trackName(trace, e["tid"].get<int>());
+        if (e["name"] == "main") EXPECT_EQ(track, "main");
+        else EXPECT_NE(track, "main");
+    }
+}
+
+TEST(TraceRecorderTest, ExitedThreadsHandTheirBufferOver) {
+    TraceRecorder& rec = TraceRecorder::instance();
+    rec.clear();
+    rec.enable();
+
+    for (int i = 0; i < 10; i++) {
+        std::thread worker([] { TraceScope scope("short", "test"); });
+        worker.join();
+    }
+    rec.disable();
+
+    json trace = rec.as_json();
+    std::set<int> tids;
+    for (auto& e : trace["traceEvents"])
+        if (e["ph"] == "X") tids.insert(e["tid"].get<int>());
+    EXPECT_EQ(rec.eventCount(), 10);
+    EXPECT_EQ(tids.size(), 1u); // The events of exited threads are kept
+}
+
+// --------------------------------------------------
+// Simulation phases
+// --------------------------------------------------
+
+TEST(TraceRecorderTest, SimulationStepEmitsPhases) {
+    Simulation sim;
+    sim.addBody(new SoftBody({ new Particle(Vector2(0, 0)) }));
+
+    TraceRecorder& rec = TraceRecorder::instance();
+    rec.clear();
+    rec.enable();
+    sim.step(0.01);
+    rec.disable();
+
+    auto names = eventNames(rec.as_json());
+    EXPECT_TRUE(names.count("step"));
+    EXPECT_TRUE(names.count("gravity"));
+    EXPECT_TRUE(names.count("constraints"));
+    EXPECT_TRUE(names.count("collisions_world"));
+    EXPECT_TRUE(names.count("collisions_bodies"));
+    EXPECT_TRUE(names.count("integration"));
+}
+
+TEST(TraceRecorderTest, ContactPipelineTracesStagesAndChunks) {
+    Simulation sim;
+    sim.setContactPipeline(true);
+    sim.setThreadCount(4);
+    // Overlapping squares, every neighbour pair in contact
+    for (int k = 0; k < 8; k++) {
+        Vector2 o(k * 8, 0);
+        sim.addBody(SoftBody::createFromPolygon({ o, o + Vector2(10, 0), o + Vector2(10, 10), o + Vector2(0, 10) }, 2));
+    }
+
+    TraceRecorder& rec = TraceRecorder::instance();
+    rec.clear();
+    rec.enable();
+    sim.step(0.01);
+    rec.disable();
+
+    auto names = eventNames(rec.as_json());
+    EXPECT_TRUE(names.count("contactDetect"));
+    EXPECT_TRUE(names.count("contactColor"));
+    EXPECT_TRUE(names.count("contactResolve"));
+    EXPECT_TRUE(names.count("ThreadPool::chunk"));
+}
+
+TEST(TraceRecorderTest, MeshGenerationIsTraced) {
+    TraceRecorder& rec = TraceRecorder::instance();
+    rec.clear();
+    rec.enable();
+    SoftBody* body = SoftBody::createFromPolygon({ Vector2(0, 0), Vector2(10, 0), Vector2(10, 10), Vector2(0, 10) }, 5);
+    rec.disable();
+
+    EXPECT_TRUE(eventNames(rec.as_json()).count("createFromPolygon"));
+
+    for (auto p: body->getParticles()) delete p;
+    for (auto c: body->getConstraints()) delete c;
+    delete body;
+}
@@ -127,3 +127,197 @@ TEST(OuterCircleColliderTest, PinnedParticleIgnored) {
     EXPECT_FALSE(collided);
     EXPECT_EQ(p.getPosition(), Vector2(4, 0));
 }
+
+// --------------------------------------------------
+// Culling bounds (mayCollide)
+// --------------------------------------------------
+
+TEST(PlaneColliderTest, MayCollideOnlyWhenBoxReachesThePlane) {
+    PlaneCollider floor(Vector2(0, 1), 0.0);
+    EXPECT_FALSE(floor.mayCollide({ Vector2(-5, 1), Vector2(5, 10) }));
+    EXPECT_TRUE(floor.mayCollide({ Vector2(-5, -0.5), Vector2(5, 10) }));
+
+    // Tilted plane: the lowest corner along the normal decides
+    PlaneCollider tilted(Vector2(1, 1), 0.0);
+    EXPECT_FALSE(tilted.mayCollide({ Vector2(1, 1), Vector2(3, 3) }));
+    EXPECT_TRUE(tilted.mayCollide({ Vector2(-2, 1), Vector2(3, 3) }));
+}
+
+TEST(InnerCircleColliderTest, MayCollideOnlyNearTheRing) {
+    InnerCircleCollider arena(Vector2(0, 0), 10.0);
+    EXPECT_FALSE(arena.mayCollide({ Vector2(-3, -3), Vector2(3, 3) }));
+    EXPECT_TRUE(arena.mayCollide({ Vector2(5, 5), Vector2(8, 8) }));
+}
+
+TEST(OuterCircleColliderTest, MayCollideOnlyNearTheDisc) {
+    OuterCircleCollider rock(Vector2(0, 0), 5.0);
+    EXPECT_FALSE(rock.mayCollide({ Vector2(6, -1), Vector2(10, 1) }));
+    EXPECT_FALSE(rock.mayCollide({ Vector2(4, 4), Vector2(6, 6) }));
+    EXPECT_TRUE(rock.mayCollide({ Vector2(3, 3), Vector2(6, 6) }));
+    EXPECT_TRUE(rock.mayCollide({ Vector2(-10, -10), Vector2(10, 10) }));
+}
+
+TEST(OuterCircleColliderTest, MayCollideIsConservative) {
+    // Every particle that collides must lie in a box accepted by mayCollide
+    OuterCircleCollider rock(Vector2(0, 0), 5.0);
+    InnerCircleCollider arena(Vector2(0, 0), 5.0);
+    PlaneCollider floor(Vector2(0.6, 0.8), 1.0);
+    for (int i = 0; i < 41 * 41; i++) {
+        Vector2 pos(-8 + 0.4 * (i % 41), -8 + 0.4 * (i / 41));
+        for (sim::WorldCollider* c : std::initializer_list<sim::WorldCollider*>{ &rock, &arena, &floor }) {
+            Particle p(pos, 1.0, 1.0);
+            sim::AABB box = sim::computeAABB({ &p });
+            if (c->collide(&p, 0.5, 0.5)) {
+                EXPECT_TRUE(c->mayCollide(box)) << pos;
+            }
+        }
+    }
+}
+
+// --------------------------------------------------
+// Batch kernels (collideBatch)
+// --------------------------------------------------
+
+// Runs a collider on a grid of particles, once per particle and once as a batch
+template <typename C>
+static void expectBatchMatchesScalar(C& collider) {
+    std::vector<Particle> scalar, batched;
+    for (int i = 0; i < 21 * 21; i++) {
+        Vector2 pos(-10 + (i % 21), -10 + (i / 21));
+        Particle p(pos, 1.0, 0.5 + 0.1 * (i % 7), i % 13 == 0);
+        p.setPrevPosition(pos + Vector2(0.3, 0.7));
+        scalar.push_back(p);
+        batched.push_back(p);
+    }
+    std::vector<Particle*> ptrs;
+    for (auto& p : batched) ptrs.push_back(&p);
+
+    for (auto& p : scalar) collider.collide(&p, 0.4, 0.6);
+    sim::ParticleBatch batch;
+    batch.gather(ptrs);
+    collider.collideBatch(batch, 0.4, 0.6);
+
+    for (size_t i = 0; i < scalar.size(); i++) {
+        EXPECT_EQ(batched[i].getPosition(), scalar[i].getPosition());
+        EXPECT_EQ(batched[i].getPrevPosition(), scalar[i].getPrevPosition());
+        EXPECT_EQ(batch.x[i], batched[i].getPosition().x);
+        EXPECT_EQ(batch.y[i], batched[i].getPosition().y);
+    }
+}
+
+TEST(PlaneColliderTest, BatchMatchesScalar) {
+    PlaneCollider plane(Vector2(0.3, 1), -2.0, 0.2, 0.8);
+    expectBatchMatchesScalar(plane);
+}
+
+TEST(InnerCircleColliderTest, BatchMatchesScalar) {
+    InnerCircleCollider arena(Vector2(0, 0), 6.0, 0.2, 0.8);
+    expectBatchMatchesScalar(arena);
+}
+
+TEST(OuterCircleColliderTest, BatchMatchesScalar) {
+    OuterCircleCollider rock(Vector2(0, 0), 4.0, 0.2, 0.8);
+    expectBatchMatchesScalar(rock);
+}
+
+// --------------------------------------------------
+// Swept collisions
+// --------------------------------------------------
+
+TEST(PlaneColliderTest, SweptRespondsAtTheContactPoint) {
+    PlaneCollider plane(Vector2(0, 1), 0.0, 0.0, 1.0);
+    Particle p(Vector2(10, -5), 1.0, 1.0);
+    p.setPrevPosition(Vector2(0, 5));
+
+    EXPECT_TRUE(plane.collideSwept(&p, 0.0, 1.0));
+    EXPECT_NEAR(p.getPosition().x, 4.0, 1e-9);
+    EXPECT_NEAR(p.getPosition().y, 1.0, 1e-9);
+    // Elastic and frictionless: the normal velocity is reflected
+    Vector2 vel = p.getPosition() - p.getPrevPosition();
+    EXPECT_NEAR(vel.x, 10.0, 1e-9);
+    EXPECT_NEAR(vel.y, 10.0, 1e-9);
+}
+
+TEST(PlaneColliderTest, SweptFallsBackWhenAlreadyTouching) {
+    PlaneCollider a(Vector2(0, 1), 0.0), b(Vector2(0, 1), 0.0);
+    Particle p(Vector2(1, 0.2), 1.0, 1.0), q(Vector2(1, 0.2), 1.0, 1.0);
+    p.setPrevPosition(Vector2(0, 0.5));
+    q.setPrevPosition(Vector2(0, 0.5));
+
+    EXPECT_TRUE(a.collideSwept(&p, 0.5, 0.5));
+    EXPECT_TRUE(b.collide(&q, 0.5, 0.5));
+    EXPECT_EQ(p.getPosition(), q.getPosition());
+    EXPECT_EQ(p.getPrevPosition(), q.getPrevPosition());
+}
+
+TEST(InnerCircleColliderTest, SweptStopsAtTheWall) {
+    InnerCircleCollider circle(Vector2(0, 0), 10.0);
+    Particle p(Vector2(20, 0), 1.0, 1.0);
+    p.setPrevPosition(Vector2(0, 0));
+
+    EXPECT_TRUE(circle.collideSwept(&p, 0.5, 0.5));
+    EXPECT_NEAR(p.getPosition().x, 9.0, 1e-9);
+    EXPECT_NEAR(p.getPosition().y, 0.0, 1e-9);
+}
+
+TEST(OuterCircleColliderTest, SweptCatchesTunnelling) {
+    OuterCircleCollider circle(Vector2(0, 0), 1.0);
+    Particle p(Vector2(10, 0.2), 1.0, 0.5);
+    p.setPrevPosition(Vector2(-10, 0.2));
+
+    // The static test misses the obstacle entirely
+    Particle q = p;
+    EXPECT_FALSE(circle.collide(&q, 0.5, 0.5));
+
+    EXPECT_TRUE(circle.collideSwept(&p, 0.5, 0.5));
+    EXPECT_LT(p.getPosition().x, 0.0);
+    EXPECT_NEAR((p.getPosition() - Vector2(0, 0)).length(), 1.5, 1e-9);
+
+    // Moving away never hits
+    Particle r(Vector2(-10, 0), 1.0, 0.5);
+    r.setPrevPosition(Vector2(-3, 0));
+    EXPECT_FALSE(circle.collideSwept(&r, 0.5, 0.5));
+}
+
+// --- Clearance ----
+
+TEST(WorldColliderTest, ClearanceBoundsTheCollisions) {
+    PlaneCollider plane(Vector2(0, 1), 0.0);
+    InnerCircleCollider inner(Vector2(0, 0), 10.0);
+    OuterCircleCollider outer(Vector2(3, 3), 2.0);
+    std::vector<sim::WorldCollider*> colliders = { &plane, &inner, &outer };
+
+    for (auto collider : colliders) {
+        for (int i = 0; i < 400; i++) {
+            Vector2 pos(-12 + (i % 20) * 1.23, -3 + (i / 20) * 0.71);
+            double c = collider->clearance(pos);
+            Particle p(pos, 1.0, 0.5);
+            bool collided = collider->collide(&p, 0.1, 0.9);
+            if (c > 0.5) {
+                EXPECT_FALSE(collided);
+            }
+            if (collided) {
+                EXPECT_LT(c, 0.5);
+            }
+        }
+    }
+    // A particle at the center of an inner circle is moved, its clearance is 0
+    EXPECT_EQ(inner.clearance(Vector2(0, 0)), 0.0);
+    EXPECT_NEAR(outer.clearance(Vector2(3, 8)), 3.0, 1e-12);
+}
+
+TEST(WorldColliderTest, CollisionMaskIsSerialized) {
+    PlaneCollider plane(Vector2(0, 1), 0.0);
+    EXPECT_EQ(plane.getCollisionMask(), 0xFFFFFFFFu);
+    plane.setCollisionMask(6);
+    sim::WorldCollider* loaded = sim::WorldCollider::from_json(plane.as_json());
+    EXPECT_EQ(loaded->getCollisionMask(), 6u);
+    delete loaded;
+
+    // Scenes saved before the masks act on every layer
+    json data = OuterCircleCollider(Vector2(0, 0), 1.0).as_json();
+    data.erase("collision_mask");
+    loaded = sim::WorldCollider::from_json(data);
+    EXPECT_EQ(loaded->getCollisionMask(), 0xFFFFFFFFu);
+    delete loaded;
+}